@@ -0,0 +1,251 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <algorithm>
+#include "Archive.h"
+#include "Utils.h"
+#include "stb_image.h"
+
+namespace ouzel
+{
+    static const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034B50;
+    static const uint32_t CENTRAL_DIRECTORY_SIGNATURE = 0x02014B50;
+    static const uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054B50;
+    
+    static const uint32_t LOCAL_HEADER_SIZE = 30;
+    static const uint32_t CENTRAL_DIRECTORY_HEADER_SIZE = 46;
+    static const uint32_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+    // the end record is followed by a comment of at most 65535 bytes
+    static const uint32_t MAX_END_SEARCH_SIZE = END_OF_CENTRAL_DIRECTORY_SIZE + 65535;
+    
+    static const uint16_t METHOD_STORED = 0;
+    static const uint16_t METHOD_DEFLATED = 8;
+    // deflate can't compress more than about 1032:1, so larger sizes in the directory are corrupt
+    static const uint64_t MAX_DEFLATE_RATIO = 1032;
+    
+    static uint16_t readUInt16(const uint8_t* data)
+    {
+        return static_cast<uint16_t>(data[0] | (data[1] << 8));
+    }
+    
+    static uint32_t readUInt32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+            (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+    
+    Archive::Archive()
+    {
+        
+    }
+    
+    Archive::~Archive()
+    {
+        if (_file)
+        {
+            fclose(_file);
+        }
+    }
+    
+    bool Archive::init(const std::string& path)
+    {
+        _path = path;
+        _file = fopen(path.c_str(), "rb");
+        
+        if (!_file)
+        {
+            log("Failed to open archive %s", path.c_str());
+            return false;
+        }
+        
+        fseek(_file, 0, SEEK_END);
+        long fileSize = ftell(_file);
+        
+        if (fileSize < static_cast<long>(END_OF_CENTRAL_DIRECTORY_SIZE))
+        {
+            log("Invalid archive %s", path.c_str());
+            return false;
+        }
+        
+        uint32_t searchSize = static_cast<uint32_t>(std::min(fileSize, static_cast<long>(MAX_END_SEARCH_SIZE)));
+        std::vector<uint8_t> tail(searchSize);
+        
+        fseek(_file, fileSize - searchSize, SEEK_SET);
+        
+        if (fread(tail.data(), 1, searchSize, _file) != searchSize)
+        {
+            log("Failed to read archive %s", path.c_str());
+            return false;
+        }
+        
+        // the end record is searched backwards, because the comment after it can contain anything
+        const uint8_t* end = nullptr;
+        
+        for (uint32_t i = searchSize - END_OF_CENTRAL_DIRECTORY_SIZE + 1; i > 0; --i)
+        {
+            if (readUInt32(&tail[i - 1]) == END_OF_CENTRAL_DIRECTORY_SIGNATURE)
+            {
+                end = &tail[i - 1];
+                break;
+            }
+        }
+        
+        if (!end)
+        {
+            log("Invalid archive %s", path.c_str());
+            return false;
+        }
+        
+        uint16_t entryCount = readUInt16(end + 10);
+        uint32_t directorySize = readUInt32(end + 12);
+        uint32_t directoryOffset = readUInt32(end + 16);
+        
+        if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF)
+        {
+            log("ZIP64 archive %s is not supported", path.c_str());
+            return false;
+        }
+        
+        if (static_cast<long>(directoryOffset) + static_cast<long>(directorySize) > fileSize)
+        {
+            log("Invalid archive %s", path.c_str());
+            return false;
+        }
+        
+        std::vector<uint8_t> directory(directorySize);
+        
+        fseek(_file, directoryOffset, SEEK_SET);
+        
+        if (fread(directory.data(), 1, directorySize, _file) != directorySize)
+        {
+            log("Failed to read archive %s", path.c_str());
+            return false;
+        }
+        
+        uint32_t offset = 0;
+        
+        for (uint16_t i = 0; i < entryCount; ++i)
+        {
+            if (offset + CENTRAL_DIRECTORY_HEADER_SIZE > directorySize ||
+                readUInt32(&directory[offset]) != CENTRAL_DIRECTORY_SIGNATURE)
+            {
+                log("Invalid central directory in archive %s", path.c_str());
+                return false;
+            }
+            
+            const uint8_t* header = &directory[offset];
+            
+            uint16_t nameLength = readUInt16(header + 28);
+            uint16_t extraLength = readUInt16(header + 30);
+            uint16_t commentLength = readUInt16(header + 32);
+            
+            if (offset + CENTRAL_DIRECTORY_HEADER_SIZE + nameLength > directorySize)
+            {
+                log("Invalid central directory in archive %s", path.c_str());
+                return false;
+            }
+            
+            std::string name(reinterpret_cast<const char*>(header + CENTRAL_DIRECTORY_HEADER_SIZE), nameLength);
+            
+            Entry entry;
+            entry.method = readUInt16(header + 10);
+            entry.compressedSize = readUInt32(header + 20);
+            entry.size = readUInt32(header + 24);
+            entry.localHeaderOffset = readUInt32(header + 42);
+            
+            // the sizes are checked before anything is allocated for them when the entry is read
+            if (static_cast<uint64_t>(entry.localHeaderOffset) + LOCAL_HEADER_SIZE + entry.compressedSize > static_cast<uint64_t>(fileSize) ||
+                (entry.method == METHOD_STORED && entry.size != entry.compressedSize) ||
+                static_cast<uint64_t>(entry.size) > static_cast<uint64_t>(entry.compressedSize) * MAX_DEFLATE_RATIO)
+            {
+                log("Invalid size of entry %s in archive %s", name.c_str(), path.c_str());
+                return false;
+            }
+            
+            // directories have no data
+            if (!name.empty() && name.back() != '/')
+            {
+                _entries[name] = entry;
+            }
+            
+            offset += CENTRAL_DIRECTORY_HEADER_SIZE + nameLength + extraLength + commentLength;
+        }
+        
+        return true;
+    }
+    
+    bool Archive::hasEntry(const std::string& name) const
+    {
+        return _entries.find(name) != _entries.end();
+    }
+    
+    bool Archive::readEntry(const std::string& name, std::vector<uint8_t>& data)
+    {
+        std::unordered_map<std::string, Entry>::const_iterator i = _entries.find(name);
+        
+        if (i == _entries.end())
+        {
+            return false;
+        }
+        
+        const Entry& entry = i->second;
+        
+        if (entry.method != METHOD_STORED && entry.method != METHOD_DEFLATED)
+        {
+            log("Unsupported compression method %u of %s in archive %s", entry.method, name.c_str(), _path.c_str());
+            return false;
+        }
+        
+        std::vector<uint8_t> compressed(entry.compressedSize);
+        
+        {
+            std::lock_guard<std::mutex> lock(_fileMutex);
+            
+            uint8_t localHeader[LOCAL_HEADER_SIZE];
+            
+            if (fseek(_file, entry.localHeaderOffset, SEEK_SET) != 0 ||
+                fread(localHeader, 1, LOCAL_HEADER_SIZE, _file) != LOCAL_HEADER_SIZE ||
+                readUInt32(localHeader) != LOCAL_HEADER_SIGNATURE)
+            {
+                log("Invalid entry %s in archive %s", name.c_str(), _path.c_str());
+                return false;
+            }
+            
+            // the local header can have a different extra field than the central directory
+            long dataOffset = static_cast<long>(entry.localHeaderOffset) + LOCAL_HEADER_SIZE +
+                readUInt16(localHeader + 26) + readUInt16(localHeader + 28);
+            
+            if (fseek(_file, dataOffset, SEEK_SET) != 0 ||
+                fread(compressed.data(), 1, entry.compressedSize, _file) != entry.compressedSize)
+            {
+                log("Failed to read entry %s in archive %s", name.c_str(), _path.c_str());
+                return false;
+            }
+        }
+        
+        if (entry.method == METHOD_STORED)
+        {
+            data = std::move(compressed);
+            return true;
+        }
+        
+        data.resize(entry.size);
+        
+        if (entry.size == 0)
+        {
+            return true;
+        }
+        
+        // zip entries are raw deflate streams without the zlib header
+        int size = stbi_zlib_decode_noheader_buffer(reinterpret_cast<char*>(data.data()), static_cast<int>(entry.size),
+                                                    reinterpret_cast<const char*>(compressed.data()), static_cast<int>(entry.compressedSize));
+        
+        if (size != static_cast<int>(entry.size))
+        {
+            log("Failed to decompress entry %s in archive %s", name.c_str(), _path.c_str());
+            return false;
+        }
+        
+        return true;
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+
+namespace ouzel
+{
+    // zip file with stored or deflated entries, the central directory is read once and the entries on demand
+    class Archive: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        Archive();
+        virtual ~Archive();
+        
+        bool init(const std::string& path);
+        
+        const std::string& getPath() const { return _path; }
+        
+        // names use forward slashes and are relative to the root of the archive
+        bool hasEntry(const std::string& name) const;
+        bool readEntry(const std::string& name, std::vector<uint8_t>& data);
+        
+    protected:
+        struct Entry
+        {
+            uint32_t localHeaderOffset;
+            uint32_t compressedSize;
+            uint32_t size;
+            uint16_t method;
+        };
+        
+        std::string _path;
+        FILE* _file = nullptr;
+        // entries can be read from several threads, but they share the file position
+        std::mutex _fileMutex;
+        
+        std::unordered_map<std::string, Entry> _entries;
+    };
+}
@@ -0,0 +1,485 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "AsyncFileReader.h"
+#include "Utils.h"
+
+#ifdef OUZEL_PLATFORM_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ouzel
+{
+    AsyncFileReader::AsyncFileReader(ThreadPool* threadPool):
+        _threadPool(threadPool)
+    {
+#ifdef OUZEL_PLATFORM_LINUX
+        // kernels without io_uring or with it disabled fall back to the thread pool
+        if (!initRing())
+        {
+            destroyRing();
+        }
+#endif
+    }
+    
+    AsyncFileReader::~AsyncFileReader()
+    {
+#ifdef OUZEL_PLATFORM_LINUX
+        // the kernel writes to the buffers of the in flight reads
+        while (_inFlight > 0)
+        {
+            reapCompletions(true);
+        }
+        
+        destroyRing();
+#endif
+        
+        {
+            std::unique_lock<std::mutex> lock(_finishedMutex);
+            
+            // the worker threads write to the requests
+            _finishedCondition.wait(lock, [this] { return _runningTasks == 0; });
+        }
+        
+        // the callbacks of unfinished requests are not called
+        for (Request* request : _requests)
+        {
+#ifdef OUZEL_PLATFORM_LINUX
+            if (request->fd >= 0)
+            {
+                close(request->fd);
+            }
+#endif
+            
+            delete request;
+        }
+    }
+    
+    bool AsyncFileReader::isUsingIOUring() const
+    {
+#ifdef OUZEL_PLATFORM_LINUX
+        return _ringFd >= 0;
+#else
+        return false;
+#endif
+    }
+    
+    AsyncFileReader::Request* AsyncFileReader::createRequest(const std::string& path, const Callback& callback)
+    {
+        Request* request = new Request();
+        request->path = path;
+        request->callback = callback;
+        
+        _requests.insert(request);
+        ++_pendingCount;
+        
+        return request;
+    }
+    
+    void AsyncFileReader::read(const std::string& path, const Callback& callback)
+    {
+        _queued.push_back(createRequest(path, callback));
+    }
+    
+    void AsyncFileReader::readEntry(const AutoPtr<Archive>& archive, const std::string& name, const Callback& callback)
+    {
+        Request* request = createRequest(name, callback);
+        request->archive = archive;
+        
+        _queued.push_back(request);
+    }
+    
+    void AsyncFileReader::fail(const std::string& path, const Callback& callback)
+    {
+        finish(createRequest(path, callback));
+    }
+    
+    void AsyncFileReader::readOnThread(Request* request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_finishedMutex);
+            ++_runningTasks;
+        }
+        
+        _threadPool->enqueue([this, request]() {
+            if (request->archive)
+            {
+                // archives decompress the entries, so they are always read on a worker thread
+                request->success = request->archive->readEntry(request->path, request->data);
+            }
+            else if (FILE* fp = fopen(request->path.c_str(), "rb"))
+            {
+                fseek(fp, 0, SEEK_END);
+                long size = ftell(fp);
+                fseek(fp, 0, SEEK_SET);
+                
+                request->data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+                request->success = request->data.empty() || fread(request->data.data(), 1, request->data.size(), fp) == request->data.size();
+                
+                fclose(fp);
+            }
+            
+            std::lock_guard<std::mutex> lock(_finishedMutex);
+            
+            _finished.push_back(request);
+            --_runningTasks;
+            _finishedCondition.notify_all();
+        });
+    }
+    
+    void AsyncFileReader::finish(Request* request)
+    {
+        std::lock_guard<std::mutex> lock(_finishedMutex);
+        
+        _finished.push_back(request);
+    }
+    
+    void AsyncFileReader::update()
+    {
+        for (Request* request : _queued)
+        {
+#ifdef OUZEL_PLATFORM_LINUX
+            // the size is needed for allocating the buffer, so it is queried together with opening the file
+            if (_ringFd >= 0 && !request->archive)
+            {
+                request->openOperations = 2;
+                queueOperation(request, Operation::OPEN);
+                queueOperation(request, Operation::STAT);
+                continue;
+            }
+#endif
+            
+            readOnThread(request);
+        }
+        
+        _queued.clear();
+
+#ifdef OUZEL_PLATFORM_LINUX
+        if (_ringFd >= 0)
+        {
+            submitOperations();
+            reapCompletions(false);
+            
+            // reads of the files that were opened meanwhile don't have to wait for the next frame
+            submitOperations();
+        }
+#endif
+        
+        std::vector<Request*> finished;
+        
+        {
+            std::lock_guard<std::mutex> lock(_finishedMutex);
+            finished.swap(_finished);
+        }
+        
+        for (Request* request : finished)
+        {
+            --_pendingCount;
+            
+            if (!request->success)
+            {
+                log("Failed to read file %s", request->path.c_str());
+            }
+            
+            if (request->callback)
+            {
+                request->callback(request->success, request->data);
+            }
+            
+            _requests.erase(request);
+            delete request;
+        }
+    }
+
+#ifdef OUZEL_PLATFORM_LINUX
+    bool AsyncFileReader::initRing()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        
+        _ringFd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        
+        if (_ringFd < 0)
+        {
+            return false;
+        }
+        
+        // open, statx and read operations came together with this feature in Linux 5.6
+        if (!(params.features & IORING_FEAT_RW_CUR_POS))
+        {
+            return false;
+        }
+        
+        _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+        }
+        
+        void* sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+        
+        if (sqRing == MAP_FAILED)
+        {
+            return false;
+        }
+        
+        _sqRing = static_cast<uint8_t*>(sqRing);
+        
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            _cqRing = _sqRing;
+        }
+        else
+        {
+            void* cqRing = mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+            
+            if (cqRing == MAP_FAILED)
+            {
+                return false;
+            }
+            
+            _cqRing = static_cast<uint8_t*>(cqRing);
+        }
+        
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        
+        void* sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+        
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+        
+        _sqes = static_cast<io_uring_sqe*>(sqes);
+        
+        _sqTail = reinterpret_cast<uint32_t*>(_sqRing + params.sq_off.tail);
+        _sqMask = *reinterpret_cast<uint32_t*>(_sqRing + params.sq_off.ring_mask);
+        _sqArray = reinterpret_cast<uint32_t*>(_sqRing + params.sq_off.array);
+        _sqEntries = params.sq_entries;
+        
+        _cqHead = reinterpret_cast<uint32_t*>(_cqRing + params.cq_off.head);
+        _cqTail = reinterpret_cast<uint32_t*>(_cqRing + params.cq_off.tail);
+        _cqMask = *reinterpret_cast<uint32_t*>(_cqRing + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(_cqRing + params.cq_off.cqes);
+        
+        return true;
+    }
+    
+    void AsyncFileReader::destroyRing()
+    {
+        if (_sqes)
+        {
+            munmap(_sqes, _sqesSize);
+            _sqes = nullptr;
+        }
+        
+        if (_cqRing && _cqRing != _sqRing)
+        {
+            munmap(_cqRing, _cqRingSize);
+        }
+        
+        _cqRing = nullptr;
+        
+        if (_sqRing)
+        {
+            munmap(_sqRing, _sqRingSize);
+            _sqRing = nullptr;
+        }
+        
+        if (_ringFd >= 0)
+        {
+            close(_ringFd);
+            _ringFd = -1;
+        }
+    }
+    
+    void AsyncFileReader::queueOperation(Request* request, Operation operation)
+    {
+        _operations.push_back(std::make_pair(request, operation));
+    }
+    
+    uint32_t AsyncFileReader::submitOperations()
+    {
+        uint32_t tail = *_sqTail;
+        uint32_t count = 0;
+        
+        while (!_operations.empty() && _inFlight + count < _sqEntries)
+        {
+            Request* request = _operations.front().first;
+            Operation operation = _operations.front().second;
+            _operations.pop_front();
+            
+            uint32_t index = (tail + count) & _sqMask;
+            io_uring_sqe& sqe = _sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            
+            switch (operation)
+            {
+                case Operation::OPEN:
+                    sqe.opcode = IORING_OP_OPENAT;
+                    sqe.fd = AT_FDCWD;
+                    sqe.addr = reinterpret_cast<uint64_t>(request->path.c_str());
+                    sqe.open_flags = O_RDONLY | O_CLOEXEC;
+                    break;
+                case Operation::STAT:
+                    sqe.opcode = IORING_OP_STATX;
+                    sqe.fd = AT_FDCWD;
+                    sqe.addr = reinterpret_cast<uint64_t>(request->path.c_str());
+                    sqe.len = STATX_SIZE;
+                    sqe.off = reinterpret_cast<uint64_t>(&request->stat);
+                    break;
+                case Operation::READ:
+                    sqe.opcode = IORING_OP_READ;
+                    sqe.fd = request->fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(request->data.data() + request->offset);
+                    sqe.len = static_cast<uint32_t>(std::min<uint64_t>(request->data.size() - request->offset, 0x7FFFF000));
+                    sqe.off = request->offset;
+                    break;
+            }
+            
+            // requests are at least 4-byte aligned, so the operation fits in the low bits
+            sqe.user_data = reinterpret_cast<uint64_t>(request) | static_cast<uint64_t>(operation);
+            
+            _sqArray[index] = index;
+            ++count;
+        }
+        
+        if (count > 0)
+        {
+            // the entries have to be visible to the kernel before the tail
+            __atomic_store_n(_sqTail, tail + count, __ATOMIC_RELEASE);
+            
+            int result = static_cast<int>(syscall(__NR_io_uring_enter, _ringFd, count, 0, 0, nullptr, 0));
+            uint32_t submitted = (result > 0) ? static_cast<uint32_t>(result) : 0;
+            
+            _inFlight += submitted;
+            
+            if (submitted < count)
+            {
+                log("Failed to submit %u file operations", count - submitted);
+                
+                // the kernel reads the queue only in io_uring_enter, so the entries it didn't take can be removed from it
+                std::vector<std::pair<Request*, Operation>> failed;
+                
+                for (uint32_t i = submitted; i < count; ++i)
+                {
+                    const io_uring_sqe& sqe = _sqes[(tail + i) & _sqMask];
+                    failed.push_back(std::make_pair(reinterpret_cast<Request*>(sqe.user_data & ~static_cast<uint64_t>(3)),
+                                                    static_cast<Operation>(sqe.user_data & 3)));
+                }
+                
+                __atomic_store_n(_sqTail, tail + submitted, __ATOMIC_RELEASE);
+                
+                for (const std::pair<Request*, Operation>& operation : failed)
+                {
+                    completeOperation(operation.first, operation.second, -EIO);
+                }
+            }
+            
+            count = submitted;
+        }
+        
+        return count;
+    }
+    
+    void AsyncFileReader::reapCompletions(bool wait)
+    {
+        if (wait)
+        {
+            syscall(__NR_io_uring_enter, _ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        }
+        
+        uint32_t head = *_cqHead;
+        uint32_t tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe& cqe = _cqes[head & _cqMask];
+            
+            Request* request = reinterpret_cast<Request*>(cqe.user_data & ~static_cast<uint64_t>(3));
+            Operation operation = static_cast<Operation>(cqe.user_data & 3);
+            int32_t result = cqe.res;
+            
+            --_inFlight;
+            
+            // the entry can be reused by the kernel after the head moves
+            __atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+            
+            if (!wait)
+            {
+                completeOperation(request, operation, result);
+            }
+            else if (operation == Operation::OPEN && result >= 0)
+            {
+                // shutting down, only the descriptors are closed
+                close(result);
+            }
+        }
+    }
+    
+    void AsyncFileReader::completeOperation(Request* request, Operation operation, int32_t result)
+    {
+        if (operation == Operation::OPEN || operation == Operation::STAT)
+        {
+            if (result < 0)
+            {
+                request->failed = true;
+            }
+            else if (operation == Operation::OPEN)
+            {
+                request->fd = result;
+            }
+            
+            // the read starts after the file is both opened and its size is known
+            if (--request->openOperations > 0)
+            {
+                return;
+            }
+            
+            if (!request->failed)
+            {
+                request->data.resize(static_cast<size_t>(request->stat.stx_size));
+                
+                if (!request->data.empty())
+                {
+                    queueOperation(request, Operation::READ);
+                    return;
+                }
+                
+                request->success = true;
+            }
+        }
+        else if (result > 0)
+        {
+            request->offset += static_cast<uint64_t>(result);
+            
+            // reads can return less than requested
+            if (request->offset < request->data.size())
+            {
+                queueOperation(request, Operation::READ);
+                return;
+            }
+            
+            request->success = true;
+        }
+        
+        // a read returning 0 means that the file got shorter after its size was queried
+        if (request->fd >= 0)
+        {
+            close(request->fd);
+            request->fd = -1;
+        }
+        
+        finish(request);
+    }
+#endif
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "CompileConfig.h"
+#include "AutoPtr.h"
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "ThreadPool.h"
+#include "Archive.h"
+
+#ifdef OUZEL_PLATFORM_LINUX
+#include <sys/stat.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace ouzel
+{
+    // reads whole files without blocking the calling thread, with io_uring on Linux and with a thread pool elsewhere
+    class AsyncFileReader: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        // data can be moved out of the vector
+        typedef std::function<void(bool success, std::vector<uint8_t>& data)> Callback;
+        
+        AsyncFileReader(ThreadPool* threadPool);
+        virtual ~AsyncFileReader();
+        
+        // requests are queued and submitted together in the next update
+        void read(const std::string& path, const Callback& callback);
+        void readEntry(const AutoPtr<Archive>& archive, const std::string& name, const Callback& callback);
+        // calls the callback with a failure in the next update
+        void fail(const std::string& path, const Callback& callback);
+        
+        // submits the queued requests and calls the callbacks of the finished ones on the calling thread
+        void update();
+        
+        uint32_t getPendingCount() const { return _pendingCount; }
+        bool isUsingIOUring() const;
+        
+    protected:
+        struct Request
+        {
+            std::string path;
+            AutoPtr<Archive> archive;
+            Callback callback;
+            std::vector<uint8_t> data;
+            bool success = false;
+
+#ifdef OUZEL_PLATFORM_LINUX
+            int fd = -1;
+            struct statx stat;
+            uint64_t offset = 0;
+            uint32_t openOperations = 0;
+            bool failed = false;
+#endif
+        };
+        
+        Request* createRequest(const std::string& path, const Callback& callback);
+        void readOnThread(Request* request);
+        void finish(Request* request);
+        
+        AutoPtr<ThreadPool> _threadPool;
+        
+        // only created and deleted on the thread calling update
+        std::unordered_set<Request*> _requests;
+        std::vector<Request*> _queued;
+        uint32_t _pendingCount = 0;
+        
+        // requests finished by the worker threads
+        std::mutex _finishedMutex;
+        std::condition_variable _finishedCondition;
+        std::vector<Request*> _finished;
+        uint32_t _runningTasks = 0;
+
+#ifdef OUZEL_PLATFORM_LINUX
+        enum class Operation
+        {
+            OPEN,
+            STAT,
+            READ
+        };
+        
+        bool initRing();
+        void destroyRing();
+        void queueOperation(Request* request, Operation operation);
+        uint32_t submitOperations();
+        void reapCompletions(bool wait);
+        void completeOperation(Request* request, Operation operation, int32_t result);
+        
+        static const uint32_t RING_ENTRIES = 64;
+        
+        int _ringFd = -1;
+        uint8_t* _sqRing = nullptr;
+        size_t _sqRingSize = 0;
+        uint8_t* _cqRing = nullptr;
+        size_t _cqRingSize = 0;
+        io_uring_sqe* _sqes = nullptr;
+        size_t _sqesSize = 0;
+        
+        uint32_t* _sqTail = nullptr;
+        uint32_t _sqMask = 0;
+        uint32_t* _sqArray = nullptr;
+        uint32_t _sqEntries = 0;
+        
+        uint32_t* _cqHead = nullptr;
+        uint32_t* _cqTail = nullptr;
+        uint32_t _cqMask = 0;
+        io_uring_cqe* _cqes = nullptr;
+        
+        // operations that didn't fit in the submission queue or were created by completions
+        std::deque<std::pair<Request*, Operation>> _operations;
+        // in flight operations are limited by the submission queue size, so that the completion queue never overflows
+        uint32_t _inFlight = 0;
+#endif
+    };
+}
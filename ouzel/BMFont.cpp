@@ -0,0 +1,341 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "BMFont.h"
+#include "Engine.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "FileSystem.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    // reads the next key=value pair of a line, value can be quoted
+    static bool readPair(const char*& str, std::string& key, std::string& value)
+    {
+        while (*str == ' ' || *str == '\t') ++str;
+        
+        const char* keyStart = str;
+        
+        while (*str && *str != '=' && *str != ' ' && *str != '\t' && *str != '\r' && *str != '\n') ++str;
+        
+        if (*str != '=')
+        {
+            return false;
+        }
+        
+        key.assign(keyStart, str);
+        ++str;
+        
+        if (*str == '"')
+        {
+            const char* valueStart = ++str;
+            
+            while (*str && *str != '"') ++str;
+            
+            value.assign(valueStart, str);
+            
+            if (*str == '"') ++str;
+        }
+        else
+        {
+            const char* valueStart = str;
+            
+            while (*str && *str != ' ' && *str != '\t' && *str != '\r' && *str != '\n') ++str;
+            
+            value.assign(valueStart, str);
+        }
+        
+        return true;
+    }
+    
+    static const char* nextLine(const char* str)
+    {
+        const char* end = strchr(str, '\n');
+        
+        return end ? end + 1 : nullptr;
+    }
+    
+    static uint32_t decodeUTF8(const std::string& text, size_t& position)
+    {
+        uint8_t c = static_cast<uint8_t>(text[position++]);
+        
+        uint32_t result;
+        uint32_t extra;
+        
+        if (c < 0x80) return c;
+        else if ((c & 0xE0) == 0xC0) { result = c & 0x1F; extra = 1; }
+        else if ((c & 0xF0) == 0xE0) { result = c & 0x0F; extra = 2; }
+        else if ((c & 0xF8) == 0xF0) { result = c & 0x07; extra = 3; }
+        else return 0xFFFD;
+        
+        for (; extra > 0; --extra)
+        {
+            if (position >= text.length() || (static_cast<uint8_t>(text[position]) & 0xC0) != 0x80)
+            {
+                return 0xFFFD;
+            }
+            
+            result = (result << 6) | (static_cast<uint8_t>(text[position++]) & 0x3F);
+        }
+        
+        return result;
+    }
+    
+    BMFont::BMFont(Engine* engine):
+        _engine(engine)
+    {
+        
+    }
+    
+    BMFont::~BMFont()
+    {
+        
+    }
+    
+    bool BMFont::initFromFile(const std::string& filename)
+    {
+        std::vector<uint8_t> data;
+        
+        if (!_engine->getFileSystem()->readFile(filename, data))
+        {
+            log("Failed to open font file %s", filename.c_str());
+            return false;
+        }
+        
+        // terminates the last line
+        data.push_back(0);
+        
+        std::string pageFile;
+        std::string key;
+        std::string value;
+        
+        for (const char* line = reinterpret_cast<const char*>(data.data()); line; line = nextLine(line))
+        {
+            const char* str = line;
+            
+            while (*str == ' ' || *str == '\t') ++str;
+            
+            const char* tagStart = str;
+            
+            while (*str && *str != ' ' && *str != '\t' && *str != '\r' && *str != '\n') ++str;
+            
+            std::string tag(tagStart, str);
+            
+            if (tag == "common")
+            {
+                uint32_t pages = 1;
+                
+                while (readPair(str, key, value))
+                {
+                    if (key == "lineHeight") _lineHeight = static_cast<uint16_t>(atoi(value.c_str()));
+                    else if (key == "base") _base = static_cast<uint16_t>(atoi(value.c_str()));
+                    else if (key == "scaleW") _width = static_cast<uint16_t>(atoi(value.c_str()));
+                    else if (key == "scaleH") _height = static_cast<uint16_t>(atoi(value.c_str()));
+                    else if (key == "pages") pages = static_cast<uint32_t>(atoi(value.c_str()));
+                }
+                
+                if (pages > 1)
+                {
+                    log("Font %s has %u pages, only the first one is used", filename.c_str(), pages);
+                }
+            }
+            else if (tag == "page")
+            {
+                uint32_t pageId = 0;
+                std::string file;
+                
+                while (readPair(str, key, value))
+                {
+                    if (key == "id") pageId = static_cast<uint32_t>(atoi(value.c_str()));
+                    else if (key == "file") file = value;
+                }
+                
+                if (pageId == 0)
+                {
+                    pageFile = file;
+                }
+            }
+            else if (tag == "char")
+            {
+                uint32_t charId = 0;
+                uint32_t page = 0;
+                CharDescriptor c;
+                
+                while (readPair(str, key, value))
+                {
+                    if (key == "id") charId = static_cast<uint32_t>(atoi(value.c_str()));
+                    else if (key == "x") c.x = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "y") c.y = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "width") c.width = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "height") c.height = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "xoffset") c.xOffset = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "yoffset") c.yOffset = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "xadvance") c.xAdvance = static_cast<int16_t>(atoi(value.c_str()));
+                    else if (key == "page") page = static_cast<uint32_t>(atoi(value.c_str()));
+                }
+                
+                if (page == 0)
+                {
+                    _chars[charId] = c;
+                }
+            }
+            else if (tag == "kerning")
+            {
+                uint32_t first = 0;
+                uint32_t second = 0;
+                int16_t amount = 0;
+                
+                while (readPair(str, key, value))
+                {
+                    if (key == "first") first = static_cast<uint32_t>(atoi(value.c_str()));
+                    else if (key == "second") second = static_cast<uint32_t>(atoi(value.c_str()));
+                    else if (key == "amount") amount = static_cast<int16_t>(atoi(value.c_str()));
+                }
+                
+                _kernings[(static_cast<uint64_t>(first) << 32) | second] = amount;
+            }
+        }
+        
+        if (pageFile.empty() || _width == 0 || _height == 0)
+        {
+            log("Invalid font file %s", filename.c_str());
+            return false;
+        }
+        
+        // page files are relative to the font file
+        _texture = _engine->getRenderer()->getTexture(FileSystem::getDirectoryPart(filename) + pageFile);
+        
+        if (!_texture)
+        {
+            return false;
+        }
+        
+        return true;
+    }
+    
+    int16_t BMFont::getKerning(uint32_t first, uint32_t second) const
+    {
+        std::unordered_map<uint64_t, int16_t>::const_iterator i = _kernings.find((static_cast<uint64_t>(first) << 32) | second);
+        
+        if (i != _kernings.end())
+        {
+            return i->second;
+        }
+        
+        return 0;
+    }
+    
+    bool BMFont::getVertices(const std::string& text, const Color& color, std::vector<uint16_t>& indices, std::vector<Vertex>& vertices, Size2& size) const
+    {
+        return layoutText(text, color, &indices, &vertices, size);
+    }
+    
+    Size2 BMFont::getTextSize(const std::string& text) const
+    {
+        Size2 size;
+        
+        layoutText(text, Color(), nullptr, nullptr, size);
+        
+        return size;
+    }
+    
+    bool BMFont::layoutText(const std::string& text, const Color& color, std::vector<uint16_t>* indices, std::vector<Vertex>* vertices, Size2& size) const
+    {
+        if (indices) indices->clear();
+        if (vertices) vertices->clear();
+        
+        float penX = 0.0f;
+        float lineTop = 0.0f;
+        float width = 0.0f;
+        uint32_t previous = 0;
+        
+        size_t position = 0;
+        
+        while (position < text.length())
+        {
+            uint32_t c = decodeUTF8(text, position);
+            
+            if (c == '\n')
+            {
+                width = std::max(width, penX);
+                penX = 0.0f;
+                lineTop -= _lineHeight;
+                previous = 0;
+                continue;
+            }
+            
+            std::unordered_map<uint32_t, CharDescriptor>::const_iterator i = _chars.find(c);
+            
+            if (i == _chars.end())
+            {
+                continue;
+            }
+            
+            const CharDescriptor& charDescriptor = i->second;
+            
+            if (previous)
+            {
+                penX += getKerning(previous, c);
+            }
+            
+            previous = c;
+            
+            if (indices && vertices && charDescriptor.width > 0 && charDescriptor.height > 0)
+            {
+                if (vertices->size() + 4 > 65536)
+                {
+                    log("Text is too long to fit in one mesh buffer");
+                    return false;
+                }
+                
+                uint16_t startIndex = static_cast<uint16_t>(vertices->size());
+                
+                indices->push_back(startIndex + 0);
+                indices->push_back(startIndex + 1);
+                indices->push_back(startIndex + 2);
+                indices->push_back(startIndex + 1);
+                indices->push_back(startIndex + 3);
+                indices->push_back(startIndex + 2);
+                
+                float left = penX + charDescriptor.xOffset;
+                float right = left + charDescriptor.width;
+                float top = lineTop - charDescriptor.yOffset;
+                float bottom = top - charDescriptor.height;
+                
+                float leftU = static_cast<float>(charDescriptor.x) / _width;
+                float rightU = static_cast<float>(charDescriptor.x + charDescriptor.width) / _width;
+                float topV = static_cast<float>(charDescriptor.y) / _height;
+                float bottomV = static_cast<float>(charDescriptor.y + charDescriptor.height) / _height;
+                
+                vertices->push_back(Vertex(Vector3(left, bottom, -20.0f), color, Vector2(leftU, bottomV)));
+                vertices->push_back(Vertex(Vector3(right, bottom, -20.0f), color, Vector2(rightU, bottomV)));
+                vertices->push_back(Vertex(Vector3(left, top, -20.0f), color, Vector2(leftU, topV)));
+                vertices->push_back(Vertex(Vector3(right, top, -20.0f), color, Vector2(rightU, topV)));
+            }
+            
+            penX += charDescriptor.xAdvance;
+        }
+        
+        width = std::max(width, penX);
+        
+        size.width = width;
+        size.height = _lineHeight - lineTop;
+        
+        // center the text around origin
+        if (vertices)
+        {
+            for (Vertex& vertex : *vertices)
+            {
+                vertex.position.x -= size.width / 2.0f;
+                vertex.position.y += size.height / 2.0f;
+            }
+        }
+        
+        return true;
+    }
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "AutoPtr.h"
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "Size2.h"
+#include "Color.h"
+#include "Vertex.h"
+
+namespace ouzel
+{
+    class Engine;
+    class Texture;
+    
+    // bitmap font in the text format of AngelCode's BMFont
+    class BMFont: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        BMFont(Engine* engine);
+        virtual ~BMFont();
+        
+        virtual bool initFromFile(const std::string& filename);
+        
+        Texture* getTexture() const { return _texture; }
+        
+        uint16_t getLineHeight() const { return _lineHeight; }
+        uint16_t getBase() const { return _base; }
+        
+        // generates quads for UTF-8 encoded text, centered around origin
+        bool getVertices(const std::string& text, const Color& color, std::vector<uint16_t>& indices, std::vector<Vertex>& vertices, Size2& size) const;
+        // size of the text without generating the quads
+        Size2 getTextSize(const std::string& text) const;
+        
+    protected:
+        struct CharDescriptor
+        {
+            int16_t x = 0;
+            int16_t y = 0;
+            int16_t width = 0;
+            int16_t height = 0;
+            int16_t xOffset = 0;
+            int16_t yOffset = 0;
+            int16_t xAdvance = 0;
+        };
+        
+        int16_t getKerning(uint32_t first, uint32_t second) const;
+        // quads are generated only if indices and vertices are not null
+        bool layoutText(const std::string& text, const Color& color, std::vector<uint16_t>* indices, std::vector<Vertex>* vertices, Size2& size) const;
+        
+        Engine* _engine;
+        
+        AutoPtr<Texture> _texture;
+        
+        uint16_t _lineHeight = 0;
+        uint16_t _base = 0;
+        uint16_t _width = 0;
+        uint16_t _height = 0;
+        
+        std::unordered_map<uint32_t, CharDescriptor> _chars;
+        std::unordered_map<uint64_t, int16_t> _kernings;
+    };
+}
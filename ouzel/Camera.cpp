@@ -1,21 +1,26 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
 #include "Camera.h"
+#include "Scene.h"
+#include "Engine.h"
+#include "Renderer.h"
 
 namespace ouzel
 {
     Camera::Camera(Scene* scene):
         Node(scene)
     {
-        
+        recalculateViewProjection();
     }
-
+    
     Camera::~Camera()
     {
         
     }
-
+    
     void Camera::updateTransform()
     {
         Matrix4 translation;
@@ -35,13 +40,16 @@ namespace ouzel
         }
         
         markInverseTransformDirty();
+        markDirty();
+        
+        recalculateViewProjection();
         
         for (AutoPtr<Node> child : _children)
         {
             child->updateTransform();
         }
     }
-
+    
     void Camera::setZoom(float zoom)
     {
         _zoom = zoom;
@@ -53,4 +61,65 @@ namespace ouzel
         
         updateTransform();
     }
+    
+    void Camera::setViewport(const Rectangle& viewport)
+    {
+        _viewport = viewport;
+        
+        markDirty();
+        recalculateViewProjection();
+    }
+    
+    void Camera::setRenderTarget(RenderTarget* renderTarget)
+    {
+        _renderTarget = renderTarget;
+        
+        markDirty();
+        recalculateViewProjection();
+    }
+    
+    Rectangle Camera::getRenderViewport() const
+    {
+        Size2 targetSize = _renderTarget ? _renderTarget->getSize() : _scene->getEngine()->getRenderer()->getSize();
+        
+        return Rectangle(_viewport.x * targetSize.width, _viewport.y * targetSize.height,
+                         _viewport.width * targetSize.width, _viewport.height * targetSize.height);
+    }
+    
+    void Camera::recalculateViewProjection()
+    {
+        Rectangle renderViewport = getRenderViewport();
+        
+        Matrix4 projection;
+        Matrix4::createOrthographic(renderViewport.width, renderViewport.height, 1.0f, 1000.0f, &projection);
+        
+        _viewProjection = projection * _transform;
+        
+        Matrix4 inverseViewProjection = _viewProjection;
+        inverseViewProjection.invert();
+        
+        Vector3 corners[4] = {
+            Vector3(-1.0f, -1.0f, 0.0f),
+            Vector3(1.0f, -1.0f, 0.0f),
+            Vector3(-1.0f, 1.0f, 0.0f),
+            Vector3(1.0f, 1.0f, 0.0f)
+        };
+        
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+        
+        for (Vector3& corner : corners)
+        {
+            inverseViewProjection.transformPoint(&corner);
+            
+            minX = std::min(minX, corner.x);
+            minY = std::min(minY, corner.y);
+            maxX = std::max(maxX, corner.x);
+            maxY = std::max(maxY, corner.y);
+        }
+        
+        _visibleRectangle.set(minX, minY, maxX - minX, maxY - minY);
+    }
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "Node.h"
+#include "RenderTarget.h"
 
 namespace ouzel
 {
@@ -18,9 +19,36 @@ namespace ouzel
         float getZoom() const { return _zoom; }
         void setZoom(float zoom);
         
+        // normalized to the size of the render target, (0, 0) is the bottom left corner
+        const Rectangle& getViewport() const { return _viewport; }
+        void setViewport(const Rectangle& viewport);
+        
+        // nullptr renders to the screen
+        RenderTarget* getRenderTarget() const { return _renderTarget; }
+        void setRenderTarget(RenderTarget* renderTarget);
+        
+        // only nodes that have at least one of these layers are drawn by this camera
+        uint32_t getLayerMask() const { return _layerMask; }
+        void setLayerMask(uint32_t layerMask) { _layerMask = layerMask; markDirty(); }
+        
+        Rectangle getRenderViewport() const;
+        
+        void recalculateViewProjection();
+        const Matrix4& getViewProjection() const { return _viewProjection; }
+        
+        // part of the world that is visible through the camera
+        const Rectangle& getVisibleRectangle() const { return _visibleRectangle; }
+        
     protected:
         virtual void updateTransform() override;
         
         float _zoom = 1.0f;
+        
+        Rectangle _viewport = Rectangle(0.0f, 0.0f, 1.0f, 1.0f);
+        AutoPtr<RenderTarget> _renderTarget;
+        uint32_t _layerMask = 0xFFFFFFFF;
+        
+        Matrix4 _viewProjection;
+        Rectangle _visibleRectangle;
     };
 }
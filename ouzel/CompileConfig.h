@@ -20,3 +20,11 @@
 #endif
 
 #endif
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define OUZEL_PLATFORM_LINUX
+#endif
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define OUZEL_DEBUG
+#endif
@@ -1,6 +1,8 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
 #include "Engine.h"
 #include "CompileConfig.h"
 
@@ -35,15 +37,23 @@ namespace ouzel
 #endif
 
         OuzelInit(settings);
+        
+        _eventDispatcher = new EventDispatcher();
 
-        _fileSystem = new FileSystem();
+        _threadPool = new ThreadPool();
+        _fileSystem = new FileSystem(_threadPool);
+        _fileSystem->setHotReloadEnabled(settings.hotReload);
         
         switch (settings.driver)
         {
 #if defined(OUZEL_PLATFORM_OSX) || defined(OUZEL_PLATFORM_IOS)
             case Renderer::Driver::OPENGL:
-                _renderer = new RendererOGL(settings.size, settings.fullscreen, this);
-				break;
+            {
+                RendererOGL* rendererOGL = new RendererOGL(settings.size, settings.fullscreen, this);
+                rendererOGL->setBackingStore(settings.partialRedraw);
+                _renderer = rendererOGL;
+                break;
+            }
 #endif
 #ifdef OUZEL_PLATFORM_WINDOWS
             case Renderer::Driver::DIRECT3D11:
@@ -55,16 +65,27 @@ namespace ouzel
                 break;
         }
         
+        _renderer->setVerticalSync(settings.verticalSync);
+        
         _scene = new Scene(this);
         _scene->init();
+        _scene->setPartialRedrawEnabled(settings.partialRedraw);
         
         _soundManager = new SoundManager(this);
         
-        _previousFrameTime = getCurrentMicroSeconds();
+        _framePacer = new FramePacer();
+        _framePacer->setTargetFPS(settings.targetFPS);
+        
+        _inputRecorder = new InputRecorder(this);
+        
+        _fixedTimeStep = settings.fixedTimeStep;
+        _maxUpdateSteps = settings.maxUpdateSteps;
     }
     
     Engine::~Engine()
     {
+        stopRecording();
+        
         OuzelEnd();
     }
     
@@ -73,20 +94,174 @@ namespace ouzel
         OuzelBegin(this);
     }
     
-    void Engine::run()
+    bool Engine::run()
     {
-        _renderer->begin();
-        _renderer->clear();
-        _scene->drawAll();
-        _renderer->flush();
+        _framePacer->waitForNextFrame();
         
-        for (EventHandler* eventHandler : _eventHandlers)
+        _fileSystem->update();
+        
+        if (_inputRecorder->isReplaying())
+        {
+            replayStep();
+        }
+        else
+        {
+            dispatchEvents();
+            
+            if (_fixedTimeStep > 0.0f)
+            {
+                // the simulation keeps up with the real time, so the raw delta is used
+                _accumulator += std::min(_framePacer->getDelta(), FramePacer::MAX_DELTA);
+                
+                uint32_t steps = 0;
+                
+                while (_accumulator >= _fixedTimeStep && steps < _maxUpdateSteps)
+                {
+                    step(_fixedTimeStep);
+                    
+                    _accumulator -= _fixedTimeStep;
+                    ++steps;
+                }
+                
+                // when the steps take longer than the time they simulate, the simulation slows down instead of falling further behind
+                if (_accumulator >= _fixedTimeStep)
+                {
+                    _accumulator = fmodf(_accumulator, _fixedTimeStep);
+                }
+                
+                _scene->interpolate(_accumulator / _fixedTimeStep);
+            }
+            else
+            {
+                // the smoothed delta keeps animations steady when single frames are late
+                step(_framePacer->getSmoothedDelta());
+            }
+        }
+        
+        // captures started in earlier frames finish also while partial redraw skips the unchanged frames
+        _renderer->updateCaptures();
+        
+        bool draw = _scene->prepareFrame();
+        
+        if (draw)
+        {
+            _renderer->begin();
+            _renderer->clear();
+            _scene->drawAll();
+            _renderer->flush();
+            
+            // the drawn sprites requested their mip levels, the next frame is drawn with the changed ones
+            if (_renderer->updateStreamedTextures())
+            {
+                _scene->redrawAll();
+            }
+        }
+        
+        return draw;
+    }
+    
+    bool Engine::startRecording(const std::string& filename)
+    {
+        return _inputRecorder->startRecording(filename, _fixedTimeStep, _stepCount, _framePacer->getFrameCount());
+    }
+    
+    void Engine::stopRecording()
+    {
+        _inputRecorder->stopRecording(_stepCount);
+    }
+    
+    bool Engine::startReplay(const std::string& filename)
+    {
+        if (!_inputRecorder->startReplay(filename))
+        {
+            return false;
+        }
+        
+        // recorded steps are counted from the start of the recording
+        _stepCount = 0;
+        _accumulator = 0.0f;
+        
+        return true;
+    }
+    
+    bool Engine::runReplay(const std::string& filename, std::vector<uint64_t>* frameTimes)
+    {
+        if (!startReplay(filename))
+        {
+            return false;
+        }
+        
+        float targetFPS = _framePacer->getTargetFPS();
+        _framePacer->setTargetFPS(0.0f);
+        
+        std::vector<uint64_t> times;
+        
+        while (_inputRecorder->isReplaying())
         {
-            uint64_t currentTime = getCurrentMicroSeconds();
-            uint64_t delta = currentTime - _previousFrameTime;
-            _previousFrameTime = currentTime;
+            uint64_t frameStart = getCurrentMicroSeconds();
+            
+            run();
+            
+            times.push_back(getCurrentMicroSeconds() - frameStart);
+        }
+        
+        _framePacer->setTargetFPS(targetFPS);
+        
+        if (!times.empty())
+        {
+            std::vector<uint64_t> sorted = times;
+            std::sort(sorted.begin(), sorted.end());
+            
+            uint64_t total = 0;
+            for (uint64_t time : sorted) total += time;
             
-            eventHandler->update(static_cast<float>(delta));
+            log("Replay of %s: %u frames, average %.3f ms, median %.3f ms, 99th percentile %.3f ms, max %.3f ms",
+                filename.c_str(),
+                static_cast<uint32_t>(sorted.size()),
+                total / 1000.0 / sorted.size(),
+                sorted[sorted.size() / 2] / 1000.0,
+                sorted[(sorted.size() - 1) * 99 / 100] / 1000.0,
+                sorted.back() / 1000.0);
+        }
+        
+        if (frameTimes)
+        {
+            *frameTimes = std::move(times);
+        }
+        
+        return true;
+    }
+    
+    void Engine::replayStep()
+    {
+        // platform input is dropped, so that it doesn't change the replayed session
+        Event event;
+        while (_eventQueue.pop(event)) { }
+        
+        _inputRecorder->getReplayEvents(_stepCount, _replayEvents);
+        
+        for (const Event& replayEvent : _replayEvents)
+        {
+            dispatchEvent(replayEvent);
+        }
+        
+        // the replay ends without a step after the last recorded one
+        if (_inputRecorder->isReplaying())
+        {
+            step(_inputRecorder->getReplayFixedTimeStep());
+        }
+    }
+    
+    void Engine::step(float delta)
+    {
+        ++_stepCount;
+        
+        // scene animations are in seconds
+        _scene->update(delta);
+        
+        for (EventHandler* eventHandler : _eventHandlers)
+        {
+            eventHandler->update(delta);
         }
     }
     
@@ -110,11 +285,75 @@ namespace ouzel
         }
     }
     
-    void Engine::handleEvent(const Event& event)
+    bool Engine::postEvent(const Event& event)
+    {
+        if (!_eventQueue.push(event))
+        {
+            log("Event queue is full, event dropped");
+            return false;
+        }
+        
+        return true;
+    }
+    
+    // consecutive moves and drags only report the latest position
+    static bool canCoalesce(const Event& event, const Event& next)
+    {
+        return (event.getType() == Event::Type::MOUSE_MOVE || event.getType() == Event::Type::MOUSE_DRAG) &&
+            next.getType() == event.getType() &&
+            next.modifiers == event.modifiers &&
+            next.mouseEvent.button == event.mouseEvent.button;
+    }
+    
+    void Engine::dispatchEvents()
+    {
+        // events posted during the dispatch wait for the next frame
+        uint32_t size = _eventQueue.getSize();
+        
+        Event event;
+        
+        if (size == 0 || !_eventQueue.pop(event))
+        {
+            return;
+        }
+        
+        Event next;
+        
+        for (uint32_t count = 1; count < size && _eventQueue.pop(next); ++count)
+        {
+            if (!canCoalesce(event, next))
+            {
+                dispatchEvent(event);
+            }
+            
+            event = next;
+        }
+        
+        dispatchEvent(event);
+    }
+    
+    void Engine::dispatchEvent(const Event& event)
     {
+        if (_inputRecorder->isRecording())
+        {
+            _inputRecorder->recordEvent(event, _stepCount, _framePacer->getFrameCount());
+        }
+        
+        Event handlerEvent = event;
+        
+        if (handlerEvent.isMouseEvent())
+        {
+            handlerEvent.mouseEvent.position = _renderer->absoluteToWorldLocation(event.mouseEvent.position);
+        }
+        
+        if (!_eventDispatcher->dispatchEvent(handlerEvent, _scene))
+        {
+            return;
+        }
+        
         for (EventHandler* eventHandler : _eventHandlers)
         {
-            if (!eventHandler->handleEvent(event))
+            if (!eventHandler->handleEvent(handlerEvent))
             {
                 break;
             }
@@ -3,12 +3,18 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 #include "AutoPtr.h"
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
 #include "Renderer.h"
 #include "EventHander.h"
+#include "FramePacer.h"
+#include "ThreadPool.h"
+#include "EventQueue.h"
+#include "EventDispatcher.h"
+#include "InputRecorder.h"
 
 namespace ouzel
 {
@@ -22,6 +28,18 @@ namespace ouzel
         Renderer::Driver driver = Renderer::Driver::NONE;
         Size2 size;
         bool fullscreen = false;
+        bool verticalSync = true;
+        // 0 doesn't limit the frame rate
+        float targetFPS = 60.0f;
+        // seconds of one simulation step, 0 updates once per frame with the frame time
+        float fixedTimeStep = 1.0f / 60.0f;
+        // steps per frame when the simulation falls behind, the rest of the time is dropped
+        uint32_t maxUpdateSteps = 5;
+        // textures, shaders and particle systems are reloaded when their files change
+        bool hotReload = false;
+        // enables Scene::setPartialRedrawEnabled and creates a screen that keeps its contents between frames,
+        // which some platforms can't do without it
+        bool partialRedraw = false;
     };
     
     class Engine: public Noncopyable, public ReferenceCounted
@@ -31,26 +49,71 @@ namespace ouzel
         virtual ~Engine();
         
         void begin();
-        void run();
+        // returns false if the frame was skipped, because nothing changed in the partial redraw mode
+        bool run();
         
         Renderer* getRenderer() const { return _renderer; }
         Scene* getScene() const { return _scene; }
         SoundManager* getSoundManager() const { return _soundManager; }
         FileSystem* getFileSystem() const { return _fileSystem; }
+        ThreadPool* getThreadPool() const { return _threadPool; }
+        FramePacer* getFramePacer() const { return _framePacer; }
+        EventDispatcher* getEventDispatcher() const { return _eventDispatcher; }
+        InputRecorder* getInputRecorder() const { return _inputRecorder; }
         
+        void setFixedTimeStep(float fixedTimeStep) { _fixedTimeStep = fixedTimeStep; _accumulator = 0.0f; }
+        float getFixedTimeStep() const { return _fixedTimeStep; }
+        
+        void setMaxUpdateSteps(uint32_t maxUpdateSteps) { _maxUpdateSteps = maxUpdateSteps; }
+        uint32_t getMaxUpdateSteps() const { return _maxUpdateSteps; }
+        
+        // handlers get the events that the event dispatcher's listeners didn't stop
         void addEventHandler(EventHandler* eventHandler);
         void removeEventHandler(EventHandler* eventHandler);
         
-        void handleEvent(const Event& event);
+        // queues the event for the next frame, the queue has a single producer,
+        // so only the platform thread that receives the input may call it
+        bool postEvent(const Event& event);
+        
+        // the scene should be in the same state when the recording and the replay start
+        bool startRecording(const std::string& filename);
+        void stopRecording();
+        
+        // replaces the platform input with the recorded events and runs one fixed step per frame
+        bool startReplay(const std::string& filename);
+        
+        // runs the whole replay without waiting for the platform loop and logs the frame times,
+        // meant for benchmarking with the headless renderer
+        bool runReplay(const std::string& filename, std::vector<uint64_t>* frameTimes = nullptr);
         
     protected:
+        void step(float delta);
+        void replayStep();
+        
+        void dispatchEvents();
+        void dispatchEvent(const Event& event);
+        
+        // destroyed after the scene, because nodes remove their listeners when they are deleted
+        AutoPtr<EventDispatcher> _eventDispatcher;
+        
+        AutoPtr<ThreadPool> _threadPool;
+        // destroyed after the renderer and the scene, because textures, shaders and particle systems stop watching their files
+        AutoPtr<FileSystem> _fileSystem;
         AutoPtr<Renderer> _renderer;
         AutoPtr<Scene> _scene;
         AutoPtr<SoundManager> _soundManager;
-        AutoPtr<FileSystem> _fileSystem;
+        AutoPtr<FramePacer> _framePacer;
+        AutoPtr<InputRecorder> _inputRecorder;
         
-        uint64_t _previousFrameTime;
+        float _fixedTimeStep = 0.0f;
+        uint32_t _maxUpdateSteps = 0;
+        // simulation time that has not been stepped yet
+        float _accumulator = 0.0f;
+        uint64_t _stepCount = 0;
         
         std::vector<EventHandler*> _eventHandlers;
+        
+        EventQueue _eventQueue;
+        std::vector<Event> _replayEvents;
     };
 }
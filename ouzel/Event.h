@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <new>
+#include <cstdint>
 #include "Vector2.h"
 
 namespace ouzel
@@ -175,19 +177,17 @@ namespace ouzel
     struct KeyboardEvent
     {
         KeyboardKey key = KeyboardKey::NONE;
-        bool shiftDown = false;
-        bool controlDown = false;
-        bool commandDown = false;
-        bool functionDown = false;
     };
     
     struct MouseEvent
     {
         MouseButton button = MouseButton::NONE;
+        // in window coordinates when posted to the engine, handlers get it in world coordinates
         Vector2 position;
         Vector2 scroll;
     };
     
+    // only the payload of the event type is valid
     struct Event
     {
         enum class Type
@@ -201,9 +201,81 @@ namespace ouzel
             MOUSE_DRAG
         };
         
-        Type type;
+        // modifier key flags
+        static const uint32_t SHIFT_DOWN = 0x01;
+        static const uint32_t CONTROL_DOWN = 0x02;
+        static const uint32_t COMMAND_DOWN = 0x04;
+        static const uint32_t FUNCTION_DOWN = 0x08;
         
-        KeyboardEvent keyboardEvent;
-        MouseEvent mouseEvent;
+        Event(Type aType = Type::KEY_DOWN):
+            _type(aType)
+        {
+            constructPayload(nullptr);
+        }
+        
+        Event(const Event& other):
+            modifiers(other.modifiers), _type(other._type)
+        {
+            constructPayload(&other);
+        }
+        
+        ~Event()
+        {
+            destroyPayload();
+        }
+        
+        Event& operator=(const Event& other)
+        {
+            if (this != &other)
+            {
+                destroyPayload();
+                
+                _type = other._type;
+                modifiers = other.modifiers;
+                constructPayload(&other);
+            }
+            
+            return *this;
+        }
+        
+        bool isMouseEvent() const
+        {
+            return _type == Type::MOUSE_DOWN || _type == Type::MOUSE_UP || _type == Type::MOUSE_SCROLL ||
+                   _type == Type::MOUSE_MOVE || _type == Type::MOUSE_DRAG;
+        }
+        
+        // the active payload depends on the type, so it is only set by the constructor and the assignment
+        Type getType() const { return _type; }
+        
+        uint32_t modifiers = 0;
+        
+        union
+        {
+            KeyboardEvent keyboardEvent;
+            MouseEvent mouseEvent;
+        };
+        
+    private:
+        Type _type;
+        
+        void constructPayload(const Event* other)
+        {
+            if (isMouseEvent())
+            {
+                if (other) new (&mouseEvent) MouseEvent(other->mouseEvent);
+                else new (&mouseEvent) MouseEvent();
+            }
+            else
+            {
+                if (other) new (&keyboardEvent) KeyboardEvent(other->keyboardEvent);
+                else new (&keyboardEvent) KeyboardEvent();
+            }
+        }
+        
+        void destroyPayload()
+        {
+            if (isMouseEvent()) mouseEvent.~MouseEvent();
+            else keyboardEvent.~KeyboardEvent();
+        }
     };
 }
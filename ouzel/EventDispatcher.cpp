@@ -0,0 +1,249 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <algorithm>
+#include "EventDispatcher.h"
+#include "Scene.h"
+#include "Node.h"
+
+namespace ouzel
+{
+    EventDispatcher::EventDispatcher()
+    {
+        
+    }
+    
+    EventDispatcher::~EventDispatcher()
+    {
+        
+    }
+    
+    uint32_t EventDispatcher::addListener(Event::Type type, const Callback& callback, int32_t priority)
+    {
+        Listener listener;
+        listener.type = type;
+        listener.node = nullptr;
+        listener.priority = priority;
+        listener.callback = callback;
+        
+        return addListener(listener);
+    }
+    
+    uint32_t EventDispatcher::addNodeListener(Node* node, Event::Type type, const Callback& callback, int32_t priority)
+    {
+        Listener listener;
+        listener.type = type;
+        listener.node = node;
+        listener.priority = priority;
+        listener.callback = callback;
+        
+        // the node removes its listeners when it is deleted
+        node->_hasEventListeners = true;
+        
+        return addListener(listener);
+    }
+    
+    uint32_t EventDispatcher::addListener(const Listener& listener)
+    {
+        Listener newListener = listener;
+        newListener.id = ++_lastId;
+        newListener.removed = false;
+        
+        _listenerIds[newListener.id] = std::make_pair(newListener.node, newListener.type);
+        
+        if (_dispatchDepth)
+        {
+            _pendingListeners.push_back(newListener);
+        }
+        else
+        {
+            insertListener(newListener);
+        }
+        
+        return newListener.id;
+    }
+    
+    void EventDispatcher::insertListener(const Listener& listener)
+    {
+        std::vector<Listener>& listeners = listener.node ?
+            _nodeListeners[static_cast<uint32_t>(listener.type)][listener.node] :
+            _listeners[static_cast<uint32_t>(listener.type)];
+        
+        // after the listeners of the same priority, so that they are called in the order they were added
+        std::vector<Listener>::iterator i = std::upper_bound(listeners.begin(), listeners.end(), listener,
+            [](const Listener& a, const Listener& b) { return a.priority > b.priority; });
+        
+        listeners.insert(i, listener);
+    }
+    
+    std::vector<EventDispatcher::Listener>* EventDispatcher::getListeners(Node* node, Event::Type type)
+    {
+        if (!node)
+        {
+            return &_listeners[static_cast<uint32_t>(type)];
+        }
+        
+        std::unordered_map<Node*, std::vector<Listener>>& nodeListeners = _nodeListeners[static_cast<uint32_t>(type)];
+        std::unordered_map<Node*, std::vector<Listener>>::iterator i = nodeListeners.find(node);
+        
+        return (i != nodeListeners.end()) ? &i->second : nullptr;
+    }
+    
+    void EventDispatcher::removeListener(uint32_t id)
+    {
+        std::unordered_map<uint32_t, std::pair<Node*, Event::Type>>::iterator i = _listenerIds.find(id);
+        
+        if (i == _listenerIds.end())
+        {
+            return;
+        }
+        
+        std::vector<Listener>* listeners = getListeners(i->second.first, i->second.second);
+        
+        _listenerIds.erase(i);
+        
+        for (std::vector<Listener>* list : { listeners, &_pendingListeners })
+        {
+            if (!list) continue;
+            
+            for (Listener& listener : *list)
+            {
+                if (listener.id == id)
+                {
+                    listener.removed = true;
+                    _hasRemovedListeners = true;
+                }
+            }
+        }
+        
+        if (!_dispatchDepth)
+        {
+            removeMarkedListeners();
+        }
+    }
+    
+    void EventDispatcher::removeNodeListeners(Node* node)
+    {
+        for (uint32_t type = 0; type < TYPE_COUNT; ++type)
+        {
+            std::vector<Listener>* listeners = getListeners(node, static_cast<Event::Type>(type));
+            
+            if (listeners)
+            {
+                for (Listener& listener : *listeners)
+                {
+                    listener.removed = true;
+                    _listenerIds.erase(listener.id);
+                }
+                
+                _hasRemovedListeners = true;
+            }
+        }
+        
+        for (Listener& listener : _pendingListeners)
+        {
+            if (listener.node == node)
+            {
+                listener.removed = true;
+                _listenerIds.erase(listener.id);
+            }
+        }
+        
+        if (!_dispatchDepth)
+        {
+            removeMarkedListeners();
+        }
+    }
+    
+    void EventDispatcher::removeMarkedListeners()
+    {
+        if (_hasRemovedListeners)
+        {
+            std::function<bool(const Listener&)> isRemoved = [](const Listener& listener) { return listener.removed; };
+            
+            for (uint32_t type = 0; type < TYPE_COUNT; ++type)
+            {
+                _listeners[type].erase(std::remove_if(_listeners[type].begin(), _listeners[type].end(), isRemoved), _listeners[type].end());
+                
+                for (std::unordered_map<Node*, std::vector<Listener>>::iterator i = _nodeListeners[type].begin(); i != _nodeListeners[type].end();)
+                {
+                    i->second.erase(std::remove_if(i->second.begin(), i->second.end(), isRemoved), i->second.end());
+                    
+                    if (i->second.empty())
+                    {
+                        i = _nodeListeners[type].erase(i);
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+            }
+            
+            _hasRemovedListeners = false;
+        }
+        
+        for (const Listener& listener : _pendingListeners)
+        {
+            if (!listener.removed)
+            {
+                insertListener(listener);
+            }
+        }
+        
+        _pendingListeners.clear();
+    }
+    
+    bool EventDispatcher::callListeners(std::vector<Listener>& listeners, const Event& event)
+    {
+        // the list doesn't change size during the dispatch, removed listeners are only marked
+        for (size_t i = 0; i < listeners.size(); ++i)
+        {
+            if (!listeners[i].removed && !listeners[i].callback(event))
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    bool EventDispatcher::dispatchEvent(const Event& event, Scene* scene)
+    {
+        uint32_t type = static_cast<uint32_t>(event.getType());
+        bool result = true;
+        
+        ++_dispatchDepth;
+        
+        // picking is only done if some node listens for this type of events
+        if (event.isMouseEvent() && scene && !_nodeListeners[type].empty())
+        {
+            AutoPtr<Node> node = scene->pickNode(event.mouseEvent.position);
+            
+            // the event bubbles up from the node under the cursor to its parents
+            while (node && result)
+            {
+                std::vector<Listener>* listeners = getListeners(node, event.getType());
+                
+                if (listeners)
+                {
+                    result = callListeners(*listeners, event);
+                }
+                
+                node = node->getParent();
+            }
+        }
+        
+        if (result)
+        {
+            result = callListeners(_listeners[type], event);
+        }
+        
+        if (--_dispatchDepth == 0)
+        {
+            removeMarkedListeners();
+        }
+        
+        return result;
+    }
+}
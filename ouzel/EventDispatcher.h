@@ -0,0 +1,72 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "Event.h"
+
+namespace ouzel
+{
+    class Scene;
+    class Node;
+    
+    // routes every event only to the listeners of its type
+    class EventDispatcher: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        // returning false stops the event from reaching the rest of the listeners
+        typedef std::function<bool(const Event&)> Callback;
+        
+        EventDispatcher();
+        virtual ~EventDispatcher();
+        
+        // listeners with a higher priority are called first, returns the id for removing the listener
+        uint32_t addListener(Event::Type type, const Callback& callback, int32_t priority = 0);
+        
+        // called for mouse events over the node or one of its children, before the listeners that are not bound to a node
+        uint32_t addNodeListener(Node* node, Event::Type type, const Callback& callback, int32_t priority = 0);
+        
+        void removeListener(uint32_t id);
+        void removeNodeListeners(Node* node);
+        
+        // returns false if a listener stopped the event
+        bool dispatchEvent(const Event& event, Scene* scene);
+        
+    protected:
+        static const uint32_t TYPE_COUNT = static_cast<uint32_t>(Event::Type::MOUSE_DRAG) + 1;
+        
+        struct Listener
+        {
+            uint32_t id;
+            Event::Type type;
+            Node* node;
+            int32_t priority;
+            Callback callback;
+            bool removed;
+        };
+        
+        uint32_t addListener(const Listener& listener);
+        void insertListener(const Listener& listener);
+        std::vector<Listener>* getListeners(Node* node, Event::Type type);
+        bool callListeners(std::vector<Listener>& listeners, const Event& event);
+        void removeMarkedListeners();
+        
+        std::vector<Listener> _listeners[TYPE_COUNT];
+        std::unordered_map<Node*, std::vector<Listener>> _nodeListeners[TYPE_COUNT];
+        
+        // node and type of every listener, so that it can be found by its id
+        std::unordered_map<uint32_t, std::pair<Node*, Event::Type>> _listenerIds;
+        uint32_t _lastId = 0;
+        
+        // listeners are not added or erased while the lists are iterated, but after the outermost dispatch
+        uint32_t _dispatchDepth = 0;
+        std::vector<Listener> _pendingListeners;
+        bool _hasRemovedListeners = false;
+    };
+}
@@ -11,6 +11,7 @@ namespace ouzel
     {
     public:
         virtual bool handleEvent(const Event& event) = 0;
+        // called for every simulation step, delta is in seconds
         virtual void update(float delta) = 0;
     };
 }
@@ -0,0 +1,48 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include "EventQueue.h"
+
+namespace ouzel
+{
+    EventQueue::EventQueue():
+        _head(0), _tail(0)
+    {
+        
+    }
+    
+    bool EventQueue::push(const Event& event)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        
+        // the indices wrap around at 2^32, which is a multiple of the capacity
+        if (tail - _head.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        
+        _events[tail % CAPACITY] = event;
+        
+        // publishes the event to the consumer
+        _tail.store(tail + 1, std::memory_order_release);
+        
+        return true;
+    }
+    
+    bool EventQueue::pop(Event& event)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        
+        event = _events[head % CAPACITY];
+        
+        // gives the slot back to the producer
+        _head.store(head + 1, std::memory_order_release);
+        
+        return true;
+    }
+}
@@ -0,0 +1,37 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Noncopyable.h"
+#include "Event.h"
+
+namespace ouzel
+{
+    // ring buffer for one producer thread and one consumer thread, neither of them ever blocks
+    class EventQueue: public Noncopyable
+    {
+    public:
+        static const uint32_t CAPACITY = 1024;
+        
+        EventQueue();
+        
+        // producer side, returns false if the queue is full
+        bool push(const Event& event);
+        
+        // consumer side, returns false if the queue is empty
+        bool pop(Event& event);
+        
+        // consumer side, events pushed meanwhile can make it larger but not smaller
+        uint32_t getSize() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_relaxed); }
+        
+    protected:
+        Event _events[CAPACITY];
+        
+        // on separate cache lines, so that the threads don't invalidate each other's cache
+        alignas(64) std::atomic<uint32_t> _head; // next event to pop, written by the consumer
+        alignas(64) std::atomic<uint32_t> _tail; // next free slot, written by the producer
+    };
+}
@@ -1,9 +1,12 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <cstdio>
+#include <algorithm>
 #include <sys/stat.h>
 #include "CompileConfig.h"
 #include "FileSystem.h"
+#include "Utils.h"
 
 #if defined(OUZEL_PLATFORM_OSX) || defined(OUZEL_PLATFORM_IOS)
 #include <CoreFoundation/CoreFoundation.h>
@@ -21,9 +24,34 @@ namespace ouzel
 	const std::string FileSystem::DIRECTORY_SEPARATOR = "/";
 #endif
     
-	FileSystem::FileSystem()
+	FileSystem::FileSystem(ThreadPool* threadPool):
+        _asyncFileReader(new AsyncFileReader(threadPool))
     {
+        // the application directory doesn't change while running, so it is only queried once
+#if defined(OUZEL_PLATFORM_OSX)
+        CFURLRef appUrlRef = CFBundleCopyBundleURL(CFBundleGetMainBundle());
+        CFStringRef urlString = CFURLCopyPath(appUrlRef);
+        
+        char temporaryCString[1024];
+        
+        CFStringGetCString(urlString, temporaryCString, sizeof(temporaryCString), kCFStringEncodingUTF8);
         
+        CFRelease(appUrlRef);
+        CFRelease(urlString);
+
+		_appPath = std::string(temporaryCString) + "Contents/Resources/";
+#endif
+
+#if defined(OUZEL_PLATFORM_WINDOWS)
+        wchar_t szBuffer[MAX_PATH];
+        GetCurrentDirectoryW(MAX_PATH, szBuffer);
+
+        char temporaryCString[MAX_PATH];
+
+        WideCharToMultiByte(CP_ACP, 0, szBuffer, -1, temporaryCString, sizeof(temporaryCString), nullptr, nullptr);
+
+        _appPath = std::string(temporaryCString) + DIRECTORY_SEPARATOR;
+#endif
     }
     
     FileSystem::~FileSystem()
@@ -41,64 +69,273 @@ namespace ouzel
         return false;
     }
     
-    std::string FileSystem::getPath(const std::string& filename)
+    FileSystem::Location FileSystem::resolve(const std::string& filename)
     {
-		std::string appPath;
-
-#if defined(OUZEL_PLATFORM_OSX)
-        CFURLRef appUrlRef = CFBundleCopyBundleURL(CFBundleGetMainBundle());
-        CFStringRef urlString = CFURLCopyPath(appUrlRef);
-        
-        char temporaryCString[256];
+        std::lock_guard<std::mutex> lock(_mutex);
         
-        CFStringGetCString(urlString, temporaryCString, sizeof(temporaryCString), kCFStringEncodingUTF8);
+        std::unordered_map<std::string, Location>::iterator i = _cache.find(filename);
         
-        CFRelease(appUrlRef);
-        CFRelease(urlString);
-
-		appPath = std::string(temporaryCString) + "Contents/Resources/";
-#endif
-
-#if defined(OUZEL_PLATFORM_WINDOWS)
-        wchar_t szBuffer[256];
-        GetCurrentDirectoryW(256, szBuffer);
-
-        char temporaryCString[256];
-
-        WideCharToMultiByte(CP_ACP, 0, szBuffer, -1, temporaryCString, sizeof(temporaryCString), nullptr, nullptr);
-
-        appPath = std::string(temporaryCString) + DIRECTORY_SEPARATOR;
-#endif
-
-        std::string str = appPath + filename;
-        
-        if (fileExists(str))
+        if (i != _cache.end())
         {
-            return str;
+            return i->second;
         }
-        else
+        
+        Location& location = _cache[filename];
+        
+        for (std::vector<Mount>::reverse_iterator mount = _mounts.rbegin(); mount != _mounts.rend(); ++mount)
         {
-            for (const std::string& path : _resourcePaths)
+            if (mount->archive)
             {
-                str = appPath + DIRECTORY_SEPARATOR + path + DIRECTORY_SEPARATOR + filename;
+                if (mount->archive->hasEntry(filename))
+                {
+                    location.archive = mount->archive;
+                    location.path = filename;
+                    return location;
+                }
+            }
+            else
+            {
+                std::string str = mount->path + DIRECTORY_SEPARATOR + filename;
                 
                 if (fileExists(str))
                 {
-                    return str;
+                    location.path = str;
+                    return location;
                 }
             }
         }
         
-        return "";
+        std::string str = _appPath + filename;
+        
+        if (fileExists(str))
+        {
+            location.path = str;
+            return location;
+        }
+        
+        for (const std::string& path : _resourcePaths)
+        {
+            str = _appPath + DIRECTORY_SEPARATOR + path + DIRECTORY_SEPARATOR + filename;
+            
+            if (fileExists(str))
+            {
+                location.path = str;
+                return location;
+            }
+        }
+        
+        return location;
+    }
+    
+    std::string FileSystem::getPath(const std::string& filename)
+    {
+        Location location = resolve(filename);
+        
+        return location.archive ? "" : location.path;
     }
     
     void FileSystem::addResourcePath(const std::string& path)
     {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
         std::vector<std::string>::iterator i = std::find(_resourcePaths.begin(), _resourcePaths.end(), path);
         
         if (i == _resourcePaths.end())
         {
             _resourcePaths.push_back(path);
+            _cache.clear();
+        }
+    }
+    
+    bool FileSystem::mountDirectory(const std::string& path)
+    {
+        Mount mount;
+        mount.path = isAbsolutePath(path) ? path : _appPath + path;
+        
+        struct stat buf;
+        if (stat(mount.path.c_str(), &buf) == -1 || !(buf.st_mode & S_IFDIR))
+        {
+            log("Failed to mount directory %s", path.c_str());
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        _mounts.push_back(mount);
+        _cache.clear();
+        
+        return true;
+    }
+    
+    bool FileSystem::mountArchive(const std::string& filename)
+    {
+        Mount mount;
+        mount.path = isAbsolutePath(filename) ? filename : getPath(filename);
+        
+        if (mount.path.empty())
+        {
+            log("Failed to find archive %s", filename.c_str());
+            return false;
+        }
+        
+        mount.archive = new Archive();
+        
+        if (!mount.archive->init(mount.path))
+        {
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        _mounts.push_back(mount);
+        _cache.clear();
+        
+        return true;
+    }
+    
+    void FileSystem::unmount(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        std::string fullPath = isAbsolutePath(path) ? path : _appPath + path;
+        
+        std::vector<Mount>::iterator i = std::find_if(_mounts.begin(), _mounts.end(), [&](const Mount& mount) {
+            return mount.path == path || mount.path == fullPath;
+        });
+        
+        if (i != _mounts.end())
+        {
+            _mounts.erase(i);
+            _cache.clear();
+        }
+    }
+    
+    bool FileSystem::readFile(const std::string& filename, std::vector<uint8_t>& data)
+    {
+        Location location = resolve(filename);
+        
+        if (location.archive)
+        {
+            return location.archive->readEntry(location.path, data);
+        }
+        
+        if (location.path.empty())
+        {
+            log("Failed to find file %s", filename.c_str());
+            return false;
+        }
+        
+        FILE* fp = fopen(location.path.c_str(), "rb");
+        
+        if (!fp)
+        {
+            log("Failed to open file %s", filename.c_str());
+            return false;
         }
+        
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        
+        data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+        
+        bool result = data.empty() || fread(data.data(), 1, data.size(), fp) == data.size();
+        
+        fclose(fp);
+        
+        if (!result)
+        {
+            log("Failed to read file %s", filename.c_str());
+        }
+        
+        return result;
+    }
+    
+    void FileSystem::readFileAsync(const std::string& filename, const AsyncFileReader::Callback& callback)
+    {
+        Location location = resolve(filename);
+        
+        if (location.archive)
+        {
+            _asyncFileReader->readEntry(location.archive, location.path, callback);
+        }
+        else if (location.path.empty())
+        {
+            _asyncFileReader->fail(filename, callback);
+        }
+        else
+        {
+            _asyncFileReader->read(location.path, callback);
+        }
+    }
+    
+    void FileSystem::setHotReloadEnabled(bool enabled)
+    {
+        if (!enabled)
+        {
+            _fileWatcher = nullptr;
+        }
+        else if (!_fileWatcher)
+        {
+            _fileWatcher = new FileWatcher();
+        }
+    }
+    
+    uint32_t FileSystem::watchFile(const std::string& filename, const FileWatcher::Callback& callback)
+    {
+        if (!_fileWatcher)
+        {
+            return 0;
+        }
+        
+        std::string path = getPath(filename);
+        
+        return path.empty() ? 0 : _fileWatcher->watch(path, callback);
+    }
+    
+    void FileSystem::unwatchFile(uint32_t id)
+    {
+        if (_fileWatcher && id)
+        {
+            _fileWatcher->unwatch(id);
+        }
+    }
+    
+    void FileSystem::update()
+    {
+        _asyncFileReader->update();
+        
+        if (_fileWatcher)
+        {
+            _fileWatcher->update();
+        }
+    }
+    
+    void FileSystem::clearCache()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        _cache.clear();
+    }
+    
+    std::string FileSystem::getDirectoryPart(const std::string& path)
+    {
+        size_t separatorPosition = path.find_last_of("/\\");
+        
+        if (separatorPosition == std::string::npos)
+        {
+            return "";
+        }
+        
+        return path.substr(0, separatorPosition + 1);
+    }
+    
+    bool FileSystem::isAbsolutePath(const std::string& path)
+    {
+#ifdef OUZEL_PLATFORM_WINDOWS
+        return (path.length() >= 2 && path[1] == ':') || (!path.empty() && (path[0] == '\\' || path[0] == '/'));
+#else
+        return !path.empty() && path[0] == '/';
+#endif
     }
 }
@@ -5,9 +5,16 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <mutex>
 #include "CompileConfig.h"
+#include "AutoPtr.h"
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
+#include "Archive.h"
+#include "ThreadPool.h"
+#include "AsyncFileReader.h"
+#include "FileWatcher.h"
 
 namespace ouzel
 {
@@ -16,16 +23,77 @@ namespace ouzel
     public:
 		static const std::string DIRECTORY_SEPARATOR;
 
-        FileSystem();
+        FileSystem(ThreadPool* threadPool);
         virtual ~FileSystem();
         
+        // path of the file on disk, empty if it doesn't exist or is only in an archive
         std::string getPath(const std::string& filename);
         
+        // relative to the application directory
         void addResourcePath(const std::string& path);
         
+        // mounts are searched before the application directory, the last mounted first,
+        // relative paths are relative to the application directory
+        bool mountDirectory(const std::string& path);
+        bool mountArchive(const std::string& filename);
+        void unmount(const std::string& path);
+        
+        // reads the whole file from a mounted archive or from disk
+        bool readFile(const std::string& filename, std::vector<uint8_t>& data);
+        
+        // the callback is called from update after the file is read without blocking the calling thread
+        void readFileAsync(const std::string& filename, const AsyncFileReader::Callback& callback);
+        AsyncFileReader* getAsyncFileReader() const { return _asyncFileReader; }
+        
+        // loaded resources are reloaded when their files change
+        void setHotReloadEnabled(bool enabled);
+        bool isHotReloadEnabled() const { return _fileWatcher != nullptr; }
+        
+        // returns 0 if hot reload is disabled or the file is in an archive
+        uint32_t watchFile(const std::string& filename, const FileWatcher::Callback& callback);
+        void unwatchFile(uint32_t id);
+        
+        // submits the asynchronous reads, calls the callbacks of the finished ones and of the changed files,
+        // the engine calls it every frame
+        void update();
+        
+        // lookups are cached including the missing files, files created after a lookup are found after clearing the cache
+        void clearCache();
+        
+        const std::string& getAppPath() const { return _appPath; }
+        
+        // directory of the given path including the trailing separator, empty if there is none
+        static std::string getDirectoryPart(const std::string& path);
+        static bool isAbsolutePath(const std::string& path);
+        
     protected:
+        struct Location
+        {
+            // null for files on disk, holds a reference so that the archive outlives reads running while it is unmounted
+            AutoPtr<Archive> archive;
+            // path on disk or name of the entry in the archive, empty if the file was not found
+            std::string path;
+        };
+        
+        struct Mount
+        {
+            std::string path;
+            AutoPtr<Archive> archive;
+        };
+        
         bool fileExists(const std::string& filename);
+        // returns a copy made under the lock
+        Location resolve(const std::string& filename);
         
+        std::string _appPath;
         std::vector<std::string> _resourcePaths;
+        std::vector<Mount> _mounts;
+        
+        // loaders can run on several threads
+        std::mutex _mutex;
+        std::unordered_map<std::string, Location> _cache;
+        
+        AutoPtr<AsyncFileReader> _asyncFileReader;
+        AutoPtr<FileWatcher> _fileWatcher;
     };
 }
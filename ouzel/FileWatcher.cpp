@@ -0,0 +1,177 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <vector>
+#include <unordered_set>
+#include <sys/stat.h>
+#include "FileWatcher.h"
+#include "FileSystem.h"
+#include "Utils.h"
+
+#ifdef OUZEL_PLATFORM_LINUX
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace ouzel
+{
+    FileWatcher::FileWatcher()
+    {
+#ifdef OUZEL_PLATFORM_LINUX
+        _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        
+        if (_inotifyFd < 0)
+        {
+            log("Failed to initialize inotify, changed files are found by polling");
+        }
+#endif
+    }
+    
+    FileWatcher::~FileWatcher()
+    {
+#ifdef OUZEL_PLATFORM_LINUX
+        if (_inotifyFd >= 0)
+        {
+            close(_inotifyFd);
+        }
+#endif
+    }
+    
+    bool FileWatcher::getFileInfo(const std::string& path, int64_t& modifyTime, int64_t& size)
+    {
+        struct stat buf;
+        
+        if (stat(path.c_str(), &buf) == -1)
+        {
+            return false;
+        }
+        
+        modifyTime = static_cast<int64_t>(buf.st_mtime);
+        size = static_cast<int64_t>(buf.st_size);
+        
+        return true;
+    }
+    
+    uint32_t FileWatcher::watch(const std::string& path, const Callback& callback)
+    {
+        Watch watch;
+        watch.path = path;
+        watch.callback = callback;
+        
+        if (!getFileInfo(path, watch.modifyTime, watch.size))
+        {
+            log("Failed to watch file %s", path.c_str());
+            return 0;
+        }
+
+#ifdef OUZEL_PLATFORM_LINUX
+        if (_inotifyFd >= 0)
+        {
+            std::string directory = FileSystem::getDirectoryPart(path);
+            
+            if (_directoryWatches.find(directory) == _directoryWatches.end())
+            {
+                int wd = inotify_add_watch(_inotifyFd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                
+                if (wd < 0)
+                {
+                    log("Failed to watch directory %s", directory.c_str());
+                    return 0;
+                }
+                
+                _directories[wd] = directory;
+                _directoryWatches[directory] = wd;
+            }
+        }
+#endif
+        
+        _watches[++_lastId] = watch;
+        
+        return _lastId;
+    }
+    
+    void FileWatcher::unwatch(uint32_t id)
+    {
+        _watches.erase(id);
+    }
+    
+    void FileWatcher::notify(const std::string& path)
+    {
+        // the callbacks can add and remove watches
+        std::vector<Callback> callbacks;
+        
+        for (std::pair<const uint32_t, Watch>& watch : _watches)
+        {
+            if (watch.second.path == path)
+            {
+                getFileInfo(path, watch.second.modifyTime, watch.second.size);
+                callbacks.push_back(watch.second.callback);
+            }
+        }
+        
+        for (const Callback& callback : callbacks)
+        {
+            callback();
+        }
+    }
+    
+    void FileWatcher::update()
+    {
+        std::unordered_set<std::string> changed;
+
+#ifdef OUZEL_PLATFORM_LINUX
+        if (_inotifyFd >= 0)
+        {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            
+            while ((length = read(_inotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* i = buffer; i < buffer + length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(i);
+                    
+                    std::unordered_map<int, std::string>::const_iterator directory = _directories.find(event->wd);
+                    
+                    if (event->len > 0 && directory != _directories.end())
+                    {
+                        changed.insert(directory->second + event->name);
+                    }
+                    
+                    i += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        else
+#endif
+        {
+            uint64_t currentTime = getCurrentMicroSeconds();
+            
+            if (currentTime - _lastPollTime < POLL_INTERVAL)
+            {
+                return;
+            }
+            
+            _lastPollTime = currentTime;
+            
+            for (const std::pair<const uint32_t, Watch>& watch : _watches)
+            {
+                int64_t modifyTime;
+                int64_t size;
+                
+                // the size catches changes within the same second on file systems with coarse timestamps
+                if (getFileInfo(watch.second.path, modifyTime, size) &&
+                    (modifyTime != watch.second.modifyTime || size != watch.second.size))
+                {
+                    changed.insert(watch.second.path);
+                }
+            }
+        }
+        
+        // several writes to a file during a frame cause only one reload
+        for (const std::string& path : changed)
+        {
+            notify(path);
+        }
+    }
+}
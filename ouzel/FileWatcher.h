@@ -0,0 +1,59 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include "CompileConfig.h"
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+
+namespace ouzel
+{
+    // notifies about changed files, with inotify on Linux and by polling the modification times elsewhere
+    class FileWatcher: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        typedef std::function<void()> Callback;
+        
+        // microseconds between the checks of the modification times
+        static const uint64_t POLL_INTERVAL = 500000;
+        
+        FileWatcher();
+        virtual ~FileWatcher();
+        
+        // returns the id for removing the watch, 0 if the file can't be watched
+        uint32_t watch(const std::string& path, const Callback& callback);
+        void unwatch(uint32_t id);
+        
+        // calls the callbacks of the files that changed since the last update, once per file
+        void update();
+        
+    protected:
+        struct Watch
+        {
+            std::string path;
+            Callback callback;
+            int64_t modifyTime = 0;
+            int64_t size = 0;
+        };
+        
+        static bool getFileInfo(const std::string& path, int64_t& modifyTime, int64_t& size);
+        void notify(const std::string& path);
+        
+        std::unordered_map<uint32_t, Watch> _watches;
+        uint32_t _lastId = 0;
+        
+        uint64_t _lastPollTime = 0;
+
+#ifdef OUZEL_PLATFORM_LINUX
+        int _inotifyFd = -1;
+        // directories are watched instead of the files, because editors often replace a file instead of writing to it
+        std::unordered_map<int, std::string> _directories;
+        std::unordered_map<std::string, int> _directoryWatches;
+#endif
+    };
+}
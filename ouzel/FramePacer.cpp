@@ -0,0 +1,108 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "FramePacer.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    const float FramePacer::MAX_DELTA = 0.25f;
+    const float FramePacer::SMOOTHING = 0.1f;
+    
+    static const uint64_t MIN_SPIN_TIME = 250;
+    
+    FramePacer::FramePacer()
+    {
+        _previousFrameTime = getCurrentMicroSeconds();
+        _nextFrameTime = _previousFrameTime;
+    }
+    
+    FramePacer::~FramePacer()
+    {
+        
+    }
+    
+    void FramePacer::setTargetFPS(float targetFPS)
+    {
+        _targetFPS = targetFPS;
+        _frameInterval = (_targetFPS > 0.0f) ? static_cast<uint64_t>(1000000.0f / _targetFPS) : 0;
+        _nextFrameTime = getCurrentMicroSeconds();
+    }
+    
+    uint64_t FramePacer::getWaitTime() const
+    {
+        if (_frameInterval == 0)
+        {
+            return 0;
+        }
+        
+        uint64_t currentTime = getCurrentMicroSeconds();
+        
+        return (_nextFrameTime > currentTime + _spinTime) ? _nextFrameTime - currentTime - _spinTime : 0;
+    }
+    
+    void FramePacer::waitForNextFrame()
+    {
+        uint64_t currentTime = getCurrentMicroSeconds();
+        
+        if (_frameInterval > 0 && _nextFrameTime > currentTime)
+        {
+            if (_nextFrameTime > currentTime + _spinTime)
+            {
+                uint64_t wakeUpTime = _nextFrameTime - _spinTime;
+                
+                std::this_thread::sleep_for(std::chrono::microseconds(wakeUpTime - currentTime));
+                
+                currentTime = getCurrentMicroSeconds();
+                uint64_t lateness = (currentTime > wakeUpTime) ? currentTime - wakeUpTime : 0;
+                
+                // grow quickly when sleeping overshoots, shrink slowly to save power when it doesn't
+                if (lateness > _spinTime)
+                {
+                    _spinTime = std::min(lateness, _frameInterval / 2);
+                }
+                else
+                {
+                    _spinTime = std::max(MIN_SPIN_TIME, _spinTime - (_spinTime - lateness) / 16);
+                }
+            }
+            
+            while (currentTime < _nextFrameTime)
+            {
+                std::this_thread::yield();
+                currentTime = getCurrentMicroSeconds();
+            }
+        }
+        
+        _delta = static_cast<float>(currentTime - _previousFrameTime) / 1000000.0f;
+        _previousFrameTime = currentTime;
+        
+        float clampedDelta = std::min(_delta, MAX_DELTA);
+        _smoothedDelta = (_frameCount == 0) ? clampedDelta : _smoothedDelta + (clampedDelta - _smoothedDelta) * SMOOTHING;
+        
+        ++_frameCount;
+        
+        if (_frameInterval > 0)
+        {
+            // late frames don't try to catch up, the schedule restarts from the current frame
+            if (currentTime >= _nextFrameTime + _frameInterval)
+            {
+                _missedFrameCount += (currentTime - _nextFrameTime) / _frameInterval;
+                _nextFrameTime = currentTime + _frameInterval;
+            }
+            else
+            {
+                _nextFrameTime += _frameInterval;
+            }
+        }
+    }
+    
+    void FramePacer::resetStatistics()
+    {
+        _frameCount = 0;
+        _missedFrameCount = 0;
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+
+namespace ouzel
+{
+    // limits the frame rate and measures the time between frames
+    class FramePacer: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        FramePacer();
+        virtual ~FramePacer();
+        
+        // 0 runs the frames as fast as the platform loop calls the engine
+        void setTargetFPS(float targetFPS);
+        float getTargetFPS() const { return _targetFPS; }
+        
+        // microseconds until the next frame is due minus the part that is spent spinning,
+        // platform loops can wait this long for input before running the engine
+        uint64_t getWaitTime() const;
+        
+        // sleeps and then spins until the next frame is due
+        void waitForNextFrame();
+        
+        // seconds between the beginnings of the last two frames
+        float getDelta() const { return _delta; }
+        // exponential moving average of the delta, spikes are clamped to MAX_DELTA
+        float getSmoothedDelta() const { return _smoothedDelta; }
+        
+        uint64_t getFrameCount() const { return _frameCount; }
+        // deadlines that passed without a frame being started
+        uint64_t getMissedFrameCount() const { return _missedFrameCount; }
+        void resetStatistics();
+        
+        static const float MAX_DELTA;
+        static const float SMOOTHING;
+        
+    protected:
+        float _targetFPS = 0.0f;
+        uint64_t _frameInterval = 0;
+        uint64_t _nextFrameTime = 0;
+        uint64_t _previousFrameTime = 0;
+        
+        // sleeping wakes up late by up to a scheduler tick, so the time spent spinning adapts to the measured lateness
+        uint64_t _spinTime = 2000;
+        
+        float _delta = 0.0f;
+        float _smoothedDelta = 0.0f;
+        
+        uint64_t _frameCount = 0;
+        uint64_t _missedFrameCount = 0;
+    };
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "AutoPtr.h"
+
+namespace ouzel
+{
+    // index of a slot in the low bits and its generation in the high bits, 0 is never a valid handle
+    template<class T>
+    class Handle
+    {
+    public:
+        static const uint32_t INDEX_BITS = 20;
+        static const uint32_t INDEX_MASK = (1 << INDEX_BITS) - 1;
+        static const uint32_t GENERATION_MASK = (1 << (32 - INDEX_BITS)) - 1;
+        
+        Handle() {}
+        explicit Handle(uint32_t value): _value(value) {}
+        Handle(uint32_t index, uint32_t generation): _value((generation << INDEX_BITS) | index) {}
+        
+        uint32_t getValue() const { return _value; }
+        uint32_t getIndex() const { return _value & INDEX_MASK; }
+        uint32_t getGeneration() const { return _value >> INDEX_BITS; }
+        
+        explicit operator bool() const { return _value != 0; }
+        bool operator == (const Handle& other) const { return _value == other._value; }
+        bool operator != (const Handle& other) const { return _value != other._value; }
+        
+    protected:
+        uint32_t _value = 0;
+    };
+    
+    // holds a reference to each item, the generation of a slot changes when its item is removed, so old handles to it don't resolve
+    template<class T>
+    class HandlePool
+    {
+    public:
+        Handle<T> add(T* item)
+        {
+            uint32_t index;
+            
+            if (!_freeSlots.empty())
+            {
+                index = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else
+            {
+                if (_slots.size() > Handle<T>::INDEX_MASK)
+                {
+                    return Handle<T>();
+                }
+                
+                index = static_cast<uint32_t>(_slots.size());
+                _slots.push_back(Slot());
+            }
+            
+            _slots[index].item = item;
+            
+            return Handle<T>(index, _slots[index].generation);
+        }
+        
+        void remove(Handle<T> handle)
+        {
+            if (!isValid(handle))
+            {
+                return;
+            }
+            
+            Slot& slot = _slots[handle.getIndex()];
+            slot.item = nullptr;
+            slot.generation = (slot.generation + 1) & Handle<T>::GENERATION_MASK;
+            
+            if (slot.generation == 0)
+            {
+                slot.generation = 1;
+            }
+            
+            _freeSlots.push_back(handle.getIndex());
+        }
+        
+        bool isValid(Handle<T> handle) const
+        {
+            return handle &&
+                handle.getIndex() < _slots.size() &&
+                _slots[handle.getIndex()].generation == handle.getGeneration();
+        }
+        
+        // nullptr for a handle whose item has been removed
+        T* get(Handle<T> handle) const
+        {
+            return isValid(handle) ? _slots[handle.getIndex()].item.item : nullptr;
+        }
+        
+    protected:
+        struct Slot
+        {
+            AutoPtr<T> item;
+            uint32_t generation = 1;
+        };
+        
+        std::vector<Slot> _slots;
+        std::vector<uint32_t> _freeSlots;
+    };
+}
@@ -0,0 +1,31 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace ouzel
+{
+    const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+    const uint32_t FNV_PRIME = 16777619u;
+    
+    // 32-bit FNV-1a, string literals are hashed at compile time
+    constexpr uint32_t hashString(const char* str, uint32_t hash = FNV_OFFSET_BASIS)
+    {
+        return *str ? hashString(str + 1, (hash ^ static_cast<uint8_t>(*str)) * FNV_PRIME) : hash;
+    }
+    
+    inline uint32_t hashString(const std::string& str)
+    {
+        uint32_t hash = FNV_OFFSET_BASIS;
+        
+        for (char c : str)
+        {
+            hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+        }
+        
+        return hash;
+    }
+}
@@ -1,15 +1,157 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include "Image.h"
 #include "Utils.h"
 #include "Engine.h"
 #include "FileSystem.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
 
 namespace ouzel
 {
+    static const uint8_t QOI_OP_INDEX = 0x00;
+    static const uint8_t QOI_OP_DIFF = 0x40;
+    static const uint8_t QOI_OP_LUMA = 0x80;
+    static const uint8_t QOI_OP_RUN = 0xC0;
+    static const uint8_t QOI_OP_RGB = 0xFE;
+    static const uint8_t QOI_OP_RGBA = 0xFF;
+    static const uint8_t QOI_MASK = 0xC0;
+    static const uint32_t QOI_HEADER_SIZE = 14;
+    static const uint32_t QOI_PADDING_SIZE = 8;
+    // same limit as the reference decoder
+    static const uint64_t QOI_MAX_PIXELS = 400000000;
+    
+    static bool isQOI(const std::vector<uint8_t>& data)
+    {
+        return data.size() >= QOI_HEADER_SIZE + QOI_PADDING_SIZE &&
+            data[0] == 'q' && data[1] == 'o' && data[2] == 'i' && data[3] == 'f';
+    }
+    
+    static uint32_t readBigEndian(const uint8_t* bytes)
+    {
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+            (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+    }
+    
+    // returns RGBA pixels allocated with malloc, like stb_image does, so both are freed with stbi_image_free
+    static uint8_t* decodeQOI(const std::vector<uint8_t>& data, uint32_t& width, uint32_t& height)
+    {
+        width = readBigEndian(&data[4]);
+        height = readBigEndian(&data[8]);
+        uint8_t channels = data[12];
+        
+        uint64_t pixelCount = static_cast<uint64_t>(width) * height;
+        
+        if (width == 0 || height == 0 || pixelCount > QOI_MAX_PIXELS || (channels != 3 && channels != 4))
+        {
+            return nullptr;
+        }
+        
+        uint8_t* pixels = static_cast<uint8_t*>(malloc(static_cast<size_t>(pixelCount) * 4));
+        
+        if (!pixels)
+        {
+            return nullptr;
+        }
+        
+        uint8_t index[64 * 4] = { 0 };
+        uint8_t r = 0, g = 0, b = 0, a = 255;
+        uint32_t run = 0;
+        
+        const uint8_t* chunk = data.data() + QOI_HEADER_SIZE;
+        // the padding at the end is never read as a chunk
+        const uint8_t* chunksEnd = data.data() + data.size() - QOI_PADDING_SIZE;
+        
+        uint8_t* pixel = pixels;
+        uint8_t* pixelsEnd = pixels + pixelCount * 4;
+        
+        for (; pixel < pixelsEnd; pixel += 4)
+        {
+            if (run > 0)
+            {
+                --run;
+            }
+            else
+            {
+                if (chunk >= chunksEnd)
+                {
+                    free(pixels);
+                    return nullptr;
+                }
+                
+                uint8_t tag = *chunk++;
+                
+                if (tag == QOI_OP_RGB)
+                {
+                    if (chunksEnd - chunk < 3) { free(pixels); return nullptr; }
+                    
+                    r = chunk[0];
+                    g = chunk[1];
+                    b = chunk[2];
+                    chunk += 3;
+                }
+                else if (tag == QOI_OP_RGBA)
+                {
+                    if (chunksEnd - chunk < 4) { free(pixels); return nullptr; }
+                    
+                    r = chunk[0];
+                    g = chunk[1];
+                    b = chunk[2];
+                    a = chunk[3];
+                    chunk += 4;
+                }
+                else if ((tag & QOI_MASK) == QOI_OP_INDEX)
+                {
+                    const uint8_t* color = &index[tag * 4];
+                    r = color[0];
+                    g = color[1];
+                    b = color[2];
+                    a = color[3];
+                }
+                else if ((tag & QOI_MASK) == QOI_OP_DIFF)
+                {
+                    r += ((tag >> 4) & 0x03) - 2;
+                    g += ((tag >> 2) & 0x03) - 2;
+                    b += (tag & 0x03) - 2;
+                }
+                else if ((tag & QOI_MASK) == QOI_OP_LUMA)
+                {
+                    if (chunk >= chunksEnd) { free(pixels); return nullptr; }
+                    
+                    uint8_t next = *chunk++;
+                    int greenDifference = (tag & 0x3F) - 32;
+                    
+                    r += greenDifference - 8 + ((next >> 4) & 0x0F);
+                    g += greenDifference;
+                    b += greenDifference - 8 + (next & 0x0F);
+                }
+                else
+                {
+                    run = tag & 0x3F;
+                }
+                
+                uint8_t* color = &index[((r * 3 + g * 5 + b * 7 + a * 11) % 64) * 4];
+                color[0] = r;
+                color[1] = g;
+                color[2] = b;
+                color[3] = a;
+            }
+            
+            pixel[0] = r;
+            pixel[1] = g;
+            pixel[2] = b;
+            pixel[3] = a;
+        }
+        
+        return pixels;
+    }
+    
     Image::Image(Engine* engine):
         _engine(engine)
     {
@@ -28,16 +170,58 @@ namespace ouzel
     {
         _filename = filename;
         
-        std::string path = _engine->getFileSystem()->getPath(filename);
+        std::vector<uint8_t> data;
+        
+        if (!_engine->getFileSystem()->readFile(filename, data))
+        {
+            log("Failed to open texture file %s", filename.c_str());
+            return false;
+        }
+        
+        if (!loadFromBuffer(data))
+        {
+            log("Failed to decode texture file %s", filename.c_str());
+            return false;
+        }
+        
+        return true;
+    }
+    
+    bool Image::loadFromBuffer(const std::vector<uint8_t>& data)
+    {
+        if (_data)
+        {
+            stbi_image_free(_data);
+            _data = nullptr;
+        }
+        
+        _pixelFormat = PixelFormat::RGBA8;
+        _mipmaps.clear();
+        
+        if (isQOI(data))
+        {
+            uint32_t width;
+            uint32_t height;
+            _data = decodeQOI(data, width, height);
+            
+            if (!_data)
+            {
+                return false;
+            }
+            
+            _size.width = static_cast<float>(width);
+            _size.height = static_cast<float>(height);
+            
+            return true;
+        }
         
         int width;
         int height;
         int comp;
-        _data = stbi_load(path.c_str(), &width, &height, &comp, STBI_rgb_alpha);
+        _data = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &comp, STBI_rgb_alpha);
         
         if (!_data)
         {
-            log("Failed to open texture file %s", filename.c_str());
             return false;
         }
         
@@ -46,4 +230,440 @@ namespace ouzel
         
         return true;
     }
+    
+    bool Image::writePNG(const std::string& path, const Size2& size, const std::vector<uint8_t>& pixels)
+    {
+        int width = static_cast<int>(size.width);
+        int height = static_cast<int>(size.height);
+        
+        if (width <= 0 || height <= 0 || pixels.size() < static_cast<size_t>(width * height * 4))
+        {
+            log("Invalid image data for %s", path.c_str());
+            return false;
+        }
+        
+        if (!stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4))
+        {
+            log("Failed to write image %s", path.c_str());
+            return false;
+        }
+        
+        return true;
+    }
+    
+    // 4x4 Bayer matrix
+    static const uint8_t DITHER_THRESHOLDS[4][4] = {
+        { 0, 8, 2, 10 },
+        { 12, 4, 14, 6 },
+        { 3, 11, 1, 9 },
+        { 15, 7, 13, 5 }
+    };
+    
+    // reduces an 8-bit value to bits, offset is added in 1/32 steps before rounding down, 16 rounds to the nearest value
+    static inline uint32_t quantize(uint8_t value, uint32_t bits, uint32_t offset)
+    {
+        uint32_t levels = (1 << bits) - 1;
+        
+        return (value * levels * 32 + offset * 255) / (255 * 32);
+    }
+    
+    static void convertPixels(const uint8_t* source, const Size2& size, PixelFormat pixelFormat, bool dither, uint8_t* destination)
+    {
+        uint32_t width = static_cast<uint32_t>(size.width);
+        uint32_t height = static_cast<uint32_t>(size.height);
+        
+        uint8_t* bytes = destination;
+        uint16_t* shorts = reinterpret_cast<uint16_t*>(destination);
+        
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x, source += 4)
+            {
+                uint32_t offset = dither ? DITHER_THRESHOLDS[y & 3][x & 3] * 2 + 1 : 16;
+                
+                switch (pixelFormat)
+                {
+                    case PixelFormat::RGB565:
+                        *shorts++ = static_cast<uint16_t>((quantize(source[0], 5, offset) << 11) |
+                                                          (quantize(source[1], 6, offset) << 5) |
+                                                          quantize(source[2], 5, offset));
+                        break;
+                    case PixelFormat::RGBA4444:
+                        *shorts++ = static_cast<uint16_t>((quantize(source[0], 4, offset) << 12) |
+                                                          (quantize(source[1], 4, offset) << 8) |
+                                                          (quantize(source[2], 4, offset) << 4) |
+                                                          quantize(source[3], 4, offset));
+                        break;
+                    case PixelFormat::RGBA5551:
+                        // dithered alpha would make the edges noisy
+                        *shorts++ = static_cast<uint16_t>((quantize(source[0], 5, offset) << 11) |
+                                                          (quantize(source[1], 5, offset) << 6) |
+                                                          (quantize(source[2], 5, offset) << 1) |
+                                                          (source[3] >= 128 ? 1 : 0));
+                        break;
+                    case PixelFormat::A8:
+                        *bytes++ = source[3];
+                        break;
+                    case PixelFormat::L8:
+                        // Rec. 601 luma
+                        *bytes++ = static_cast<uint8_t>((source[0] * 77 + source[1] * 150 + source[2] * 29 + 128) >> 8);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+    
+    bool Image::convert(PixelFormat pixelFormat, bool dither)
+    {
+        if (!_data || _pixelFormat != PixelFormat::RGBA8)
+        {
+            return false;
+        }
+        
+        if (pixelFormat == PixelFormat::RGBA8)
+        {
+            return true;
+        }
+        
+        uint32_t pixelSize = getPixelSize(pixelFormat);
+        
+        uint8_t* pixels = static_cast<uint8_t*>(malloc(static_cast<size_t>(_size.width) * static_cast<size_t>(_size.height) * pixelSize));
+        
+        if (!pixels)
+        {
+            return false;
+        }
+        
+        convertPixels(_data, _size, pixelFormat, dither, pixels);
+        
+        stbi_image_free(_data);
+        _data = pixels;
+        
+        for (Mipmap& mipmap : _mipmaps)
+        {
+            std::vector<uint8_t> data(static_cast<size_t>(mipmap.size.width) * static_cast<size_t>(mipmap.size.height) * pixelSize);
+            convertPixels(mipmap.data.data(), mipmap.size, pixelFormat, dither, data.data());
+            mipmap.data.swap(data);
+        }
+        
+        _pixelFormat = pixelFormat;
+        
+        return true;
+    }
+    
+    // conversion between sRGB and linear values, built before main so that worker threads can use them
+    static struct GammaTables
+    {
+        GammaTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                float value = i / 255.0f;
+                toLinear[i] = (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+            }
+            
+            for (uint32_t i = 0; i < 4096; ++i)
+            {
+                float value = i / 4095.0f;
+                value = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+                toSRGB[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+        
+        float toLinear[256];
+        // indexed by the linear value in 1/4095 steps
+        uint8_t toSRGB[4096];
+    } gammaTables;
+    
+    bool Image::generateMipmaps()
+    {
+        if (!_data || _pixelFormat != PixelFormat::RGBA8)
+        {
+            return false;
+        }
+        
+        _mipmaps.clear();
+        
+        const uint8_t* source = _data;
+        uint32_t sourceWidth = static_cast<uint32_t>(_size.width);
+        uint32_t sourceHeight = static_cast<uint32_t>(_size.height);
+        
+        // the previous level is read while the next one is added, so the levels must not be reallocated
+        uint32_t levels = 0;
+        
+        for (uint32_t size = std::max(sourceWidth, sourceHeight); size > 1; size /= 2)
+        {
+            ++levels;
+        }
+        
+        _mipmaps.reserve(levels);
+        
+        while (sourceWidth > 1 || sourceHeight > 1)
+        {
+            uint32_t width = std::max(sourceWidth / 2, 1U);
+            uint32_t height = std::max(sourceHeight / 2, 1U);
+            
+            Mipmap mipmap;
+            mipmap.size = Size2(static_cast<float>(width), static_cast<float>(height));
+            mipmap.data.resize(static_cast<size_t>(width) * height * 4);
+            
+            uint8_t* destination = mipmap.data.data();
+            
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                // the last row and column of odd sizes are skipped
+                const uint8_t* row0 = source + static_cast<size_t>(std::min(y * 2, sourceHeight - 1)) * sourceWidth * 4;
+                const uint8_t* row1 = source + static_cast<size_t>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceWidth * 4;
+                
+                for (uint32_t x = 0; x < width; ++x, destination += 4)
+                {
+                    uint32_t x0 = std::min(x * 2, sourceWidth - 1) * 4;
+                    uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1) * 4;
+                    const uint8_t* pixels[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+                    
+                    float color[3] = { 0.0f, 0.0f, 0.0f };
+                    uint32_t alpha = 0;
+                    
+                    for (const uint8_t* pixel : pixels)
+                    {
+                        for (uint32_t c = 0; c < 3; ++c)
+                        {
+                            color[c] += gammaTables.toLinear[pixel[c]] * pixel[3];
+                        }
+                        
+                        alpha += pixel[3];
+                    }
+                    
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        // fully transparent pixels keep an unweighted average
+                        float linear = alpha ? color[c] / alpha :
+                            (gammaTables.toLinear[pixels[0][c]] + gammaTables.toLinear[pixels[1][c]] +
+                             gammaTables.toLinear[pixels[2][c]] + gammaTables.toLinear[pixels[3][c]]) / 4.0f;
+                        
+                        destination[c] = gammaTables.toSRGB[static_cast<uint32_t>(linear * 4095.0f + 0.5f)];
+                    }
+                    
+                    destination[3] = static_cast<uint8_t>((alpha + 2) / 4);
+                }
+            }
+            
+            _mipmaps.push_back(std::move(mipmap));
+            
+            source = _mipmaps.back().data.data();
+            sourceWidth = width;
+            sourceHeight = height;
+        }
+        
+        return true;
+    }
+    
+    PixelFormat Image::getSuggestedPixelFormat() const
+    {
+        if (!_data || _pixelFormat != PixelFormat::RGBA8)
+        {
+            return _pixelFormat;
+        }
+        
+        bool opaque = true;
+        bool gray = true;
+        bool white = true;
+        bool binaryAlpha = true;
+        
+        size_t pixelCount = static_cast<size_t>(_size.width) * static_cast<size_t>(_size.height);
+        
+        for (const uint8_t* pixel = _data; pixel < _data + pixelCount * 4; pixel += 4)
+        {
+            if (pixel[3] != 0xFF) opaque = false;
+            if (pixel[3] != 0x00 && pixel[3] != 0xFF) binaryAlpha = false;
+            if (pixel[0] != pixel[1] || pixel[1] != pixel[2]) gray = false;
+            // color of fully transparent pixels is never seen
+            if (pixel[3] != 0x00 && (pixel[0] & pixel[1] & pixel[2]) != 0xFF) white = false;
+        }
+        
+        if (opaque)
+        {
+            return gray ? PixelFormat::L8 : PixelFormat::RGB565;
+        }
+        else if (white)
+        {
+            return PixelFormat::A8;
+        }
+        else if (binaryAlpha)
+        {
+            return PixelFormat::RGBA5551;
+        }
+        
+        return PixelFormat::RGBA8;
+    }
+    
+    uint8_t Image::getAlpha(size_t pixel) const
+    {
+        switch (_pixelFormat)
+        {
+            case PixelFormat::RGBA8: return _data[pixel * 4 + 3];
+            case PixelFormat::RGBA4444: return static_cast<uint8_t>((reinterpret_cast<const uint16_t*>(_data)[pixel] & 0x0F) * 17);
+            case PixelFormat::RGBA5551: return (reinterpret_cast<const uint16_t*>(_data)[pixel] & 0x01) ? 0xFF : 0x00;
+            case PixelFormat::A8: return _data[pixel];
+            default: return 0xFF;
+        }
+    }
+    
+    bool Image::isOpaque() const
+    {
+        if (!_data)
+        {
+            return false;
+        }
+        
+        if (_pixelFormat == PixelFormat::RGB565 || _pixelFormat == PixelFormat::L8)
+        {
+            return true;
+        }
+        
+        size_t pixelCount = static_cast<size_t>(_size.width) * static_cast<size_t>(_size.height);
+        
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            if (getAlpha(i) != 0xFF)
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    static float cross(const Vector2& o, const Vector2& a, const Vector2& b)
+    {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+    
+    bool Image::getAlphaHull(std::vector<Vector2>& hull, uint8_t threshold, uint32_t maxVertices) const
+    {
+        hull.clear();
+        
+        if (!_data)
+        {
+            return false;
+        }
+        
+        uint32_t width = static_cast<uint32_t>(_size.width);
+        uint32_t height = static_cast<uint32_t>(_size.height);
+        
+        // corners of the leftmost and rightmost opaque pixel of every row, already sorted by y
+        std::vector<Vector2> points;
+        
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            size_t row = static_cast<size_t>(y) * width;
+            
+            uint32_t left = 0;
+            while (left < width && getAlpha(row + left) <= threshold) ++left;
+            
+            if (left == width)
+            {
+                continue;
+            }
+            
+            uint32_t right = width - 1;
+            while (getAlpha(row + right) <= threshold) --right;
+            
+            points.push_back(Vector2(static_cast<float>(left), static_cast<float>(y)));
+            points.push_back(Vector2(static_cast<float>(left), static_cast<float>(y + 1)));
+            points.push_back(Vector2(static_cast<float>(right + 1), static_cast<float>(y)));
+            points.push_back(Vector2(static_cast<float>(right + 1), static_cast<float>(y + 1)));
+        }
+        
+        if (points.empty())
+        {
+            return false;
+        }
+        
+        // monotone chain convex hull
+        std::sort(points.begin(), points.end(), [](const Vector2& a, const Vector2& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+        
+        hull.resize(points.size() * 2);
+        size_t count = 0;
+        
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            while (count >= 2 && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f) --count;
+            hull[count++] = points[i];
+        }
+        
+        for (size_t i = points.size() - 1, lower = count + 1; i > 0; --i)
+        {
+            while (count >= lower && cross(hull[count - 2], hull[count - 1], points[i - 1]) <= 0.0f) --count;
+            hull[count++] = points[i - 1];
+        }
+        
+        hull.resize(count - 1);
+        
+        // remove edges by extending their neighbours until they meet, always picking the one that adds the least area,
+        // the polygon only grows so it still covers all the pixels
+        while (hull.size() > maxVertices && hull.size() > 3)
+        {
+            size_t bestEdge = hull.size();
+            float bestArea = INFINITY;
+            Vector2 bestPoint;
+            
+            for (size_t i = 0; i < hull.size(); ++i)
+            {
+                const Vector2& previous = hull[(i + hull.size() - 1) % hull.size()];
+                const Vector2& start = hull[i];
+                const Vector2& end = hull[(i + 1) % hull.size()];
+                const Vector2& next = hull[(i + 2) % hull.size()];
+                
+                Vector2 d0(start.x - previous.x, start.y - previous.y);
+                Vector2 d1(next.x - end.x, next.y - end.y);
+                Vector2 e(end.x - start.x, end.y - start.y);
+                
+                float denominator = d0.x * d1.y - d0.y * d1.x;
+                
+                // neighbouring edges turn by 180 degrees or more and never meet
+                if (denominator <= 0.0f)
+                {
+                    continue;
+                }
+                
+                float t = (e.x * d1.y - e.y * d1.x) / denominator;
+                
+                if (t < 0.0f)
+                {
+                    continue;
+                }
+                
+                Vector2 point(start.x + d0.x * t, start.y + d0.y * t);
+                
+                if (point.x < 0.0f || point.y < 0.0f || point.x > _size.width || point.y > _size.height)
+                {
+                    continue;
+                }
+                
+                float area = fabsf(cross(start, end, point)) / 2.0f;
+                
+                if (area < bestArea)
+                {
+                    bestArea = area;
+                    bestEdge = i;
+                    bestPoint = point;
+                }
+            }
+            
+            if (bestEdge == hull.size())
+            {
+                break;
+            }
+            
+            hull[bestEdge] = bestPoint;
+            hull.erase(hull.begin() + static_cast<std::ptrdiff_t>((bestEdge + 1) % hull.size()));
+        }
+        
+        return hull.size() >= 3;
+    }
 }
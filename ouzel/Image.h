@@ -4,9 +4,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
 #include "Size2.h"
+#include "Vector2.h"
+#include "PixelFormat.h"
 
 namespace ouzel
 {
@@ -18,16 +21,57 @@ namespace ouzel
         Image(Engine* engine);
         virtual ~Image();
         
+        const std::string& getFilename() const { return _filename; }
         const Size2& getSize() const { return _size; }
         const uint8_t* getData() const { return _data; }
+        PixelFormat getPixelFormat() const { return _pixelFormat; }
         
+        // level 0 is the image itself, each next level is half the size of the previous one down to 1x1
+        uint32_t getMipmapCount() const { return static_cast<uint32_t>(_mipmaps.size()) + 1; }
+        const Size2& getMipmapSize(uint32_t level) const { return level ? _mipmaps[level - 1].size : _size; }
+        const uint8_t* getMipmapData(uint32_t level) const { return level ? _mipmaps[level - 1].data.data() : _data; }
+        
+        // can be called from any thread, as long as the image is not used by others meanwhile
         virtual bool loadFromFile(const std::string& filename);
+        // decodes QOI itself and the other formats with stb_image, the pixels are always RGBA
+        virtual bool loadFromBuffer(const std::vector<uint8_t>& data);
+        
+        // writes RGBA pixels with the top row first, can be called from any thread
+        static bool writePNG(const std::string& path, const Size2& size, const std::vector<uint8_t>& pixels);
+        
+        // averages the colors in linear space and weights them by alpha, so that the smaller levels keep their brightness
+        // and transparent pixels don't darken the edges, has to be called before converting the pixel format
+        bool generateMipmaps();
+        
+        // converts RGBA8 pixels including the mipmaps, ordered dithering hides the banding of the 4 and 5 bit channels
+        bool convert(PixelFormat pixelFormat, bool dither = true);
+        
+        // smallest format that keeps the image as it is, or nearly for opaque images (RGB565)
+        // and images that only have fully transparent and fully opaque pixels (RGBA5551)
+        PixelFormat getSuggestedPixelFormat() const;
+        
+        // true if every pixel has full alpha
+        bool isOpaque() const;
+        
+        // convex polygon in pixel coordinates (origin at the top left) that contains every pixel with alpha above the threshold,
+        // simplified to at most maxVertices without uncovering any of them
+        bool getAlphaHull(std::vector<Vector2>& hull, uint8_t threshold = 0, uint32_t maxVertices = 8) const;
         
     protected:
+        uint8_t getAlpha(size_t pixel) const;
+        
+        struct Mipmap
+        {
+            Size2 size;
+            std::vector<uint8_t> data;
+        };
+        
         Engine* _engine;
         std::string _filename;
         Size2 _size;
         
         uint8_t* _data = nullptr;
+        PixelFormat _pixelFormat = PixelFormat::RGBA8;
+        std::vector<Mipmap> _mipmaps;
     };
 }
@@ -0,0 +1,312 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <cstring>
+#include "InputRecorder.h"
+#include "Engine.h"
+#include "FileSystem.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    static const uint8_t MAGIC[4] = { 'O', 'I', 'N', 'P' };
+    // record kind after the event types
+    static const uint8_t END_RECORD = 0xFF;
+    
+    // the file is little-endian on every platform
+    template<typename T> static void writeValue(std::vector<uint8_t>& buffer, T value)
+    {
+        for (uint32_t i = 0; i < sizeof(T); ++i)
+        {
+            buffer.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8)));
+        }
+    }
+    
+    static void writeFloat(std::vector<uint8_t>& buffer, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        writeValue(buffer, bits);
+    }
+    
+    template<typename T> static bool readValue(const std::vector<uint8_t>& buffer, size_t& offset, T& value)
+    {
+        if (offset + sizeof(T) > buffer.size())
+        {
+            return false;
+        }
+        
+        uint64_t result = 0;
+        
+        for (uint32_t i = 0; i < sizeof(T); ++i)
+        {
+            result |= static_cast<uint64_t>(buffer[offset++]) << (i * 8);
+        }
+        
+        value = static_cast<T>(result);
+        
+        return true;
+    }
+    
+    static bool readFloat(const std::vector<uint8_t>& buffer, size_t& offset, float& value)
+    {
+        uint32_t bits;
+        
+        if (!readValue(buffer, offset, bits))
+        {
+            return false;
+        }
+        
+        memcpy(&value, &bits, sizeof(value));
+        
+        return true;
+    }
+    
+    InputRecorder::InputRecorder(Engine* engine):
+        _engine(engine)
+    {
+        
+    }
+    
+    InputRecorder::~InputRecorder()
+    {
+        if (_file)
+        {
+            fclose(_file);
+        }
+    }
+    
+    bool InputRecorder::startRecording(const std::string& filename, float fixedTimeStep, uint64_t step, uint64_t frame)
+    {
+        if (_file || _replaying)
+        {
+            log("Input is already being recorded or replayed");
+            return false;
+        }
+        
+        if (fixedTimeStep <= 0.0f)
+        {
+            log("Input can only be recorded with a fixed time step");
+            return false;
+        }
+        
+        _file = fopen(filename.c_str(), "wb");
+        
+        if (!_file)
+        {
+            log("Failed to open input recording file %s", filename.c_str());
+            return false;
+        }
+        
+        _startStep = step;
+        _startFrame = frame;
+        _startTime = getCurrentMicroSeconds();
+        
+        _buffer.clear();
+        _buffer.insert(_buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+        writeValue(_buffer, VERSION);
+        writeFloat(_buffer, fixedTimeStep);
+        
+        return true;
+    }
+    
+    void InputRecorder::stopRecording(uint64_t step)
+    {
+        if (!_file)
+        {
+            return;
+        }
+        
+        _buffer.push_back(END_RECORD);
+        writeValue(_buffer, static_cast<uint32_t>(step - _startStep));
+        
+        if (fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size())
+        {
+            log("Failed to write input recording");
+        }
+        
+        fclose(_file);
+        _file = nullptr;
+        _buffer.clear();
+    }
+    
+    void InputRecorder::recordEvent(const Event& event, uint64_t step, uint64_t frame)
+    {
+        if (!_file)
+        {
+            return;
+        }
+        
+        _buffer.push_back(static_cast<uint8_t>(event.getType()));
+        writeValue(_buffer, static_cast<uint32_t>(step - _startStep));
+        writeValue(_buffer, static_cast<uint32_t>(frame - _startFrame));
+        writeValue(_buffer, getCurrentMicroSeconds() - _startTime);
+        writeValue(_buffer, static_cast<uint8_t>(event.modifiers));
+        
+        if (event.isMouseEvent())
+        {
+            writeValue(_buffer, static_cast<uint8_t>(event.mouseEvent.button));
+            writeFloat(_buffer, event.mouseEvent.position.x);
+            writeFloat(_buffer, event.mouseEvent.position.y);
+            writeFloat(_buffer, event.mouseEvent.scroll.x);
+            writeFloat(_buffer, event.mouseEvent.scroll.y);
+        }
+        else
+        {
+            writeValue(_buffer, static_cast<uint16_t>(event.keyboardEvent.key));
+        }
+        
+        // written in blocks, so that recording doesn't touch the file every frame
+        if (_buffer.size() >= sizeof(TEMP_BUFFER))
+        {
+            if (fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size())
+            {
+                log("Failed to write input recording");
+            }
+            
+            _buffer.clear();
+        }
+    }
+    
+    bool InputRecorder::startReplay(const std::string& filename)
+    {
+        if (_file || _replaying)
+        {
+            log("Input is already being recorded or replayed");
+            return false;
+        }
+        
+        // recordings can be shipped as resources or read from where they were written
+        std::string path = _engine->getFileSystem()->getPath(filename);
+        
+        FILE* fp = fopen(path.empty() ? filename.c_str() : path.c_str(), "rb");
+        
+        if (!fp)
+        {
+            log("Failed to open input recording file %s", filename.c_str());
+            return false;
+        }
+        
+        std::vector<uint8_t> data;
+        size_t size;
+        
+        while ((size = fread(TEMP_BUFFER, 1, sizeof(TEMP_BUFFER), fp)) > 0)
+        {
+            data.insert(data.end(), TEMP_BUFFER, TEMP_BUFFER + size);
+        }
+        
+        fclose(fp);
+        
+        size_t offset = sizeof(MAGIC);
+        uint32_t version;
+        
+        if (data.size() < sizeof(MAGIC) || memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+            !readValue(data, offset, version) || version != VERSION ||
+            !readFloat(data, offset, _replayFixedTimeStep) || _replayFixedTimeStep <= 0.0f)
+        {
+            log("Invalid input recording file %s", filename.c_str());
+            return false;
+        }
+        
+        _records.clear();
+        _nextRecord = 0;
+        
+        for (;;)
+        {
+            uint8_t kind;
+            
+            if (!readValue(data, offset, kind))
+            {
+                log("Input recording file %s is truncated", filename.c_str());
+                return false;
+            }
+            
+            if (kind == END_RECORD)
+            {
+                if (!readValue(data, offset, _lastStep))
+                {
+                    log("Input recording file %s is truncated", filename.c_str());
+                    return false;
+                }
+                
+                break;
+            }
+            
+            if (kind > static_cast<uint8_t>(Event::Type::MOUSE_DRAG))
+            {
+                log("Invalid event in input recording file %s", filename.c_str());
+                return false;
+            }
+            
+            Record record;
+            record.event = Event(static_cast<Event::Type>(kind));
+            
+            uint8_t modifiers;
+            bool result = readValue(data, offset, record.step) &&
+                readValue(data, offset, record.frame) &&
+                readValue(data, offset, record.timestamp) &&
+                readValue(data, offset, modifiers);
+            
+            record.event.modifiers = modifiers;
+            
+            if (record.event.isMouseEvent())
+            {
+                uint8_t button;
+                result = result && readValue(data, offset, button) &&
+                    readFloat(data, offset, record.event.mouseEvent.position.x) &&
+                    readFloat(data, offset, record.event.mouseEvent.position.y) &&
+                    readFloat(data, offset, record.event.mouseEvent.scroll.x) &&
+                    readFloat(data, offset, record.event.mouseEvent.scroll.y);
+                
+                record.event.mouseEvent.button = static_cast<MouseButton>(button);
+            }
+            else
+            {
+                uint16_t key;
+                result = result && readValue(data, offset, key);
+                
+                record.event.keyboardEvent.key = static_cast<KeyboardKey>(key);
+            }
+            
+            if (!result)
+            {
+                log("Input recording file %s is truncated", filename.c_str());
+                return false;
+            }
+            
+            _records.push_back(record);
+        }
+        
+        _replaying = true;
+        
+        return true;
+    }
+    
+    void InputRecorder::stopReplay()
+    {
+        _replaying = false;
+        _records.clear();
+        _nextRecord = 0;
+    }
+    
+    void InputRecorder::getReplayEvents(uint64_t step, std::vector<Event>& events)
+    {
+        events.clear();
+        
+        if (!_replaying)
+        {
+            return;
+        }
+        
+        while (_nextRecord < _records.size() && _records[_nextRecord].step <= step)
+        {
+            events.push_back(_records[_nextRecord].event);
+            ++_nextRecord;
+        }
+        
+        if (_nextRecord >= _records.size() && step >= _lastStep)
+        {
+            stopReplay();
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "Event.h"
+
+namespace ouzel
+{
+    class Engine;
+    
+    // writes the dispatched events to a binary file and reads them back for a replay,
+    // events are keyed by the simulation step, so a replay with the same fixed time step is deterministic
+    class InputRecorder: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        InputRecorder(Engine* engine);
+        virtual ~InputRecorder();
+        
+        bool startRecording(const std::string& filename, float fixedTimeStep, uint64_t step, uint64_t frame);
+        // the final step is written, so that the replay runs as long as the recorded session
+        void stopRecording(uint64_t step);
+        bool isRecording() const { return _file != nullptr; }
+        
+        void recordEvent(const Event& event, uint64_t step, uint64_t frame);
+        
+        bool startReplay(const std::string& filename);
+        void stopReplay();
+        bool isReplaying() const { return _replaying; }
+        
+        float getReplayFixedTimeStep() const { return _replayFixedTimeStep; }
+        
+        // returns the events recorded before the given step, the replay stops after the last recorded step
+        void getReplayEvents(uint64_t step, std::vector<Event>& events);
+        
+        static const uint32_t VERSION = 1;
+        
+    protected:
+        struct Record
+        {
+            uint32_t step = 0;
+            uint32_t frame = 0;
+            uint64_t timestamp = 0;
+            Event event;
+        };
+        
+        Engine* _engine;
+        
+        FILE* _file = nullptr;
+        uint64_t _startStep = 0;
+        uint64_t _startFrame = 0;
+        uint64_t _startTime = 0;
+        std::vector<uint8_t> _buffer;
+        
+        bool _replaying = false;
+        float _replayFixedTimeStep = 0.0f;
+        std::vector<Record> _records;
+        size_t _nextRecord = 0;
+        uint32_t _lastStep = 0;
+    };
+}
@@ -1,10 +1,39 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "MeshBuffer.h"
+#include "Utils.h"
 
 namespace ouzel
 {
+    static void getPosition(const uint8_t* vertex, const VertexAttribute& attribute, float& x, float& y)
+    {
+        const uint8_t* data = vertex + attribute.offset;
+        
+        switch (attribute.type)
+        {
+            case VertexAttributeType::FLOAT:
+                x = reinterpret_cast<const float*>(data)[0];
+                y = reinterpret_cast<const float*>(data)[1];
+                break;
+            case VertexAttributeType::UNSIGNED_BYTE_NORM:
+                x = data[0] / 255.0f;
+                y = data[1] / 255.0f;
+                break;
+            case VertexAttributeType::SHORT:
+                x = reinterpret_cast<const int16_t*>(data)[0];
+                y = reinterpret_cast<const int16_t*>(data)[1];
+                break;
+            case VertexAttributeType::UNSIGNED_SHORT_NORM:
+                x = reinterpret_cast<const uint16_t*>(data)[0] / 65535.0f;
+                y = reinterpret_cast<const uint16_t*>(data)[1] / 65535.0f;
+                break;
+        }
+    }
+    
     MeshBuffer::MeshBuffer(Renderer* renderer):
         _renderer(renderer)
     {
@@ -16,8 +45,214 @@ namespace ouzel
         
     }
     
-    bool MeshBuffer::initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    bool MeshBuffer::initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                  const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
+    {
+        if (indexSize != 2 && indexSize != 4)
+        {
+            log("Invalid index size %u", indexSize);
+            return false;
+        }
+        
+        const VertexAttribute* positionAttribute = vertexFormat.getAttribute(VertexUsage::POSITION);
+        
+        if (!positionAttribute || positionAttribute->components < 2)
+        {
+            log("Vertex format has no position");
+            return false;
+        }
+        
+        _dynamic = dynamic;
+        _indexSize = indexSize;
+        _indexCount = indexCount;
+        _vertexFormat = vertexFormat;
+        _vertexCount = vertexCount;
+        
+        if (_dynamic)
+        {
+            _indexData.assign(static_cast<const uint8_t*>(indices), static_cast<const uint8_t*>(indices) + indexCount * indexSize);
+            _vertexData.assign(static_cast<const uint8_t*>(vertices), static_cast<const uint8_t*>(vertices) + vertexCount * vertexFormat.getStride());
+            
+            // the initial data is uploaded on creation
+            _indexDirtyStart = _vertexDirtyStart = UINT32_MAX;
+            _indexDirtyEnd = _vertexDirtyEnd = 0;
+        }
+        
+        calculateArea(indices, vertices);
+        
+        return true;
+    }
+    
+    bool MeshBuffer::setIndices(const void* indices, uint32_t indexCount)
     {
+        if (!_dynamic)
+        {
+            log("Mesh buffer is not dynamic");
+            return false;
+        }
+        
+        _indexCount = indexCount;
+        _indexData.assign(static_cast<const uint8_t*>(indices), static_cast<const uint8_t*>(indices) + indexCount * _indexSize);
+        
+        _indexDirtyStart = 0;
+        _indexDirtyEnd = static_cast<uint32_t>(_indexData.size());
+        _areaDirty = true;
+        
         return true;
     }
-}
\ No newline at end of file
+    
+    bool MeshBuffer::setVertices(const void* vertices, uint32_t vertexCount)
+    {
+        if (!_dynamic)
+        {
+            log("Mesh buffer is not dynamic");
+            return false;
+        }
+        
+        _vertexCount = vertexCount;
+        _vertexData.assign(static_cast<const uint8_t*>(vertices), static_cast<const uint8_t*>(vertices) + vertexCount * _vertexFormat.getStride());
+        
+        _vertexDirtyStart = 0;
+        _vertexDirtyEnd = static_cast<uint32_t>(_vertexData.size());
+        _areaDirty = true;
+        
+        return true;
+    }
+    
+    bool MeshBuffer::setIndices(const std::vector<uint16_t>& indices)
+    {
+        if (_indexSize != sizeof(uint16_t))
+        {
+            log("Mesh buffer does not have 16-bit indices");
+            return false;
+        }
+        
+        return setIndices(indices.data(), static_cast<uint32_t>(indices.size()));
+    }
+    
+    bool MeshBuffer::setIndices(const std::vector<uint32_t>& indices)
+    {
+        if (_indexSize != sizeof(uint32_t))
+        {
+            log("Mesh buffer does not have 32-bit indices");
+            return false;
+        }
+        
+        return setIndices(indices.data(), static_cast<uint32_t>(indices.size()));
+    }
+    
+    bool MeshBuffer::setVertices(const std::vector<Vertex>& vertices)
+    {
+        if (_vertexFormat != VertexFormat::getDefault())
+        {
+            log("Mesh buffer does not have the default vertex format");
+            return false;
+        }
+        
+        return setVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+    }
+    
+    bool MeshBuffer::updateIndices(uint32_t firstIndex, const void* indices, uint32_t indexCount)
+    {
+        if (!_dynamic)
+        {
+            log("Mesh buffer is not dynamic");
+            return false;
+        }
+        
+        if (firstIndex + indexCount > _indexCount)
+        {
+            log("Index range is out of the bounds of the mesh buffer");
+            return false;
+        }
+        
+        uint32_t start = firstIndex * _indexSize;
+        uint32_t end = start + indexCount * _indexSize;
+        
+        memcpy(_indexData.data() + start, indices, end - start);
+        
+        _indexDirtyStart = std::min(_indexDirtyStart, start);
+        _indexDirtyEnd = std::max(_indexDirtyEnd, end);
+        _areaDirty = true;
+        
+        return true;
+    }
+    
+    bool MeshBuffer::updateVertices(uint32_t firstVertex, const void* vertices, uint32_t vertexCount)
+    {
+        if (!_dynamic)
+        {
+            log("Mesh buffer is not dynamic");
+            return false;
+        }
+        
+        if (firstVertex + vertexCount > _vertexCount)
+        {
+            log("Vertex range is out of the bounds of the mesh buffer");
+            return false;
+        }
+        
+        uint32_t start = firstVertex * _vertexFormat.getStride();
+        uint32_t end = start + vertexCount * _vertexFormat.getStride();
+        
+        memcpy(_vertexData.data() + start, vertices, end - start);
+        
+        _vertexDirtyStart = std::min(_vertexDirtyStart, start);
+        _vertexDirtyEnd = std::max(_vertexDirtyEnd, end);
+        _areaDirty = true;
+        
+        return true;
+    }
+    
+    float MeshBuffer::getArea() const
+    {
+        // dynamic mesh buffers can change many times before they are drawn, so the area is calculated only when needed
+        if (_areaDirty)
+        {
+            calculateArea(_indexData.data(), _vertexData.data());
+        }
+        
+        return _area;
+    }
+    
+    void MeshBuffer::calculateArea(const void* indices, const void* vertices) const
+    {
+        _area = 0.0f;
+        _areaDirty = false;
+        
+        const VertexAttribute* positionAttribute = _vertexFormat.getAttribute(VertexUsage::POSITION);
+        const uint8_t* vertexData = static_cast<const uint8_t*>(vertices);
+        
+        for (uint32_t i = 0; i + 2 < _indexCount; i += 3)
+        {
+            float x[3];
+            float y[3];
+            
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                uint32_t index = (_indexSize == 2) ? static_cast<const uint16_t*>(indices)[i + j] : static_cast<const uint32_t*>(indices)[i + j];
+                
+                if (index >= _vertexCount)
+                {
+                    return;
+                }
+                
+                getPosition(vertexData + index * _vertexFormat.getStride(), *positionAttribute, x[j], y[j]);
+            }
+            
+            _area += fabsf((x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0])) / 2.0f;
+        }
+    }
+    
+    bool MeshBuffer::initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices, bool dynamic)
+    {
+        return initFromData(indices.data(), sizeof(uint16_t), static_cast<uint32_t>(indices.size()),
+                            vertices.data(), VertexFormat::getDefault(), static_cast<uint32_t>(vertices.size()), dynamic);
+    }
+    
+    bool MeshBuffer::initFromData(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, bool dynamic)
+    {
+        return initFromData(indices.data(), sizeof(uint32_t), static_cast<uint32_t>(indices.size()),
+                            vertices.data(), VertexFormat::getDefault(), static_cast<uint32_t>(vertices.size()), dynamic);
+    }
+}
@@ -4,9 +4,11 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
 #include "Vertex.h"
+#include "VertexFormat.h"
 
 namespace ouzel
 {
@@ -18,9 +20,60 @@ namespace ouzel
         MeshBuffer(Renderer* renderer);
         virtual ~MeshBuffer();
         
-        virtual bool initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices);
+        // index size is 2 or 4 bytes, vertices are laid out as described by the vertex format
+        // dynamic mesh buffers keep a copy of their data and can be updated every frame
+        virtual bool initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                  const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false);
+        
+        bool initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices, bool dynamic = false);
+        bool initFromData(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, bool dynamic = false);
+        
+        bool isDynamic() const { return _dynamic; }
+        
+        // replace all the data of a dynamic mesh buffer, the buffer grows if needed
+        bool setIndices(const void* indices, uint32_t indexCount);
+        bool setVertices(const void* vertices, uint32_t vertexCount);
+        
+        bool setIndices(const std::vector<uint16_t>& indices);
+        bool setIndices(const std::vector<uint32_t>& indices);
+        bool setVertices(const std::vector<Vertex>& vertices);
+        
+        // overwrite a range of the current data of a dynamic mesh buffer, only the changed range is uploaded
+        bool updateIndices(uint32_t firstIndex, const void* indices, uint32_t indexCount);
+        bool updateVertices(uint32_t firstVertex, const void* vertices, uint32_t vertexCount);
+        
+        uint32_t getIndexSize() const { return _indexSize; }
+        uint32_t getIndexCount() const { return _indexCount; }
+        
+        const VertexFormat& getVertexFormat() const { return _vertexFormat; }
+        uint32_t getVertexCount() const { return _vertexCount; }
+        
+        // total area of the triangles in the XY plane
+        float getArea() const;
         
     protected:
+        void calculateArea(const void* indices, const void* vertices) const;
+        
         Renderer* _renderer;
+        
+        bool _dynamic = false;
+        
+        uint32_t _indexSize = 0;
+        uint32_t _indexCount = 0;
+        
+        VertexFormat _vertexFormat;
+        uint32_t _vertexCount = 0;
+        
+        // data of dynamic mesh buffers and the byte ranges changed since the last upload
+        std::vector<uint8_t> _indexData;
+        std::vector<uint8_t> _vertexData;
+        
+        uint32_t _indexDirtyStart = UINT32_MAX;
+        uint32_t _indexDirtyEnd = 0;
+        uint32_t _vertexDirtyStart = UINT32_MAX;
+        uint32_t _vertexDirtyEnd = 0;
+        
+        mutable float _area = 0.0f;
+        mutable bool _areaDirty = false;
     };
 }
@@ -1,6 +1,7 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
 #include "MeshBufferD3D11.h"
 #include "RendererD3D11.h"
 #include "Utils.h"
@@ -19,54 +20,149 @@ namespace ouzel
         if (_vertexBuffer) _vertexBuffer->Release();
     }
     
-    bool MeshBufferD3D11::initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    bool MeshBufferD3D11::initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                       const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
     {
-        if (!MeshBuffer::initFromData(indices, vertices))
+        if (!MeshBuffer::initFromData(indices, indexSize, indexCount, vertices, vertexFormat, vertexCount, dynamic))
         {
             return false;
         }
 
+        _indexFormat = (indexSize == 4) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+
+        _indexBufferSize = indexCount * indexSize;
+        _vertexBufferSize = vertexCount * vertexFormat.getStride();
+
+        if (!createBuffer(_indexBuffer, D3D11_BIND_INDEX_BUFFER, _indexBufferSize, indices))
+        {
+            log("Failed to create D3D11 index buffer");
+            return false;
+        }
+
+        if (!createBuffer(_vertexBuffer, D3D11_BIND_VERTEX_BUFFER, _vertexBufferSize, vertices))
+        {
+            log("Failed to create D3D11 vertex buffer");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool MeshBufferD3D11::createBuffer(ID3D11Buffer*& buffer, UINT bindFlags, UINT size, const void* data)
+    {
         RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
 
-        D3D11_BUFFER_DESC indexBufferDesc;
-        memset(&indexBufferDesc, 0, sizeof(indexBufferDesc));
+        D3D11_BUFFER_DESC bufferDesc;
+        memset(&bufferDesc, 0, sizeof(bufferDesc));
 
-        indexBufferDesc.ByteWidth = (UINT)indices.size() * sizeof(uint16_t);
-        indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-        indexBufferDesc.CPUAccessFlags = 0;
+        bufferDesc.ByteWidth = size;
+        bufferDesc.Usage = _dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+        bufferDesc.BindFlags = bindFlags;
+        bufferDesc.CPUAccessFlags = _dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
 
-        D3D11_SUBRESOURCE_DATA indexBufferResourceData;
-        memset(&indexBufferResourceData, 0, sizeof(indexBufferResourceData));
-        indexBufferResourceData.pSysMem = indices.data();
+        D3D11_SUBRESOURCE_DATA bufferResourceData;
+        memset(&bufferResourceData, 0, sizeof(bufferResourceData));
+        bufferResourceData.pSysMem = data;
 
-        HRESULT hr = rendererD3D11->getDevice()->CreateBuffer(&indexBufferDesc, &indexBufferResourceData, &_indexBuffer);
-        if (FAILED(hr) || !_indexBuffer)
+        // buffers can't be empty, dynamic ones are filled when they grow
+        if (_dynamic && size == 0)
         {
-            log("Failed to create D3D11 index buffer");
-            return false;
+            bufferDesc.ByteWidth = 16;
         }
 
-        D3D11_BUFFER_DESC vertexBufferDesc;
-        memset(&vertexBufferDesc, 0, sizeof(vertexBufferDesc));
+        HRESULT hr = rendererD3D11->getDevice()->CreateBuffer(&bufferDesc, (size > 0) ? &bufferResourceData : nullptr, &buffer);
+        if (FAILED(hr) || !buffer)
+        {
+            return false;
+        }
 
-        vertexBufferDesc.ByteWidth = (UINT)vertices.size() * sizeof(Vertex);
-        vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        vertexBufferDesc.CPUAccessFlags = 0;
+        return true;
+    }
 
-        D3D11_SUBRESOURCE_DATA vertexBufferResourceData;
-        memset(&vertexBufferResourceData, 0, sizeof(vertexBufferResourceData));
-        vertexBufferResourceData.pSysMem = vertices.data();
+    bool MeshBufferD3D11::uploadBuffers()
+    {
+        if (!uploadBuffer(_indexBuffer, D3D11_BIND_INDEX_BUFFER, _indexBufferSize, _indexDrawnSize,
+                          _indexDirtyStart, _indexDirtyEnd, _indexData))
+        {
+            log("Failed to upload D3D11 index buffer");
+            return false;
+        }
 
-        hr = rendererD3D11->getDevice()->CreateBuffer(&vertexBufferDesc, &vertexBufferResourceData, &_vertexBuffer);
-        if (FAILED(hr) || !_vertexBuffer)
+        if (!uploadBuffer(_vertexBuffer, D3D11_BIND_VERTEX_BUFFER, _vertexBufferSize, _vertexDrawnSize,
+                          _vertexDirtyStart, _vertexDirtyEnd, _vertexData))
         {
-            log("Failed to create D3D11 vertex buffer");
+            log("Failed to upload D3D11 vertex buffer");
             return false;
         }
 
-        _indexCount = (UINT)indices.size();
+        // everything up to the current size is read by the draw call that follows
+        _indexDrawnSize = std::max(_indexDrawnSize, static_cast<UINT>(_indexData.size()));
+        _vertexDrawnSize = std::max(_vertexDrawnSize, static_cast<UINT>(_vertexData.size()));
+
+        return true;
+    }
+
+    bool MeshBufferD3D11::uploadBuffer(ID3D11Buffer*& buffer, UINT bindFlags, UINT& bufferSize, UINT& drawnSize,
+                                       uint32_t& dirtyStart, uint32_t& dirtyEnd, const std::vector<uint8_t>& data)
+    {
+        if (dirtyEnd <= dirtyStart)
+        {
+            return true;
+        }
+
+        UINT dataSize = static_cast<UINT>(data.size());
+
+        if (dataSize > bufferSize)
+        {
+            if (buffer) buffer->Release();
+            buffer = nullptr;
+
+            bufferSize = std::max(dataSize, bufferSize * 2);
+
+            if (!createBuffer(buffer, bindFlags, bufferSize, nullptr))
+            {
+                return false;
+            }
+
+            dirtyStart = 0;
+            dirtyEnd = dataSize;
+            drawnSize = 0;
+        }
+
+        dirtyEnd = std::min(dirtyEnd, dataSize);
+
+        if (dirtyEnd > dirtyStart)
+        {
+            RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
+
+            // appending past the data the GPU may read doesn't have to wait or rename the buffer,
+            // everything else discards the buffer and writes all the data again
+            bool append = dirtyStart >= drawnSize;
+
+            D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+            HRESULT hr = rendererD3D11->getContext()->Map(buffer, 0, append ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
+            if (FAILED(hr))
+            {
+                return false;
+            }
+
+            uint8_t* bufferData = static_cast<uint8_t*>(mappedSubresource.pData);
+
+            if (append)
+            {
+                memcpy(bufferData + dirtyStart, data.data() + dirtyStart, dirtyEnd - dirtyStart);
+            }
+            else
+            {
+                memcpy(bufferData, data.data(), dataSize);
+                drawnSize = 0;
+            }
+
+            rendererD3D11->getContext()->Unmap(buffer, 0);
+        }
+
+        dirtyStart = UINT32_MAX;
+        dirtyEnd = 0;
 
         return true;
     }
@@ -14,16 +14,32 @@ namespace ouzel
         MeshBufferD3D11(Renderer* renderer);
         virtual ~MeshBufferD3D11();
         
-        bool initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices);
+        using MeshBuffer::initFromData;
+        virtual bool initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                  const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false) override;
+
+        // uploads the changes of a dynamic mesh buffer
+        bool uploadBuffers();
 
         ID3D11Buffer* getIndexBuffer() const { return _indexBuffer; }
         ID3D11Buffer* getVertexBuffer() const { return _vertexBuffer; }
 
-        UINT getIndexCount() const { return _indexCount; }
+        DXGI_FORMAT getIndexFormat() const { return _indexFormat; }
 
     protected:
+        bool createBuffer(ID3D11Buffer*& buffer, UINT bindFlags, UINT size, const void* data);
+        bool uploadBuffer(ID3D11Buffer*& buffer, UINT bindFlags, UINT& bufferSize, UINT& drawnSize,
+                          uint32_t& dirtyStart, uint32_t& dirtyEnd, const std::vector<uint8_t>& data);
+
         ID3D11Buffer* _indexBuffer = nullptr;
         ID3D11Buffer* _vertexBuffer = nullptr;
-        UINT _indexCount = 0;
+        DXGI_FORMAT _indexFormat = DXGI_FORMAT_R16_UINT;
+
+        UINT _indexBufferSize = 0;
+        UINT _vertexBufferSize = 0;
+
+        // bytes the GPU may read since the buffers were last discarded, writes past them don't need to discard
+        UINT _indexDrawnSize = 0;
+        UINT _vertexDrawnSize = 0;
     };
 }
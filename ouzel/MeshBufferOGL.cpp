@@ -1,8 +1,10 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
 #include "MeshBufferOGL.h"
 #include "RendererOGL.h"
+#include "Utils.h"
 
 namespace ouzel
 {
@@ -14,44 +16,177 @@ namespace ouzel
     
     MeshBufferOGL::~MeshBufferOGL()
     {
-        if (_vertexArrayId) glDeleteVertexArrays(1, &_vertexArrayId);
-        if (_vertexBufferId) glDeleteBuffers(1, &_vertexBufferId);
-        if (_indexBufferId) glDeleteBuffers(1, &_indexBufferId);
+        for (uint32_t i = 0; i < _bufferCount; ++i)
+        {
+            if (_buffers[i].vertexArrayId) glDeleteVertexArrays(1, &_buffers[i].vertexArrayId);
+            if (_buffers[i].vertexBufferId) glDeleteBuffers(1, &_buffers[i].vertexBufferId);
+            if (_buffers[i].indexBufferId) glDeleteBuffers(1, &_buffers[i].indexBufferId);
+        }
+    }
+    
+    bool MeshBufferOGL::initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                     const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
+    {
+        if (!MeshBuffer::initFromData(indices, indexSize, indexCount, vertices, vertexFormat, vertexCount, dynamic))
+        {
+            return false;
+        }
+        
+        // OpenGL ES 2 supports 32-bit indices only with OES_element_index_uint, which all iOS devices have
+        _indexFormat = (indexSize == 4) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+        
+        _bufferCount = _dynamic ? DYNAMIC_BUFFER_COUNT : 1;
+        
+        for (uint32_t i = 0; i < _bufferCount; ++i)
+        {
+            if (!createBuffers(_buffers[i], indices, vertices, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW))
+            {
+                return false;
+            }
+        }
+        
+        return true;
     }
     
-    bool MeshBufferOGL::initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    bool MeshBufferOGL::createBuffers(Buffers& buffers, const void* indices, const void* vertices, GLenum usage)
     {
-        glGenVertexArrays(1, &_vertexArrayId);
-        glBindVertexArray(_vertexArrayId);
+        glGenVertexArrays(1, &buffers.vertexArrayId);
+        glBindVertexArray(buffers.vertexArrayId);
+        
+        buffers.vertexBufferSize = static_cast<GLsizeiptr>(_vertexFormat.getStride() * _vertexCount);
         
-        glGenBuffers(1, &_vertexBufferId);
-        glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+        glGenBuffers(1, &buffers.vertexBufferId);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBufferId);
+        glBufferData(GL_ARRAY_BUFFER, buffers.vertexBufferSize, vertices, usage);
         
         if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
         {
             return false;
         }
         
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(0));
-        
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(12));
+        for (const VertexAttribute& attribute : _vertexFormat.getAttributes())
+        {
+            GLuint location = static_cast<GLuint>(attribute.usage);
+            GLenum type = GL_FLOAT;
+            GLboolean normalized = GL_FALSE;
+            
+            switch (attribute.type)
+            {
+                case VertexAttributeType::FLOAT: type = GL_FLOAT; break;
+                case VertexAttributeType::UNSIGNED_BYTE_NORM: type = GL_UNSIGNED_BYTE; normalized = GL_TRUE; break;
+                case VertexAttributeType::SHORT: type = GL_SHORT; break;
+                case VertexAttributeType::UNSIGNED_SHORT_NORM: type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; break;
+            }
+            
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, static_cast<GLint>(attribute.components), type, normalized,
+                                  static_cast<GLsizei>(_vertexFormat.getStride()), reinterpret_cast<const GLvoid*>(attribute.offset));
+        }
         
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(16));
+        buffers.indexBufferSize = static_cast<GLsizeiptr>(_indexCount * _indexSize);
         
-        glGenBuffers(1, &_indexBufferId);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferId);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        glGenBuffers(1, &buffers.indexBufferId);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBufferId);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBufferSize, indices, usage);
         
         if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
         {
             return false;
         }
         
-        _indexCount = static_cast<GLsizei>(indices.size());
+        return true;
+    }
+    
+    bool MeshBufferOGL::bindBuffers()
+    {
+        if (_indexDirtyEnd > _indexDirtyStart || _vertexDirtyEnd > _vertexDirtyStart)
+        {
+            // every buffer has to catch up with the changes when it becomes current
+            for (uint32_t i = 0; i < _bufferCount; ++i)
+            {
+                _buffers[i].indexDirtyStart = std::min(_buffers[i].indexDirtyStart, _indexDirtyStart);
+                _buffers[i].indexDirtyEnd = std::max(_buffers[i].indexDirtyEnd, _indexDirtyEnd);
+                _buffers[i].vertexDirtyStart = std::min(_buffers[i].vertexDirtyStart, _vertexDirtyStart);
+                _buffers[i].vertexDirtyEnd = std::max(_buffers[i].vertexDirtyEnd, _vertexDirtyEnd);
+            }
+            
+            _indexDirtyStart = _vertexDirtyStart = UINT32_MAX;
+            _indexDirtyEnd = _vertexDirtyEnd = 0;
+            
+            // the buffer used in the previous frames may still be in flight
+            if (_uploadFrame != _renderer->getCurrentFrame())
+            {
+                _uploadFrame = _renderer->getCurrentFrame();
+                _currentBuffer = (_currentBuffer + 1) % _bufferCount;
+            }
+        }
+        
+        Buffers& buffers = _buffers[_currentBuffer];
+        
+        glBindVertexArray(buffers.vertexArrayId);
+        
+        if (!uploadBuffer(GL_ARRAY_BUFFER, buffers.vertexBufferId, buffers.vertexBufferSize,
+                          buffers.vertexDirtyStart, buffers.vertexDirtyEnd, _vertexData))
+        {
+            return false;
+        }
+        
+        if (!uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBufferId, buffers.indexBufferSize,
+                          buffers.indexDirtyStart, buffers.indexDirtyEnd, _indexData))
+        {
+            return false;
+        }
+        
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBufferId);
+        
+        return true;
+    }
+    
+    bool MeshBufferOGL::uploadBuffer(GLenum target, GLuint bufferId, GLsizeiptr& bufferSize,
+                                     uint32_t& dirtyStart, uint32_t& dirtyEnd, const std::vector<uint8_t>& data)
+    {
+        if (dirtyEnd <= dirtyStart)
+        {
+            return true;
+        }
+        
+        GLsizeiptr dataSize = static_cast<GLsizeiptr>(data.size());
+        
+        glBindBuffer(target, bufferId);
+        
+        if (dataSize > bufferSize || (dirtyStart == 0 && static_cast<GLsizeiptr>(dirtyEnd) >= dataSize))
+        {
+            // orphan the old storage, so that the driver gives new memory instead of waiting for the GPU to stop using it,
+            // the buffer grows only when the data doesn't fit
+            if (dataSize > bufferSize)
+            {
+                bufferSize = std::max(dataSize, bufferSize * 2);
+            }
+            
+            glBufferData(target, bufferSize, nullptr, GL_DYNAMIC_DRAW);
+            
+            if (dataSize > 0)
+            {
+                glBufferSubData(target, 0, dataSize, data.data());
+            }
+        }
+        else
+        {
+            GLsizeiptr end = std::min(static_cast<GLsizeiptr>(dirtyEnd), dataSize);
+            
+            if (end > static_cast<GLsizeiptr>(dirtyStart))
+            {
+                glBufferSubData(target, static_cast<GLintptr>(dirtyStart), end - static_cast<GLsizeiptr>(dirtyStart), data.data() + dirtyStart);
+            }
+        }
+        
+        dirtyStart = UINT32_MAX;
+        dirtyEnd = 0;
+        
+        if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
+        {
+            return false;
+        }
         
         return true;
     }
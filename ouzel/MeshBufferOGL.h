@@ -19,21 +19,50 @@ namespace ouzel
     class MeshBufferOGL: public MeshBuffer
     {
     public:
+        // dynamic mesh buffers rotate between buffers, so that a buffer the GPU may still be reading is not written
+        static const uint32_t DYNAMIC_BUFFER_COUNT = 3;
+        
         MeshBufferOGL(Renderer* renderer);
         virtual ~MeshBufferOGL();
         
-        bool initFromData(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices);
+        using MeshBuffer::initFromData;
+        virtual bool initFromData(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                  const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false) override;
+        
+        // uploads the changes of a dynamic mesh buffer and binds the vertex array and index buffer
+        bool bindBuffers();
         
-        GLuint getIndexBufferId() const { return _indexBufferId; }
-        GLuint getVertexArrayId() const { return _vertexArrayId; }
+        GLuint getIndexBufferId() const { return _buffers[_currentBuffer].indexBufferId; }
+        GLuint getVertexArrayId() const { return _buffers[_currentBuffer].vertexArrayId; }
         
-        GLsizei getIndexCount() const { return _indexCount; }
+        GLenum getIndexFormat() const { return _indexFormat; }
         
     protected:
-        GLuint _vertexArrayId = 0;
-        GLuint _indexBufferId = 0;
-        GLuint _vertexBufferId = 0;
+        struct Buffers
+        {
+            GLuint vertexArrayId = 0;
+            GLuint indexBufferId = 0;
+            GLuint vertexBufferId = 0;
+            
+            GLsizeiptr indexBufferSize = 0;
+            GLsizeiptr vertexBufferSize = 0;
+            
+            // byte ranges changed since the buffers were last written
+            uint32_t indexDirtyStart = UINT32_MAX;
+            uint32_t indexDirtyEnd = 0;
+            uint32_t vertexDirtyStart = UINT32_MAX;
+            uint32_t vertexDirtyEnd = 0;
+        };
+        
+        bool createBuffers(Buffers& buffers, const void* indices, const void* vertices, GLenum usage);
+        bool uploadBuffer(GLenum target, GLuint bufferId, GLsizeiptr& bufferSize,
+                          uint32_t& dirtyStart, uint32_t& dirtyEnd, const std::vector<uint8_t>& data);
+        
+        Buffers _buffers[DYNAMIC_BUFFER_COUNT];
+        uint32_t _bufferCount = 0;
+        uint32_t _currentBuffer = 0;
+        uint32_t _uploadFrame = 0;
         
-        GLsizei _indexCount;
+        GLenum _indexFormat = GL_UNSIGNED_SHORT;
     };
 }
@@ -1,9 +1,13 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
 #include "Node.h"
+#include "MathUtils.h"
 #include "Engine.h"
 #include "Scene.h"
+#include "EventDispatcher.h"
 
 namespace ouzel
 {
@@ -15,6 +19,11 @@ namespace ouzel
 
     Node::~Node()
     {
+        if (_hasEventListeners)
+        {
+            _scene->getEngine()->getEventDispatcher()->removeNodeListeners(this);
+        }
+        
         for (AutoPtr<Node> node : _children)
         {
             node->_parent = nullptr;
@@ -62,7 +71,7 @@ namespace ouzel
         }
     }
 
-    void Node::draw()
+    void Node::draw(Camera* camera)
     {
 
     }
@@ -110,11 +119,64 @@ namespace ouzel
         updateTransform();
     }
 
+    void Node::storePreviousState()
+    {
+        _previousPosition = _position;
+        _previousRotation = _rotation;
+        _previousScale = _scale;
+    }
+    
+    void Node::interpolate(float alpha)
+    {
+        if (_previousPosition != _position || _previousRotation != _rotation || _previousScale != _scale)
+        {
+            Vector2 position = _position;
+            float rotation = _rotation;
+            Vector2 scale = _scale;
+            
+            _position = _previousPosition + (position - _previousPosition) * alpha;
+            // along the shorter arc, so that wrapping from 2pi to 0 doesn't spin the node a whole turn back
+            _rotation = _previousRotation + remainderf(rotation - _previousRotation, MATH_PIX2) * alpha;
+            _scale = _previousScale + (scale - _previousScale) * alpha;
+            
+            // children that don't move follow the interpolated transformation of the parent
+            updateTransform();
+            
+            _position = position;
+            _rotation = rotation;
+            _scale = scale;
+            
+            _interpolated = true;
+        }
+        
+        for (AutoPtr<Node> child : _children)
+        {
+            child->interpolate(alpha);
+        }
+    }
+    
+    void Node::restoreTransform()
+    {
+        if (_interpolated)
+        {
+            _interpolated = false;
+            updateTransform();
+        }
+        
+        for (AutoPtr<Node> child : _children)
+        {
+            child->restoreTransform();
+        }
+    }
+    
     void Node::addToScene()
     {
         _scene->addNode(this);
         _addedToScene = true;
         
+        // nodes don't move in from where they were before being added
+        storePreviousState();
+        
         for (AutoPtr<Node> child : _children)
         {
             child->addToScene();
@@ -192,6 +254,7 @@ namespace ouzel
         }
         
         markInverseTransformDirty();
+        markDirty();
         
         for (AutoPtr<Node> child : _children)
         {
@@ -199,9 +262,39 @@ namespace ouzel
         }
     }
     
-    bool Node::checkVisibility() const
+    Rectangle Node::getWorldRectangle(const Rectangle& rectangle) const
     {
-        return true;
+        Vector3 corners[4] = {
+            Vector3(rectangle.x, rectangle.y, 0.0f),
+            Vector3(rectangle.x + rectangle.width, rectangle.y, 0.0f),
+            Vector3(rectangle.x, rectangle.y + rectangle.height, 0.0f),
+            Vector3(rectangle.x + rectangle.width, rectangle.y + rectangle.height, 0.0f)
+        };
+        
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+        
+        for (Vector3& corner : corners)
+        {
+            _transform.transformPoint(&corner);
+            
+            minX = std::min(minX, corner.x);
+            minY = std::min(minY, corner.y);
+            maxX = std::max(maxX, corner.x);
+            maxY = std::max(maxY, corner.y);
+        }
+        
+        return Rectangle(minX, minY, maxX - minX, maxY - minY);
+    }
+    
+    void Node::markDirty(const Rectangle& rectangle)
+    {
+        if (_addedToScene)
+        {
+            _scene->addDirtyRectangle(getWorldRectangle(rectangle));
+        }
     }
     
     void Node::markInverseTransformDirty()
@@ -14,10 +14,13 @@
 namespace ouzel
 {
     class Scene;
+    class Camera;
+    class EventDispatcher;
 
     class Node: public Noncopyable, public ReferenceCounted
     {
         friend Scene;
+        friend EventDispatcher;
     public:
         Node(Scene* scene);
         virtual ~Node();
@@ -29,7 +32,7 @@ namespace ouzel
         virtual bool hasChild(Node* node) const;
         virtual const std::vector<AutoPtr<Node>>& getChildren() const { return _children; }
         
-        virtual void draw();
+        virtual void draw(Camera* camera);
         
         virtual void setZOrder(float zOrder);
         virtual float getZOrder() const { return _zOrder; }
@@ -54,6 +57,9 @@ namespace ouzel
         
         virtual const Rectangle& getBoundingBox() const { return _boundingBox; }
         
+        // axis aligned bounding box of a rectangle in local coordinates after transforming it to world coordinates
+        Rectangle getWorldRectangle(const Rectangle& rectangle) const;
+        
         virtual bool isAddedToScene() const { return _addedToScene; }
         
         virtual bool pointOn(const Vector2& position) const;
@@ -61,7 +67,31 @@ namespace ouzel
         
         virtual void updateTransform();
         
-        virtual bool checkVisibility() const;
+        // bit mask of the layers this node belongs to, see Camera::setLayerMask
+        virtual void setLayers(uint32_t layers) { _layers = layers; markDirty(); }
+        virtual uint32_t getLayers() const { return _layers; }
+        
+        // the node has to be drawn again in the partial redraw mode, transformation changes mark it automatically
+        void markDirty() { _dirty = true; }
+        bool isDirty() const { return _dirty; }
+        
+        // only a part of the node, in local coordinates, has to be drawn again
+        void markDirty(const Rectangle& rectangle);
+        
+        // opaque nodes are drawn front to back with depth writes and without blending
+        virtual bool isOpaque() const { return false; }
+        
+        // text labels are collected by the scene and drawn in batches instead of through draw
+        virtual bool isTextLabel() const { return false; }
+        
+        // the scene stores the state before every simulation step and draws the node between it and the current one,
+        // storing it after moving the node makes it jump to the new position without interpolation
+        void storePreviousState();
+        
+        // alpha is the fraction of the simulation step since the current state
+        void interpolate(float alpha);
+        // restores the transformation of the current state after drawing an interpolated one
+        void restoreTransform();
         
     protected:
         virtual void addToScene();
@@ -78,6 +108,7 @@ namespace ouzel
         float _zOrder = 0.0f;
         
         Rectangle _boundingBox;
+        uint32_t _layers = 1;
         
         Node* _parent = nullptr;
         std::vector<AutoPtr<Node>> _children;
@@ -87,6 +118,18 @@ namespace ouzel
         
         bool _addedToScene = false;
         
+        bool _dirty = true;
+        
+        Vector2 _previousPosition;
+        float _previousRotation = 0.0f;
+        Vector2 _previousScale = Vector2(1.0f, 1.0f);
+        bool _interpolated = false;
+        
+        bool _hasEventListeners = false;
+        
+        // world bounding box of the last drawn frame, so that the area it covered gets redrawn after a change
+        Rectangle _drawnBoundingBox;
+        
     private:
         mutable Matrix4 _inverseTransform;
         mutable bool _inverseTransformDirty = false;
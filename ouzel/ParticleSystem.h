@@ -4,6 +4,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "node.h"
 #include "Vector2.h"
 
@@ -19,79 +20,90 @@ namespace ouzel
         
         virtual bool initFromFile(const std::string& filename);
         
-    protected:
-        uint32_t _blendFuncSource = 1;
-        uint32_t _blendFuncDestination = 771;
-        
-        uint32_t _emitterType = 0;
-        uint32_t _maxParticles = 77;
-        float _duration = -1;
-        float _particleLifespan = 1.0f;
-        float _particleLifespanVariance = 0.0f;
-        
-        float _speed = 225.0f;
-        float _speedVariance = 30.0f;
-        
-        bool _absolutePosition = false;
-        bool _yCoordFlipped = true;
-        Vector2 _sourcePosition = Vector2(160.0f, 240.0f);
-        Vector2 _sourcePositionVariance = Vector2(7.0f, 7.0f);
-        
-        float _startParticleSize = 64.0f;
-        float _startParticleSizeVariance = 5.0f;
-        
-        float _finishParticleSize = 0.0f;
-        float _finishParticleSizeVariance = 0.0f;
-        
-        float _angle = 90.0f;
-        float _angleVariance = 10.0f;
-        
-        float _rotationStart = 0.0f;
-        float _rotationStartVariance = 0.0f;
-        
-        float _rotationEnd = 0.0f;
-        float _rotationEndVariance = 0.0f;
-        
-        float _rotatePerSecond = 360.0f;
-        float _rotatePerSecondVariance = 0.0f;
-        
-        float _minRadius = 300.0f;
-        float _minRadiusVariance = 0.0f;
-        
-        float _maxRadius = 0.0f;
-        float _maxRadiusVariance = 0.0f;
-        
-        float _radialAcceleration = 0.0f;
-        float _radialAccelVariance = 0.0f;
-        
-        float _tangentialAcceleration = 0.0f;
-        float _tangentialAccelVariance = 0.0f;
-        
-        Vector2 _gravity = Vector2(0.0f, 0.0f);
-        
-        float _startColorRed = 0.372f;
-        float _startColorGreen = 0.498f;
-        float _startColorBlue = 0.8f;
-        float _startColorAlpha = 0.5f;
-        
-        float _startColorVarianceRed = 0.0f;
-        float _startColorVarianceGreen = 0.0f;
-        float _startColorVarianceBlue = 0.0f;
-        float _startColorVarianceAlpha = 0.0f;
-        
-        float _finishColorRed = 0.0f;
-        float _finishColorGreen = 0.0f;
-        float _finishColorBlue = 0.0f;
-        float _finishColorAlpha = 0.0f;
-        
-        float _finishColorVarianceRed = 0.0f;
-        float _finishColorVarianceGreen = 0.0f;
-        float _finishColorVarianceBlue = 0.0f;
-        float _finishColorVarianceAlpha = 0.0f;
-
-        std::string _textureFilename;
-        
-        
+        // reads the file again, the current settings stay if it can't be parsed
+        virtual bool reload();
         
+    protected:
+        std::string _filename;
+        uint32_t _fileWatchId = 0;
+        
+        // settings of the particle designer format, values missing from the file keep the defaults
+        struct Settings
+        {
+            uint32_t blendFuncSource = 1;
+            uint32_t blendFuncDestination = 771;
+            
+            uint32_t emitterType = 0;
+            uint32_t maxParticles = 77;
+            float duration = -1;
+            float particleLifespan = 1.0f;
+            float particleLifespanVariance = 0.0f;
+            
+            float speed = 225.0f;
+            float speedVariance = 30.0f;
+            
+            bool absolutePosition = false;
+            bool yCoordFlipped = true;
+            Vector2 sourcePosition = Vector2(160.0f, 240.0f);
+            Vector2 sourcePositionVariance = Vector2(7.0f, 7.0f);
+            
+            float startParticleSize = 64.0f;
+            float startParticleSizeVariance = 5.0f;
+            
+            float finishParticleSize = 0.0f;
+            float finishParticleSizeVariance = 0.0f;
+            
+            float angle = 90.0f;
+            float angleVariance = 10.0f;
+            
+            float rotationStart = 0.0f;
+            float rotationStartVariance = 0.0f;
+            
+            float rotationEnd = 0.0f;
+            float rotationEndVariance = 0.0f;
+            
+            float rotatePerSecond = 360.0f;
+            float rotatePerSecondVariance = 0.0f;
+            
+            float minRadius = 300.0f;
+            float minRadiusVariance = 0.0f;
+            
+            float maxRadius = 0.0f;
+            float maxRadiusVariance = 0.0f;
+            
+            float radialAcceleration = 0.0f;
+            float radialAccelVariance = 0.0f;
+            
+            float tangentialAcceleration = 0.0f;
+            float tangentialAccelVariance = 0.0f;
+            
+            Vector2 gravity = Vector2(0.0f, 0.0f);
+            
+            float startColorRed = 0.372f;
+            float startColorGreen = 0.498f;
+            float startColorBlue = 0.8f;
+            float startColorAlpha = 0.5f;
+            
+            float startColorVarianceRed = 0.0f;
+            float startColorVarianceGreen = 0.0f;
+            float startColorVarianceBlue = 0.0f;
+            float startColorVarianceAlpha = 0.0f;
+            
+            float finishColorRed = 0.0f;
+            float finishColorGreen = 0.0f;
+            float finishColorBlue = 0.0f;
+            float finishColorAlpha = 0.0f;
+            
+            float finishColorVarianceRed = 0.0f;
+            float finishColorVarianceGreen = 0.0f;
+            float finishColorVarianceBlue = 0.0f;
+            float finishColorVarianceAlpha = 0.0f;
+            
+            std::string textureFilename;
+        };
+        
+        static bool parseSettings(const std::vector<uint8_t>& data, Settings& settings);
+        
+        Settings _settings;
     };
 }
@@ -0,0 +1,35 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+
+namespace ouzel
+{
+    // 16-bit formats are packed into native-endian shorts with the first channel in the highest bits
+    enum class PixelFormat
+    {
+        RGBA8 = 0,
+        RGB565,
+        RGBA4444,
+        RGBA5551,
+        A8, // sampled as white with the alpha, for masks and glyph atlases
+        L8 // sampled as an opaque gray
+    };
+    
+    inline uint32_t getPixelSize(PixelFormat pixelFormat)
+    {
+        switch (pixelFormat)
+        {
+            case PixelFormat::RGBA8: return 4;
+            case PixelFormat::RGB565:
+            case PixelFormat::RGBA4444:
+            case PixelFormat::RGBA5551: return 2;
+            case PixelFormat::A8:
+            case PixelFormat::L8: return 1;
+        }
+        
+        return 4;
+    }
+}
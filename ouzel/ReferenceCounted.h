@@ -5,6 +5,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <atomic>
 
 namespace ouzel
 {
@@ -54,6 +55,7 @@ namespace ouzel
 
     private:
         const char* _debugName = nullptr;
-        mutable int32_t _referenceCounter = 0;
+        // objects like archives are retained and released by the loader threads too
+        mutable std::atomic<int32_t> _referenceCounter{0};
     };
 }
@@ -15,4 +15,11 @@ namespace ouzel
     {
         
     }
+    
+    bool RenderTarget::init(const Size2& size)
+    {
+        _size = size;
+        
+        return true;
+    }
 }
@@ -3,23 +3,35 @@
 
 #pragma once
 
+#include "AutoPtr.h"
 #include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "Size2.h"
+#include "Color.h"
+#include "Texture.h"
 
 namespace ouzel
 {
     class Renderer;
-    class Texture;
     
-    class RenderTarget: public Noncopyable
+    class RenderTarget: public Noncopyable, public ReferenceCounted
     {
     public:
         RenderTarget(Renderer* renderer);
         virtual ~RenderTarget();
         
+        virtual bool init(const Size2& size);
+        
         Texture* getTexture() const { return _texture; }
+        const Size2& getSize() const { return _size; }
+        
+        const Color& getClearColor() const { return _clearColor; }
+        void setClearColor(const Color& color) { _clearColor = color; }
         
     protected:
         Renderer* _renderer;
-        Texture* _texture = nullptr;
+        AutoPtr<Texture> _texture;
+        Size2 _size;
+        Color _clearColor = Color(0, 0, 0, 0);
     };
 }
@@ -2,6 +2,9 @@
 // This file is part of the Ouzel engine.
 
 #include "RenderTargetD3D11.h"
+#include "RendererD3D11.h"
+#include "TextureD3D11.h"
+#include "Utils.h"
 
 namespace ouzel
 {
@@ -13,6 +16,60 @@ namespace ouzel
     
     RenderTargetD3D11::~RenderTargetD3D11()
     {
-        
+        if (_depthStencilView) _depthStencilView->Release();
+        if (_depthStencilTexture) _depthStencilTexture->Release();
+        if (_renderTargetView) _renderTargetView->Release();
+    }
+
+    bool RenderTargetD3D11::init(const Size2& size)
+    {
+        if (!RenderTarget::init(size))
+        {
+            return false;
+        }
+
+        RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
+
+        TextureD3D11* texture = new TextureD3D11(_renderer);
+        _texture = texture;
+
+        if (!texture->initFromData(nullptr, size, true))
+        {
+            return false;
+        }
+
+        HRESULT hr = rendererD3D11->getDevice()->CreateRenderTargetView(texture->getTexture(), nullptr, &_renderTargetView);
+        if (FAILED(hr) || !_renderTargetView)
+        {
+            log("Failed to create D3D11 render target view");
+            return false;
+        }
+
+        D3D11_TEXTURE2D_DESC depthStencilDesc;
+        memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+        depthStencilDesc.Width = (UINT)size.width;
+        depthStencilDesc.Height = (UINT)size.height;
+        depthStencilDesc.MipLevels = 1;
+        depthStencilDesc.ArraySize = 1;
+        depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        depthStencilDesc.SampleDesc.Count = 1;
+        depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+        depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+
+        hr = rendererD3D11->getDevice()->CreateTexture2D(&depthStencilDesc, nullptr, &_depthStencilTexture);
+        if (FAILED(hr) || !_depthStencilTexture)
+        {
+            log("Failed to create D3D11 depth stencil texture");
+            return false;
+        }
+
+        hr = rendererD3D11->getDevice()->CreateDepthStencilView(_depthStencilTexture, nullptr, &_depthStencilView);
+        if (FAILED(hr) || !_depthStencilView)
+        {
+            log("Failed to create D3D11 depth stencil view");
+            return false;
+        }
+
+        return true;
     }
 }
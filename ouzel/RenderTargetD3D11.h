@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <d3d11.h>
 #include "RenderTarget.h"
 
 namespace ouzel
@@ -12,5 +13,15 @@ namespace ouzel
     public:
         RenderTargetD3D11(Renderer* renderer);
         virtual ~RenderTargetD3D11();
+
+        virtual bool init(const Size2& size) override;
+
+        ID3D11RenderTargetView* getRenderTargetView() const { return _renderTargetView; }
+        ID3D11DepthStencilView* getDepthStencilView() const { return _depthStencilView; }
+
+    protected:
+        ID3D11RenderTargetView* _renderTargetView = nullptr;
+        ID3D11Texture2D* _depthStencilTexture = nullptr;
+        ID3D11DepthStencilView* _depthStencilView = nullptr;
     };
 }
@@ -2,6 +2,9 @@
 // This file is part of the Ouzel engine.
 
 #include "RenderTargetOGL.h"
+#include "RendererOGL.h"
+#include "TextureOGL.h"
+#include "Utils.h"
 
 namespace ouzel
 {
@@ -13,6 +16,63 @@ namespace ouzel
     
     RenderTargetOGL::~RenderTargetOGL()
     {
+        if (_depthBufferId)
+        {
+            glDeleteRenderbuffers(1, &_depthBufferId);
+        }
         
+        if (_frameBufferId)
+        {
+            glDeleteFramebuffers(1, &_frameBufferId);
+        }
+    }
+    
+    bool RenderTargetOGL::init(const Size2& size)
+    {
+        if (!RenderTarget::init(size))
+        {
+            return false;
+        }
+        
+        TextureOGL* texture = new TextureOGL(_renderer);
+        _texture = texture;
+        
+        if (!texture->initFromData(nullptr, size, true))
+        {
+            return false;
+        }
+        
+        glGenFramebuffers(1, &_frameBufferId);
+        glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferId);
+        
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getTextureId(), 0);
+        
+        // the scene draws opaque nodes with depth testing, so render targets need a depth buffer too
+        glGenRenderbuffers(1, &_depthBufferId);
+        glBindRenderbuffer(GL_RENDERBUFFER, _depthBufferId);
+#if defined(OUZEL_PLATFORM_IOS)
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, size.width, size.height);
+#else
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.width, size.height);
+#endif
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBufferId);
+        
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        
+        RendererOGL* rendererOGL = static_cast<RendererOGL*>(_renderer);
+        glBindFramebuffer(GL_FRAMEBUFFER, rendererOGL->getActiveFrameBufferId());
+        
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            log("Failed to create OpenGL frame buffer (status %x)", status);
+            return false;
+        }
+        
+        if (rendererOGL->checkOpenGLErrors())
+        {
+            return false;
+        }
+        
+        return true;
     }
 }
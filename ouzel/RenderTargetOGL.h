@@ -3,13 +3,31 @@
 
 #pragma once
 
+#include "CompileConfig.h"
+
+#if defined(OUZEL_PLATFORM_OSX)
+#include <OpenGL/gl3.h>
+#elif defined(OUZEL_PLATFORM_IOS)
+#import <OpenGLES/ES2/gl.h>
+#import <OpenGLES/ES2/glext.h>
+#endif
+
 #include "RenderTarget.h"
 
 namespace ouzel
 {
     class RenderTargetOGL: public RenderTarget
     {
+    public:
         RenderTargetOGL(Renderer* renderer);
         virtual ~RenderTargetOGL();
+        
+        virtual bool init(const Size2& size) override;
+        
+        GLuint getFrameBufferId() const { return _frameBufferId; }
+        
+    protected:
+        GLuint _frameBufferId = 0;
+        GLuint _depthBufferId = 0;
     };
 }
@@ -1,6 +1,10 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <condition_variable>
 #include "Renderer.h"
 #include "Engine.h"
 #include "Texture.h"
@@ -12,13 +16,21 @@
 #include "EventHander.h"
 #include "Scene.h"
 #include "MeshBuffer.h"
+#include "Image.h"
 
 namespace ouzel
 {
     Renderer::Renderer(const Size2& size, bool fullscreen, Engine* engine, Driver driver):
         _engine(engine), _driver(driver), _size(size), _fullscreen(fullscreen)
     {
-
+        Renderer::recalculateProjection();
+        
+        // software renderer uses shaders that only keep their transformation
+        if (_driver == Driver::NONE)
+        {
+            setShader(SHADER_TEXTURE, new Shader(this));
+            setShader(SHADER_COLOR, new Shader(this));
+        }
     }
 
     Renderer::~Renderer()
@@ -29,21 +41,86 @@ namespace ouzel
     void Renderer::recalculateProjection()
     {
         Matrix4::createOrthographic(_size.width, _size.height, 1.0f, 1000.0f, &_projection);
+        
+        if (!_activeRenderTarget)
+        {
+            _viewport.set(0.0f, 0.0f, _size.width, _size.height);
+        }
     }
     
     void Renderer::begin()
     {
-
+        ++_currentFrame;
+        
+        if (_overdrawMeasurementEnabled)
+        {
+            _overdraw = (_size.width > 0.0f && _size.height > 0.0f) ? _fragmentCount / (_size.width * _size.height) : 0.0f;
+            _fragmentCount = 0.0f;
+        }
+        
+        evictTextures();
     }
     
     void Renderer::clear()
     {
     }
     
+    void Renderer::clearDepth()
+    {
+    }
+    
     void Renderer::flush()
     {
     }
     
+    bool Renderer::captureFrame(const CaptureCallback& callback, RenderTarget* renderTarget)
+    {
+        if (_driver == Driver::NONE)
+        {
+            log("Software renderer has no pixels to capture");
+            return false;
+        }
+        
+        _captureRequests.push_back({ callback, renderTarget });
+        
+        // the captures start when a frame is drawn, which partial redraw skips for an unchanged scene
+        _engine->getScene()->redrawAll();
+        
+        return true;
+    }
+    
+    bool Renderer::saveScreenshot(const std::string& path)
+    {
+        ThreadPool* threadPool = _engine->getThreadPool();
+        
+        return captureFrame([threadPool, path](const Size2& size, const std::vector<uint8_t>& pixels) {
+            if (pixels.empty())
+            {
+                log("Failed to capture screenshot %s", path.c_str());
+                return;
+            }
+            
+            // encoding takes longer than a frame, the thread pool finishes the queued tasks before it is destroyed
+            threadPool->enqueue([path, size, pixels]() {
+                Image::writePNG(path, size, pixels);
+            });
+        });
+    }
+    
+    void Renderer::startCaptures()
+    {
+        for (const CaptureRequest& request : _captureRequests)
+        {
+            request.callback(Size2(), std::vector<uint8_t>());
+        }
+        
+        _captureRequests.clear();
+    }
+    
+    void Renderer::finishCaptures()
+    {
+    }
+    
     void Renderer::resize(const Size2& size)
     {
         _size = size;
@@ -52,46 +129,243 @@ namespace ouzel
     
     void Renderer::preloadTexture(const std::string& filename)
     {
-        std::unordered_map<std::string, AutoPtr<Texture>>::const_iterator i = _textures.find(filename);
+        getTextureHandle(filename);
+    }
+
+    void Renderer::preloadTextures(const std::vector<std::string>& filenames)
+    {
+        std::vector<std::string> missing;
         
-        if (i == _textures.end())
+        for (const std::string& filename : filenames)
         {
-            Texture* texture = loadTextureFromFile(filename);
+            if (_textures.find(filename) == _textures.end() &&
+                std::find(missing.begin(), missing.end(), filename) == missing.end())
+            {
+                missing.push_back(filename);
+            }
+        }
+        
+        // the images are owned here, the tasks only get raw pointers to them
+        std::vector<AutoPtr<Image>> images;
+        
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            images.push_back(new Image(_engine));
+        }
+        
+        std::vector<uint8_t> loaded(missing.size(), 0);
+        
+        std::mutex mutex;
+        std::condition_variable condition;
+        size_t remaining = missing.size();
+        
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            Image* image = images[i];
             
-            if (texture)
+            _engine->getThreadPool()->enqueue([this, image, i, &missing, &loaded, &mutex, &condition, &remaining]() {
+                loaded[i] = loadTextureImage(image, missing[i]) ? 1 : 0;
+                
+                std::lock_guard<std::mutex> lock(mutex);
+                
+                if (--remaining == 0)
+                {
+                    condition.notify_one();
+                }
+            });
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&remaining]() { return remaining == 0; });
+        }
+        
+        // textures have to be created on the rendering thread
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            if (loaded[i])
             {
-                _textures[filename] = texture;
+                Texture* texture = loadTextureFromImage(images[i]);
+                
+                if (texture)
+                {
+                    addTexture(missing[i], texture);
+                }
             }
         }
     }
 
     Texture* Renderer::getTexture(const std::string& filename)
     {
-        Texture* result = nullptr;
-        
-        std::unordered_map<std::string, AutoPtr<Texture>>::const_iterator i = _textures.find(filename);
+        return getTexture(getTextureHandle(filename));
+    }
+    
+    TextureHandle Renderer::getTextureHandle(const std::string& filename)
+    {
+        std::unordered_map<std::string, TextureHandle>::const_iterator i = _textures.find(filename);
         
         if (i != _textures.end())
         {
             return i->second;
         }
-        else
+        
+        Texture* texture = loadTextureFromFile(filename);
+        
+        if (!texture)
+        {
+            return TextureHandle();
+        }
+        
+        return addTexture(filename, texture);
+    }
+    
+    void Renderer::setTexturePixelFormat(const std::string& filename, PixelFormat pixelFormat, bool dither)
+    {
+        TextureFormat textureFormat;
+        textureFormat.pixelFormat = pixelFormat;
+        textureFormat.dither = dither;
+        
+        _textureFormats[filename] = textureFormat;
+    }
+    
+    bool Renderer::loadTextureImage(Image* image, const std::string& filename) const
+    {
+        // mipmaps are generated from the RGBA8 pixels, before the conversion
+        if (!image->loadFromFile(filename) || !image->generateMipmaps())
+        {
+            return false;
+        }
+        
+        std::unordered_map<std::string, TextureFormat>::const_iterator i = _textureFormats.find(filename);
+        
+        if (i != _textureFormats.end())
+        {
+            return image->convert(i->second.pixelFormat, i->second.dither);
+        }
+        else if (_automaticPixelFormats)
+        {
+            return image->convert(image->getSuggestedPixelFormat());
+        }
+        
+        return true;
+    }
+    
+    bool Renderer::updateStreamedTextures()
+    {
+        bool changed = false;
+        
+        for (const std::pair<const std::string, TextureHandle>& i : _textures)
+        {
+            Texture* texture = getTexture(i.second);
+            
+            if (texture->isStreamed())
+            {
+                uint64_t previousMemorySize = texture->getMemorySize();
+                
+                if (texture->updateStreaming())
+                {
+                    _textureMemoryUsage = _textureMemoryUsage - previousMemorySize + texture->getMemorySize();
+                    changed = true;
+                }
+            }
+        }
+        
+        // evicting while iterating the cache would invalidate the iterator
+        evictTextures();
+        
+        return changed;
+    }
+    
+    void Renderer::setTextureMemoryBudget(uint64_t budget)
+    {
+        _textureMemoryBudget = budget;
+        
+        evictTextures();
+    }
+    
+    TextureHandle Renderer::addTexture(const std::string& filename, Texture* texture)
+    {
+        texture->setLastUsedFrame(_currentFrame);
+        
+        TextureHandle handle = _texturePool.add(texture);
+        
+        if (!handle)
+        {
+            log("Too many textures, failed to add %s", filename.c_str());
+            delete texture;
+            return handle;
+        }
+        
+        _textures[filename] = handle;
+        _textureMemoryUsage += texture->getMemorySize();
+        
+        // the texture counts as used in this frame, so the eviction never picks it
+        evictTextures();
+        
+        return handle;
+    }
+    
+    void Renderer::updateTextureMemoryUsage(Texture* texture, uint64_t previousMemorySize)
+    {
+        std::unordered_map<std::string, TextureHandle>::const_iterator i = _textures.find(texture->getFilename());
+        
+        if (i != _textures.end() && getTexture(i->second) == texture)
         {
-            result = loadTextureFromFile(filename);
+            _textureMemoryUsage = _textureMemoryUsage - previousMemorySize + texture->getMemorySize();
             
-            if (result)
+            evictTextures();
+        }
+    }
+    
+    void Renderer::evictTextures()
+    {
+        if (!_textureMemoryBudget || _textureMemoryUsage <= _textureMemoryBudget)
+        {
+            return;
+        }
+        
+        // only textures that nobody but the cache holds can be evicted, they get reloaded on the next getTexture call,
+        // textures used or loaded in this frame are kept even if the budget is exceeded
+        std::vector<std::pair<Texture*, std::unordered_map<std::string, TextureHandle>::iterator>> candidates;
+        
+        for (std::unordered_map<std::string, TextureHandle>::iterator i = _textures.begin(); i != _textures.end(); ++i)
+        {
+            Texture* texture = getTexture(i->second);
+            
+            if (texture->getReferenceCount() == 1 && texture->getLastUsedFrame() != _currentFrame)
             {
-                _textures[filename] = result;
+                candidates.push_back(std::make_pair(texture, i));
             }
         }
+        
+        std::sort(candidates.begin(), candidates.end(), [](const std::pair<Texture*, std::unordered_map<std::string, TextureHandle>::iterator>& a,
+                                                           const std::pair<Texture*, std::unordered_map<std::string, TextureHandle>::iterator>& b) {
+            return a.first->getLastUsedFrame() < b.first->getLastUsedFrame();
+        });
+        
+        for (const std::pair<Texture*, std::unordered_map<std::string, TextureHandle>::iterator>& candidate : candidates)
+        {
+            if (_textureMemoryUsage <= _textureMemoryBudget)
+            {
+                break;
+            }
             
-        return result;
+            _textureMemoryUsage -= candidate.first->getMemorySize();
+            _texturePool.remove(candidate.second->second);
+            _textures.erase(candidate.second);
+        }
     }
     
     bool Renderer::activateTexture(Texture* texture, uint32_t layer)
     {
         _activeTextures[layer] = texture;
         
+        if (texture)
+        {
+            texture->setLastUsedFrame(_currentFrame);
+            texture->markDrawn();
+        }
+        
         return true;
     }
     
@@ -108,9 +382,27 @@ namespace ouzel
         return texture;
     }
     
-    Shader* Renderer::getShader(const std::string& shaderName) const
+    Texture* Renderer::loadTextureFromImage(Image* image)
+    {
+        Texture* texture = new Texture(this);
+        
+        if (!texture->initFromFile(image))
+        {
+            delete texture;
+            texture = nullptr;
+        }
+        
+        return texture;
+    }
+    
+    Shader* Renderer::getShader(uint32_t shaderId) const
     {
-        std::unordered_map<std::string, AutoPtr<Shader>>::const_iterator i = _shaders.find(shaderName);
+        return _shaderPool.get(getShaderHandle(shaderId));
+    }
+    
+    ShaderHandle Renderer::getShaderHandle(uint32_t shaderId) const
+    {
+        std::unordered_map<uint32_t, ShaderHandle>::const_iterator i = _shaders.find(shaderId);
         
         if (i != _shaders.end())
         {
@@ -118,13 +410,73 @@ namespace ouzel
         }
         else
         {
+            return ShaderHandle();
+        }
+    }
+    
+    void Renderer::setShader(uint32_t shaderId, Shader* shader)
+    {
+        std::unordered_map<uint32_t, ShaderHandle>::iterator i = _shaders.find(shaderId);
+        
+        if (i != _shaders.end())
+        {
+            _shaderPool.remove(i->second);
+            _shaders.erase(i);
+        }
+        
+        if (shader)
+        {
+            ShaderHandle handle = _shaderPool.add(shader);
+            
+            if (handle)
+            {
+                _shaders[shaderId] = handle;
+            }
+        }
+    }
+    
+    BMFont* Renderer::getFont(const std::string& filename)
+    {
+        std::unordered_map<std::string, AutoPtr<BMFont>>::const_iterator i = _fonts.find(filename);
+        
+        if (i != _fonts.end())
+        {
+            return i->second;
+        }
+        
+        BMFont* font = new BMFont(_engine);
+        
+        if (!font->initFromFile(filename))
+        {
+            delete font;
             return nullptr;
         }
+        
+        _fonts[filename] = font;
+        
+        return font;
     }
     
-    void Renderer::setShader(const std::string& shaderName, Shader* shader)
+    SpriteSheet* Renderer::getSpriteSheet(const std::string& filename)
     {
-        _shaders[shaderName] = shader;
+        std::unordered_map<std::string, AutoPtr<SpriteSheet>>::const_iterator i = _spriteSheets.find(filename);
+        
+        if (i != _spriteSheets.end())
+        {
+            return i->second;
+        }
+        
+        SpriteSheet* spriteSheet = new SpriteSheet(_engine);
+        
+        if (!spriteSheet->initFromFile(filename))
+        {
+            delete spriteSheet;
+            return nullptr;
+        }
+        
+        _spriteSheets[filename] = spriteSheet;
+        
+        return spriteSheet;
     }
     
     Shader* Renderer::loadShaderFromFiles(const std::string& fragmentShader, const std::string& vertexShader)
@@ -160,11 +512,32 @@ namespace ouzel
         return true;
     }
     
-    MeshBuffer* Renderer::createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    RenderTarget* Renderer::createRenderTarget(const Size2& size)
+    {
+        RenderTarget* renderTarget = new RenderTarget(this);
+        
+        if (!renderTarget->init(size))
+        {
+            delete renderTarget;
+            renderTarget = nullptr;
+        }
+        
+        return renderTarget;
+    }
+    
+    bool Renderer::activateRenderTarget(RenderTarget* renderTarget)
+    {
+        _activeRenderTarget = renderTarget;
+        
+        return true;
+    }
+    
+    MeshBuffer* Renderer::createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                           const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
     {
         MeshBuffer* meshBuffer = new MeshBuffer(this);
         
-        if (!meshBuffer->initFromData(indices, vertices))
+        if (!meshBuffer->initFromData(indices, indexSize, indexCount, vertices, vertexFormat, vertexCount, dynamic))
         {
             delete meshBuffer;
             meshBuffer = nullptr;
@@ -173,6 +546,18 @@ namespace ouzel
         return meshBuffer;
     }
     
+    MeshBuffer* Renderer::createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices, bool dynamic)
+    {
+        return createMeshBuffer(indices.data(), sizeof(uint16_t), static_cast<uint32_t>(indices.size()),
+                                vertices.data(), VertexFormat::getDefault(), static_cast<uint32_t>(vertices.size()), dynamic);
+    }
+    
+    MeshBuffer* Renderer::createMeshBuffer(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, bool dynamic)
+    {
+        return createMeshBuffer(indices.data(), sizeof(uint32_t), static_cast<uint32_t>(indices.size()),
+                                vertices.data(), VertexFormat::getDefault(), static_cast<uint32_t>(vertices.size()), dynamic);
+    }
+    
     bool Renderer::drawMeshBuffer(MeshBuffer* meshBuffer)
     {
         if (!_activeShader)
@@ -180,8 +565,61 @@ namespace ouzel
             return false;
         }
         
+        if (_overdrawMeasurementEnabled && _driver == Driver::NONE)
+        {
+            // area scales with the determinant of the 2D part of the transformation, clip space is 2 units wide and high
+            const Matrix4& transform = _activeShader->getVertexTransform();
+            float scale = fabsf(transform.m[0] * transform.m[5] - transform.m[1] * transform.m[4]);
+            
+            float fragmentCount = meshBuffer->getArea() * scale * _viewport.width * _viewport.height / 4.0f;
+            
+            // assume the fragments are spread evenly over the viewport
+            if (_scissorTest && _viewport.width > 0.0f && _viewport.height > 0.0f)
+            {
+                Rectangle scissorRectangle;
+                Rectangle::intersect(_viewport, _scissorRectangle, &scissorRectangle);
+                
+                fragmentCount *= (scissorRectangle.width * scissorRectangle.height) / (_viewport.width * _viewport.height);
+            }
+            
+            _fragmentCount += fragmentCount;
+        }
+        
         return true;
     }
+    
+    MeshBuffer* Renderer::getQuadMeshBuffer(const Rectangle& texCoords)
+    {
+        std::map<Rectangle, AutoPtr<MeshBuffer>, RectangleCompare>::const_iterator i = _quadMeshBuffers.find(texCoords);
+        
+        if (i != _quadMeshBuffers.end())
+        {
+            return i->second;
+        }
+        
+        float left = texCoords.x;
+        float right = texCoords.x + texCoords.width;
+        float top = texCoords.y;
+        float bottom = texCoords.y + texCoords.height;
+        
+        std::vector<uint16_t> indices = {0, 1, 2, 1, 3, 2};
+        
+        std::vector<Vertex> vertices = {
+            Vertex(Vector3(-0.5f, -0.5f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(left, bottom)),
+            Vertex(Vector3(0.5f, -0.5f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(right, bottom)),
+            Vertex(Vector3(-0.5f, 0.5f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(left, top)),
+            Vertex(Vector3(0.5f, 0.5f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(right, top))
+        };
+        
+        MeshBuffer* meshBuffer = createMeshBuffer(indices, vertices);
+        
+        if (meshBuffer)
+        {
+            _quadMeshBuffers[texCoords] = meshBuffer;
+        }
+        
+        return meshBuffer;
+    }
 
     Vector2 Renderer::absoluteToWorldLocation(const Vector2& position)
     {
@@ -189,11 +627,12 @@ namespace ouzel
         
         if (camera)
         {
-            float x = 2.0f * position.x / _size.width - 1.0f;
-            float y = 2.0f * position.y / _size.height - 1.0f;
+            const Rectangle& viewport = camera->getViewport();
+            
+            float x = 2.0f * (position.x / _size.width - viewport.x) / viewport.width - 1.0f;
+            float y = 2.0f * (position.y / _size.height - viewport.y) / viewport.height - 1.0f;
             
-            Matrix4 projViewMatrix = _projection * camera->getTransform();
-            Matrix4 inverseViewMatrix = projViewMatrix;
+            Matrix4 inverseViewMatrix = camera->getViewProjection();
             inverseViewMatrix.invert();
             
             Vector3 result = Vector3(x, y, 0.0f);
@@ -213,13 +652,13 @@ namespace ouzel
         
         if (camera)
         {
-            Matrix4 projViewMatrix = _projection * camera->getTransform();
+            const Rectangle& viewport = camera->getViewport();
             
             Vector3 result = Vector3(position.x, position.y, 0.0f);
-            projViewMatrix.transformPoint(&result);
+            camera->getViewProjection().transformPoint(&result);
             
-            float x = (result.x + 1.0f) / 2.0f * _size.width;
-            float y = (result.y + 1.0f) / 2.0f * _size.height;
+            float x = (viewport.x + (result.x + 1.0f) / 2.0f * viewport.width) * _size.width;
+            float y = (viewport.y + (result.y + 1.0f) / 2.0f * viewport.height) * _size.height;
             
             return Vector2(x, y);
         }
@@ -5,29 +5,43 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <unordered_map>
+#include <functional>
 #include "AutoPtr.h"
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
+#include "Hash.h"
+#include "Handle.h"
 #include "Rectangle.h"
 #include "Matrix4.h"
 #include "Size2.h"
 #include "Color.h"
 #include "Vertex.h"
+#include "VertexFormat.h"
+#include "PixelFormat.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "BMFont.h"
+#include "SpriteSheet.h"
+#include "RenderTarget.h"
 
 namespace ouzel
 {
     const uint32_t TEXTURE_LAYERS = 8;
     
-    const std::string SHADER_TEXTURE = "shaderTexture";
-    const std::string SHADER_COLOR = "shaderColor";
+    constexpr uint32_t SHADER_TEXTURE = hashString("shaderTexture");
+    constexpr uint32_t SHADER_COLOR = hashString("shaderColor");
     
     class Engine;
     class Node;
     class Sprite;
     class MeshBuffer;
+    class Image;
+    
+    typedef Handle<Texture> TextureHandle;
+    typedef Handle<Shader> ShaderHandle;
+    typedef Handle<MeshBuffer> MeshBufferHandle;
 
     class Renderer: public Noncopyable, public ReferenceCounted
     {
@@ -45,6 +59,10 @@ namespace ouzel
         Engine* getEngine() const { return _engine; }
         Driver getDriver() const { return _driver; }
         
+        // waits for the vertical blank when presenting, the frame pacer can limit the frame rate further
+        virtual void setVerticalSync(bool verticalSync) { _verticalSync = verticalSync; }
+        bool isVerticalSync() const { return _verticalSync; }
+        
         virtual void setClearColor(Color color) { _clearColor = color; }
         virtual Color getClearColor() const { return _clearColor; }
         
@@ -52,8 +70,54 @@ namespace ouzel
         
         virtual void begin();
         virtual void clear();
+        // clears only the depth of the active render target inside the viewport, for cameras that draw over others
+        virtual void clearDepth();
         virtual void flush();
         
+        // incremented at the beginning of every frame
+        uint32_t getCurrentFrame() const { return _currentFrame; }
+        
+        // RGBA pixels with the top row first, empty if the capture failed
+        typedef std::function<void(const Size2& size, const std::vector<uint8_t>& pixels)> CaptureCallback;
+        
+        // reads the screen or a render target at the end of the next drawn frame without waiting for the GPU,
+        // the scene is redrawn even if nothing changed, the callback is called when the pixels become available
+        bool captureFrame(const CaptureCallback& callback, RenderTarget* renderTarget = nullptr);
+        
+        // captures the next frame and writes it as a PNG on the engine thread pool
+        bool saveScreenshot(const std::string& path);
+        
+        // calls the callbacks of the finished captures, the engine calls it every frame even if nothing is drawn
+        void updateCaptures() { finishCaptures(); }
+        
+        // depth of everything drawn until the next call, 0 is the nearest and 1 the farthest
+        virtual void setDrawDepth(float depth) { _drawDepth = depth; }
+        float getDrawDepth() const { return _drawDepth; }
+        
+        virtual void setDepthState(bool depthTest, bool depthWrite) { _depthTest = depthTest; _depthWrite = depthWrite; }
+        bool getDepthTest() const { return _depthTest; }
+        bool getDepthWrite() const { return _depthWrite; }
+        
+        virtual void setBlendEnabled(bool blendEnabled) { _blendEnabled = blendEnabled; }
+        bool isBlendEnabled() const { return _blendEnabled; }
+        
+        // nullptr renders to the screen
+        virtual RenderTarget* createRenderTarget(const Size2& size);
+        virtual bool activateRenderTarget(RenderTarget* renderTarget);
+        RenderTarget* getActiveRenderTarget() const { return _activeRenderTarget; }
+        
+        // in pixels of the active render target, origin is in the bottom left corner
+        virtual void setViewport(const Rectangle& viewport) { _viewport = viewport; }
+        const Rectangle& getViewport() const { return _viewport; }
+        
+        // in pixels of the active render target, also limits clearing
+        virtual void setScissorTest(bool enabled, const Rectangle& rectangle = Rectangle()) { _scissorTest = enabled; _scissorRectangle = rectangle; }
+        bool getScissorTest() const { return _scissorTest; }
+        const Rectangle& getScissorRectangle() const { return _scissorRectangle; }
+        
+        // whether the screen keeps its contents between frames, so that only a part of it can be redrawn
+        virtual bool canRedrawPartially() const { return true; }
+        
         virtual const Size2& getSize() const { return _size; }
         virtual void resize(const Size2& size);
         
@@ -61,23 +125,80 @@ namespace ouzel
         virtual void setTitle(const std::string& title) { _title = title; }
         
         void preloadTexture(const std::string& filename);
+        // decodes the images on the engine's thread pool and uploads them when all are done, for loading a level at once
+        void preloadTextures(const std::vector<std::string>& filenames);
         Texture* getTexture(const std::string& filename);
+        // the handle stops resolving when the texture is evicted, 0 if the texture can't be loaded
+        TextureHandle getTextureHandle(const std::string& filename);
+        Texture* getTexture(TextureHandle handle) const { return _texturePool.get(handle); }
+        
+        // 0 means unlimited, textures used in the current frame are not evicted, so the usage can exceed the budget
+        void setTextureMemoryBudget(uint64_t budget);
+        uint64_t getTextureMemoryBudget() const { return _textureMemoryBudget; }
+        uint64_t getTextureMemoryUsage() const { return _textureMemoryUsage; }
+        // called by a cached texture when it is reloaded with a different size
+        void updateTextureMemoryUsage(Texture* texture, uint64_t previousMemorySize);
+        
+        // format of the textures loaded from the file from now on, also kept when the texture is reloaded
+        void setTexturePixelFormat(const std::string& filename, PixelFormat pixelFormat, bool dither = true);
+        // textures without a format of their own get the format suggested by Image::getSuggestedPixelFormat
+        void setAutomaticPixelFormatsEnabled(bool enabled) { _automaticPixelFormats = enabled; }
+        bool isAutomaticPixelFormatsEnabled() const { return _automaticPixelFormats; }
+        // loads the image and converts it to the format chosen for the file,
+        // can be called from other threads while the texture formats are not changed
+        bool loadTextureImage(Image* image, const std::string& filename) const;
+        
+        // textures loaded after enabling keep their mip chain in memory and upload only the levels needed for the size they are drawn at
+        void setTextureStreamingEnabled(bool enabled) { _textureStreamingEnabled = enabled; }
+        bool isTextureStreamingEnabled() const { return _textureStreamingEnabled; }
+        // changes the resident mip levels of the streamed textures, returns true if the scene has to be redrawn
+        bool updateStreamedTextures();
+        
+        // textures loaded after enabling get a mesh that skips their transparent border
+        void setAlphaTrimmingEnabled(bool enabled) { _alphaTrimmingEnabled = enabled; }
+        bool isAlphaTrimmingEnabled() const { return _alphaTrimmingEnabled; }
+        
         virtual Texture* loadTextureFromFile(const std::string& filename);
+        virtual Texture* loadTextureFromImage(Image* image);
         virtual bool activateTexture(Texture* texture, uint32_t layer);
         virtual Texture* getActiveTexture(uint32_t layer) const { return _activeTextures[layer]; }
         
-        Shader* getShader(const std::string& shaderName) const;
-        void setShader(const std::string& shaderName, Shader* shader);
+        // shaders are identified by hashed names, for example getShader(hashString("myShader"))
+        Shader* getShader(uint32_t shaderId) const;
+        ShaderHandle getShaderHandle(uint32_t shaderId) const;
+        Shader* getShader(ShaderHandle handle) const { return _shaderPool.get(handle); }
+        // handles of the shader that is replaced stop resolving
+        void setShader(uint32_t shaderId, Shader* shader);
         virtual Shader* loadShaderFromFiles(const std::string& fragmentShader, const std::string& vertexShader);
         virtual Shader* loadShaderFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize);
         virtual bool activateShader(Shader* shader);
         virtual Shader* getActiveShader() const { return _activeShader; }
         
-        virtual MeshBuffer* createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices);
+        BMFont* getFont(const std::string& filename);
+        SpriteSheet* getSpriteSheet(const std::string& filename);
+        
+        // dynamic mesh buffers can be updated with MeshBuffer::setIndices, setVertices, updateIndices and updateVertices
+        virtual MeshBuffer* createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                             const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false);
+        MeshBuffer* createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices, bool dynamic = false);
+        MeshBuffer* createMeshBuffer(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, bool dynamic = false);
         virtual bool drawMeshBuffer(MeshBuffer* meshBuffer);
         
+        // keeps the mesh buffer alive until it is removed, after which its handles stop resolving
+        MeshBufferHandle addMeshBuffer(MeshBuffer* meshBuffer) { return _meshBufferPool.add(meshBuffer); }
+        void removeMeshBuffer(MeshBufferHandle handle) { _meshBufferPool.remove(handle); }
+        MeshBuffer* getMeshBuffer(MeshBufferHandle handle) const { return _meshBufferPool.get(handle); }
+        
+        // unit quad centered around origin, shared by all users of the same texture coordinates
+        MeshBuffer* getQuadMeshBuffer(const Rectangle& texCoords = Rectangle(0.0f, 0.0f, 1.0f, 1.0f));
+        
         const Matrix4& getProjection() const { return _projection; }
         
+        // only the software renderer measures overdraw, it is the number of shaded fragments of the previous frame divided by the screen area
+        void setOverdrawMeasurementEnabled(bool enabled) { _overdrawMeasurementEnabled = enabled; }
+        bool isOverdrawMeasurementEnabled() const { return _overdrawMeasurementEnabled; }
+        float getOverdraw() const { return _overdraw; }
+        
         Vector2 absoluteToWorldLocation(const Vector2& position);
         Vector2 worldToAbsoluteLocation(const Vector2& position);
         
@@ -86,19 +207,83 @@ namespace ouzel
         virtual void drawQuad(const Rectangle& rectangle, const Color& color, const Matrix4& transform = Matrix4());
         
     protected:
+        TextureHandle addTexture(const std::string& filename, Texture* texture);
+        void evictTextures();
+        
+        struct CaptureRequest
+        {
+            CaptureCallback callback;
+            AutoPtr<RenderTarget> renderTarget;
+        };
+        
+        // issues the reads of the requested captures, called by flush before presenting
+        virtual void startCaptures();
+        // calls the callbacks of the captures that have finished
+        virtual void finishCaptures();
+        
         Engine* _engine;
         Driver _driver;
         
         Color _clearColor;
+        bool _verticalSync = true;
+        
+        float _drawDepth = 0.0f;
+        bool _depthTest = false;
+        bool _depthWrite = false;
+        bool _blendEnabled = true;
+        
+        AutoPtr<RenderTarget> _activeRenderTarget;
+        Rectangle _viewport;
+        bool _scissorTest = false;
+        Rectangle _scissorRectangle;
         
         Matrix4 _projection;
         
-        std::unordered_map<std::string, AutoPtr<Texture>> _textures;
-        std::unordered_map<std::string, AutoPtr<Shader>> _shaders;
+        std::unordered_map<std::string, TextureHandle> _textures;
+        HandlePool<Texture> _texturePool;
+        uint64_t _textureMemoryBudget = 0;
+        uint64_t _textureMemoryUsage = 0;
+        uint32_t _currentFrame = 0;
+        bool _alphaTrimmingEnabled = false;
+        bool _textureStreamingEnabled = false;
+        
+        struct TextureFormat
+        {
+            PixelFormat pixelFormat;
+            bool dither;
+        };
+        
+        std::unordered_map<std::string, TextureFormat> _textureFormats;
+        bool _automaticPixelFormats = false;
+        
+        std::unordered_map<uint32_t, ShaderHandle> _shaders;
+        HandlePool<Shader> _shaderPool;
+        std::unordered_map<std::string, AutoPtr<BMFont>> _fonts;
+        std::unordered_map<std::string, AutoPtr<SpriteSheet>> _spriteSheets;
+        
+        struct RectangleCompare
+        {
+            bool operator()(const Rectangle& a, const Rectangle& b) const
+            {
+                if (a.x != b.x) return a.x < b.x;
+                if (a.y != b.y) return a.y < b.y;
+                if (a.width != b.width) return a.width < b.width;
+                return a.height < b.height;
+            }
+        };
+        
+        std::map<Rectangle, AutoPtr<MeshBuffer>, RectangleCompare> _quadMeshBuffers;
+        HandlePool<MeshBuffer> _meshBufferPool;
         
         AutoPtr<Texture> _activeTextures[TEXTURE_LAYERS];
         AutoPtr<Shader> _activeShader = nullptr;
         
+        std::vector<CaptureRequest> _captureRequests;
+        
+        bool _overdrawMeasurementEnabled = false;
+        float _overdraw = 0.0f;
+        float _fragmentCount = 0.0f;
+        
         Size2 _size;
         bool _fullscreen = false;
         
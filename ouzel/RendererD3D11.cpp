@@ -3,6 +3,7 @@
 
 #include "RendererD3D11.h"
 #include "TextureD3D11.h"
+#include "RenderTargetD3D11.h"
 #include "ShaderD3D11.h"
 #include "MeshBufferD3D11.h"
 #include "Utils.h"
@@ -35,13 +36,34 @@ namespace ouzel
 
     RendererD3D11::~RendererD3D11()
     {
-        if (_depthStencilState) _depthStencilState->Release();
+        for (const PendingCapture& capture : _pendingCaptures)
+        {
+            capture.stagingTexture->Release();
+        }
+
+        for (ID3D11Texture2D* stagingTexture : _freeStagingTextures)
+        {
+            stagingTexture->Release();
+        }
+
+        for (ID3D11DepthStencilState* depthStencilState : _depthStencilStates)
+        {
+            if (depthStencilState) depthStencilState->Release();
+        }
+        if (_depthStencilView) _depthStencilView->Release();
+        if (_depthStencilTexture) _depthStencilTexture->Release();
         if (_blendState) _blendState->Release();
+        if (_noBlendState) _noBlendState->Release();
+        if (_noColorWriteBlendState) _noColorWriteBlendState->Release();
+        if (_depthOverwriteState) _depthOverwriteState->Release();
         if (_rasterizerState) _rasterizerState->Release();
+        if (_scissorRasterizerState) _scissorRasterizerState->Release();
+        if (_defaultAttributeBuffer) _defaultAttributeBuffer->Release();
         if (_samplerState) _samplerState->Release();
         if (_rtView) _rtView->Release();
         if (_backBuffer) _backBuffer->Release();
         if (_swapChain) _swapChain->Release();
+        if (_context1) _context1->Release();
     }
 
     void RendererD3D11::initWindow()
@@ -107,7 +129,7 @@ namespace ouzel
         swapChainDesc.BufferCount = 1;
         swapChainDesc.OutputWindow = _window;
         swapChainDesc.Windowed = _fullscreen == false;
-        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_SEQUENTIAL; // keeps the back buffer contents for partial redraws
         swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
 
         UINT deviceCreationFlags = 0;
@@ -134,6 +156,13 @@ namespace ouzel
             return;
         }
 
+        // clearing only the scissor rectangle needs Direct3D 11.1
+        hr = _context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&_context1);
+        if (FAILED(hr))
+        {
+            _context1 = nullptr;
+        }
+
         // Backbuffer
         hr = _swapChain->GetBuffer(0, IID_ID3D11Texture2D, (void**)&_backBuffer);
         if (FAILED(hr) || !_backBuffer)
@@ -186,6 +215,15 @@ namespace ouzel
             return;
         }
 
+        rasterStateDesc.ScissorEnable = TRUE;
+
+        hr = _device->CreateRasterizerState(&rasterStateDesc, &_scissorRasterizerState);
+        if (FAILED(hr) || !_scissorRasterizerState)
+        {
+            log("Failed to create D3D11 rasterizer state");
+            return;
+        }
+
         // Blending state
         D3D11_BLEND_DESC blendStateDesc = { FALSE, FALSE }; // alpha to coverage, independent blend
         D3D11_RENDER_TARGET_BLEND_DESC targetBlendDesc =
@@ -204,41 +242,406 @@ namespace ouzel
             return;
         }
 
-        // Depth/stencil state
-        D3D11_DEPTH_STENCIL_DESC depthStencilStateDesc =
+        // opaque nodes are drawn without blending
+        blendStateDesc.RenderTarget[0].BlendEnable = FALSE;
+
+        hr = _device->CreateBlendState(&blendStateDesc, &_noBlendState);
+        if (FAILED(hr) || !_noBlendState)
         {
-            FALSE, // enable depth?
-                   // ...
-        };
-        hr = _device->CreateDepthStencilState(&depthStencilStateDesc, &_depthStencilState);
-        if (FAILED(hr) || !_depthStencilState)
+            log("Failed to create D3D11 blend state");
+            return;
+        }
+
+        blendStateDesc.RenderTarget[0].RenderTargetWriteMask = 0;
+
+        hr = _device->CreateBlendState(&blendStateDesc, &_noColorWriteBlendState);
+        if (FAILED(hr) || !_noColorWriteBlendState)
+        {
+            log("Failed to create D3D11 blend state");
+            return;
+        }
+
+        // Depth buffer
+        D3D11_TEXTURE2D_DESC depthStencilDesc;
+        memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+        depthStencilDesc.Width = (UINT)_size.width;
+        depthStencilDesc.Height = (UINT)_size.height;
+        depthStencilDesc.MipLevels = 1;
+        depthStencilDesc.ArraySize = 1;
+        depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+        depthStencilDesc.SampleDesc.Count = 1;
+        depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+        depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+
+        hr = _device->CreateTexture2D(&depthStencilDesc, nullptr, &_depthStencilTexture);
+        if (FAILED(hr) || !_depthStencilTexture)
+        {
+            log("Failed to create D3D11 depth stencil texture");
+            return;
+        }
+
+        hr = _device->CreateDepthStencilView(_depthStencilTexture, nullptr, &_depthStencilView);
+        if (FAILED(hr) || !_depthStencilView)
+        {
+            log("Failed to create D3D11 depth stencil view");
+            return;
+        }
+
+        // Depth/stencil states for every combination of depth test and depth write
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            D3D11_DEPTH_STENCIL_DESC depthStencilStateDesc;
+            memset(&depthStencilStateDesc, 0, sizeof(depthStencilStateDesc));
+            depthStencilStateDesc.DepthEnable = (i & 2) ? TRUE : FALSE;
+            depthStencilStateDesc.DepthWriteMask = (i & 1) ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+            depthStencilStateDesc.DepthFunc = D3D11_COMPARISON_LESS;
+            depthStencilStateDesc.StencilEnable = FALSE;
+
+            hr = _device->CreateDepthStencilState(&depthStencilStateDesc, &_depthStencilStates[i]);
+            if (FAILED(hr) || !_depthStencilStates[i])
+            {
+                log("Failed to create D3D11 depth stencil state");
+                return;
+            }
+        }
+
+        D3D11_DEPTH_STENCIL_DESC depthOverwriteDesc;
+        memset(&depthOverwriteDesc, 0, sizeof(depthOverwriteDesc));
+        depthOverwriteDesc.DepthEnable = TRUE;
+        depthOverwriteDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+        depthOverwriteDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+        depthOverwriteDesc.StencilEnable = FALSE;
+
+        hr = _device->CreateDepthStencilState(&depthOverwriteDesc, &_depthOverwriteState);
+        if (FAILED(hr) || !_depthOverwriteState)
         {
             log("Failed to create D3D11 depth stencil state");
             return;
         }
 
+        const uint32_t defaultAttributes[3] = { 0xFFFFFFFF, 0, 0 }; // RGBA8 color and two floats
+
+        D3D11_BUFFER_DESC defaultAttributeBufferDesc;
+        memset(&defaultAttributeBufferDesc, 0, sizeof(defaultAttributeBufferDesc));
+        defaultAttributeBufferDesc.ByteWidth = sizeof(defaultAttributes);
+        defaultAttributeBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+        defaultAttributeBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA defaultAttributeData;
+        memset(&defaultAttributeData, 0, sizeof(defaultAttributeData));
+        defaultAttributeData.pSysMem = defaultAttributes;
+
+        hr = _device->CreateBuffer(&defaultAttributeBufferDesc, &defaultAttributeData, &_defaultAttributeBuffer);
+        if (FAILED(hr) || !_defaultAttributeBuffer)
+        {
+            log("Failed to create D3D11 default attribute buffer");
+            return;
+        }
+
         Shader* textureShader = loadShaderFromBuffers(TEXTURE_PIXEL_SHADER_D3D11, sizeof(TEXTURE_PIXEL_SHADER_D3D11),
                                                       TEXTURE_VERTEX_SHADER_D3D11, sizeof(TEXTURE_VERTEX_SHADER_D3D11));
 
         if (textureShader)
         {
-            _shaders[SHADER_TEXTURE] = textureShader;
+            setShader(SHADER_TEXTURE, textureShader);
         }
 
         D3D11_VIEWPORT viewport = { 0, 0, _size.width, _size.height, 0.0f, 1.0f };
         _context->RSSetViewports(1, &viewport);
-        _context->OMSetRenderTargets(1, &_rtView, nullptr);
+        _context->OMSetRenderTargets(1, &_rtView, _depthStencilView);
+    }
+
+    void RendererD3D11::setDrawDepth(float depth)
+    {
+        Renderer::setDrawDepth(depth);
+
+        updateViewport();
+    }
+
+    RenderTarget* RendererD3D11::createRenderTarget(const Size2& size)
+    {
+        RenderTargetD3D11* renderTarget = new RenderTargetD3D11(this);
+
+        if (!renderTarget->init(size))
+        {
+            delete renderTarget;
+            renderTarget = nullptr;
+        }
+
+        return renderTarget;
+    }
+
+    bool RendererD3D11::activateRenderTarget(RenderTarget* renderTarget)
+    {
+        if (_activeRenderTarget == renderTarget)
+        {
+            return true;
+        }
+
+        Renderer::activateRenderTarget(renderTarget);
+
+        if (renderTarget)
+        {
+            RenderTargetD3D11* renderTargetD3D11 = static_cast<RenderTargetD3D11*>(renderTarget);
+            ID3D11RenderTargetView* renderTargetView = renderTargetD3D11->getRenderTargetView();
+            _context->OMSetRenderTargets(1, &renderTargetView, renderTargetD3D11->getDepthStencilView());
+        }
+        else
+        {
+            _context->OMSetRenderTargets(1, &_rtView, _depthStencilView);
+        }
+
+        return true;
+    }
+
+    void RendererD3D11::setViewport(const Rectangle& viewport)
+    {
+        Renderer::setViewport(viewport);
+
+        updateViewport();
+    }
+
+    void RendererD3D11::setScissorTest(bool enabled, const Rectangle& rectangle)
+    {
+        Renderer::setScissorTest(enabled, rectangle);
+
+        if (enabled)
+        {
+            // D3D11 rectangles have the origin in the top left corner
+            float targetHeight = _activeRenderTarget ? _activeRenderTarget->getSize().height : _size.height;
+
+            D3D11_RECT scissorRect = { static_cast<LONG>(rectangle.x), static_cast<LONG>(targetHeight - rectangle.y - rectangle.height),
+                                       static_cast<LONG>(rectangle.x + rectangle.width), static_cast<LONG>(targetHeight - rectangle.y) };
+            _context->RSSetScissorRects(1, &scissorRect);
+        }
+    }
+
+    void RendererD3D11::updateViewport()
+    {
+        // D3D11 viewport origin is in the top left corner
+        float targetHeight = _activeRenderTarget ? _activeRenderTarget->getSize().height : _size.height;
+
+        D3D11_VIEWPORT viewport = { _viewport.x, targetHeight - _viewport.y - _viewport.height,
+                                    _viewport.width, _viewport.height, _drawDepth, _drawDepth };
+        _context->RSSetViewports(1, &viewport);
     }
 
     void RendererD3D11::clear()
     {
-        float color[4] = { _clearColor.getR(), _clearColor.getG(), _clearColor.getB(), _clearColor.getA() };
-        _context->ClearRenderTargetView(_rtView, color);
+        ID3D11RenderTargetView* renderTargetView = _rtView;
+        ID3D11DepthStencilView* depthStencilView = _depthStencilView;
+        Color clearColor = _clearColor;
+
+        if (_activeRenderTarget)
+        {
+            RenderTargetD3D11* renderTargetD3D11 = static_cast<RenderTargetD3D11*>(_activeRenderTarget.item);
+
+            renderTargetView = renderTargetD3D11->getRenderTargetView();
+            depthStencilView = renderTargetD3D11->getDepthStencilView();
+            clearColor = renderTargetD3D11->getClearColor();
+        }
+
+        float color[4] = { clearColor.getR(), clearColor.getG(), clearColor.getB(), clearColor.getA() };
+
+        // ClearRenderTargetView ignores the scissor rectangle, depth outside of it is never tested
+        if (_scissorTest && _context1)
+        {
+            float targetHeight = _activeRenderTarget ? _activeRenderTarget->getSize().height : _size.height;
+
+            D3D11_RECT clearRect = { static_cast<LONG>(_scissorRectangle.x), static_cast<LONG>(targetHeight - _scissorRectangle.y - _scissorRectangle.height),
+                                     static_cast<LONG>(_scissorRectangle.x + _scissorRectangle.width), static_cast<LONG>(targetHeight - _scissorRectangle.y) };
+            _context1->ClearView(renderTargetView, color, &clearRect, 1);
+        }
+        else
+        {
+            _context->ClearRenderTargetView(renderTargetView, color);
+        }
+
+        _context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+    }
+
+    void RendererD3D11::clearDepth()
+    {
+        ID3D11DepthStencilView* depthStencilView = _depthStencilView;
+        Size2 targetSize = _size;
+
+        if (_activeRenderTarget)
+        {
+            depthStencilView = static_cast<RenderTargetD3D11*>(_activeRenderTarget.item)->getDepthStencilView();
+            targetSize = _activeRenderTarget->getSize();
+        }
+
+        if (_viewport.x <= 0.0f && _viewport.y <= 0.0f &&
+            _viewport.x + _viewport.width >= targetSize.width && _viewport.y + _viewport.height >= targetSize.height)
+        {
+            _context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+            return;
+        }
+
+        // a quad covering the viewport overwrites the depth with the far value and leaves the colors untouched
+        ShaderD3D11* shaderD3D11 = static_cast<ShaderD3D11*>(getShader(SHADER_TEXTURE));
+        MeshBufferD3D11* meshBufferD3D11 = static_cast<MeshBufferD3D11*>(getQuadMeshBuffer());
+
+        if (!shaderD3D11 || !meshBufferD3D11 || !meshBufferD3D11->uploadBuffers())
+        {
+            return;
+        }
+
+        ID3D11InputLayout* inputLayout = shaderD3D11->getInputLayout(meshBufferD3D11->getVertexFormat());
+
+        if (!inputLayout)
+        {
+            return;
+        }
+
+        Matrix4 transform;
+        Matrix4::createScale(2.0f, 2.0f, 1.0f, &transform);
+        shaderD3D11->setVertexShaderConstant(0, &transform, 1);
+
+        ID3D11Buffer* vertexShaderConstantBuffers[1] = { shaderD3D11->getVertexShaderConstantBuffer() };
+        _context->VSSetConstantBuffers(0, 1, vertexShaderConstantBuffers);
+        _context->PSSetShader(shaderD3D11->getPixelShader(), nullptr, 0);
+        _context->VSSetShader(shaderD3D11->getVertexShader(), nullptr, 0);
+
+        _context->RSSetState(_scissorTest ? _scissorRasterizerState : _rasterizerState);
+        _context->OMSetBlendState(_noColorWriteBlendState, NULL, 0xffffffff);
+        _context->OMSetDepthStencilState(_depthOverwriteState, 0);
+
+        // the viewport depth range decides the written depth
+        D3D11_VIEWPORT viewport = { _viewport.x, targetSize.height - _viewport.y - _viewport.height,
+                                    _viewport.width, _viewport.height, 1.0f, 1.0f };
+        _context->RSSetViewports(1, &viewport);
+
+        _context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        _context->IASetInputLayout(inputLayout);
+
+        ID3D11Buffer* buffers[] = { meshBufferD3D11->getVertexBuffer(), _defaultAttributeBuffer };
+        UINT strides[] = { meshBufferD3D11->getVertexFormat().getStride(), 0 };
+        UINT offsets[] = { 0, 0 };
+        _context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+        _context->IASetIndexBuffer(meshBufferD3D11->getIndexBuffer(), meshBufferD3D11->getIndexFormat(), 0);
+
+        _context->DrawIndexed(meshBufferD3D11->getIndexCount(), 0, 0);
+
+        updateViewport();
     }
 
     void RendererD3D11::flush()
     {
-        _swapChain->Present(1 /* TODO vsync off? */, 0);
+        startCaptures();
+
+        _swapChain->Present(_verticalSync ? 1 : 0, 0);
+    }
+
+    void RendererD3D11::startCaptures()
+    {
+        for (const CaptureRequest& request : _captureRequests)
+        {
+            PendingCapture capture;
+            capture.callback = request.callback;
+
+            ID3D11Texture2D* texture = _backBuffer;
+
+            if (request.renderTarget)
+            {
+                texture = static_cast<TextureD3D11*>(request.renderTarget->getTexture())->getTexture();
+            }
+
+            D3D11_TEXTURE2D_DESC textureDesc;
+            texture->GetDesc(&textureDesc);
+
+            capture.size = Size2(static_cast<float>(textureDesc.Width), static_cast<float>(textureDesc.Height));
+
+            for (std::vector<ID3D11Texture2D*>::iterator i = _freeStagingTextures.begin(); i != _freeStagingTextures.end(); ++i)
+            {
+                D3D11_TEXTURE2D_DESC stagingTextureDesc;
+                (*i)->GetDesc(&stagingTextureDesc);
+
+                if (stagingTextureDesc.Width == textureDesc.Width &&
+                    stagingTextureDesc.Height == textureDesc.Height &&
+                    stagingTextureDesc.Format == textureDesc.Format &&
+                    stagingTextureDesc.MipLevels == textureDesc.MipLevels)
+                {
+                    capture.stagingTexture = *i;
+                    _freeStagingTextures.erase(i);
+                    break;
+                }
+            }
+
+            if (!capture.stagingTexture)
+            {
+                textureDesc.Usage = D3D11_USAGE_STAGING;
+                textureDesc.BindFlags = 0;
+                textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                textureDesc.MiscFlags = 0;
+
+                HRESULT hr = _device->CreateTexture2D(&textureDesc, nullptr, &capture.stagingTexture);
+                if (FAILED(hr) || !capture.stagingTexture)
+                {
+                    log("Failed to create D3D11 staging texture");
+                    capture.callback(capture.size, std::vector<uint8_t>());
+                    continue;
+                }
+            }
+
+            // the copy is done by the GPU, the staging texture is mapped when it has finished
+            _context->CopyResource(capture.stagingTexture, texture);
+
+            _pendingCaptures.push_back(capture);
+        }
+
+        _captureRequests.clear();
+    }
+
+    void RendererD3D11::finishCaptures()
+    {
+        std::vector<std::pair<PendingCapture, std::vector<uint8_t>>> finishedCaptures;
+
+        for (std::vector<PendingCapture>::iterator i = _pendingCaptures.begin(); i != _pendingCaptures.end();)
+        {
+            D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+            HRESULT hr = _context->Map(i->stagingTexture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedSubresource);
+
+            if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+            {
+                ++i;
+                continue;
+            }
+
+            std::vector<uint8_t> pixels;
+
+            if (SUCCEEDED(hr))
+            {
+                UINT width = static_cast<UINT>(i->size.width);
+                UINT height = static_cast<UINT>(i->size.height);
+                UINT pitch = width * 4;
+
+                pixels.resize(pitch * height);
+
+                // rows of the mapped texture can be padded
+                for (UINT row = 0; row < height; ++row)
+                {
+                    memcpy(pixels.data() + row * pitch, static_cast<const uint8_t*>(mappedSubresource.pData) + row * mappedSubresource.RowPitch, pitch);
+                }
+
+                _context->Unmap(i->stagingTexture, 0);
+            }
+            else
+            {
+                log("Failed to map D3D11 staging texture");
+            }
+
+            _freeStagingTextures.push_back(i->stagingTexture);
+
+            finishedCaptures.push_back(std::make_pair(*i, pixels));
+            i = _pendingCaptures.erase(i);
+        }
+
+        // callbacks can request new captures
+        for (const std::pair<PendingCapture, std::vector<uint8_t>>& capture : finishedCaptures)
+        {
+            capture.first.callback(capture.first.size, capture.second);
+        }
     }
 
     Texture* RendererD3D11::loadTextureFromFile(const std::string& filename)
@@ -254,6 +657,19 @@ namespace ouzel
         return texture;
     }
 
+    Texture* RendererD3D11::loadTextureFromImage(Image* image)
+    {
+        TextureD3D11* texture = new TextureD3D11(this);
+
+        if (!texture->initFromFile(image))
+        {
+            delete texture;
+            texture = nullptr;
+        }
+
+        return texture;
+    }
+
     Shader* RendererD3D11::loadShaderFromFiles(const std::string& fragmentShader, const std::string& vertexShader)
     {
         ShaderD3D11* shader = new ShaderD3D11(this);
@@ -290,11 +706,12 @@ namespace ouzel
         return true;
     }
 
-    MeshBuffer* RendererD3D11::createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    MeshBuffer* RendererD3D11::createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                                const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
     {
         MeshBufferD3D11* meshBuffer = new MeshBufferD3D11(this);
 
-        if (!meshBuffer->initFromData(indices, vertices))
+        if (!meshBuffer->initFromData(indices, indexSize, indexCount, vertices, vertexFormat, vertexCount, dynamic))
         {
             delete meshBuffer;
             meshBuffer = nullptr;
@@ -324,9 +741,9 @@ namespace ouzel
             _context->PSSetShader(shaderD3D11->getPixelShader(), nullptr, 0);
             _context->VSSetShader(shaderD3D11->getVertexShader(), nullptr, 0);
 
-            _context->RSSetState(_rasterizerState);
-            _context->OMSetBlendState(_blendState, NULL, 0xffffffff);
-            _context->OMSetDepthStencilState(_depthStencilState, 0);
+            _context->RSSetState(_scissorTest ? _scissorRasterizerState : _rasterizerState);
+            _context->OMSetBlendState(_blendEnabled ? _blendState : _noBlendState, NULL, 0xffffffff);
+            _context->OMSetDepthStencilState(_depthStencilStates[(_depthTest ? 2 : 0) + (_depthWrite ? 1 : 0)], 0);
         }
 
         ID3D11ShaderResourceView* resourceViews[TEXTURE_LAYERS];
@@ -340,14 +757,26 @@ namespace ouzel
         _context->PSSetShaderResources(0, TEXTURE_LAYERS, resourceViews);
         _context->PSSetSamplers(0, TEXTURE_LAYERS, samplerStates);
 
+        if (!meshBufferD3D11->uploadBuffers())
+        {
+            return false;
+        }
+
+        ID3D11InputLayout* inputLayout = shaderD3D11->getInputLayout(meshBufferD3D11->getVertexFormat());
+
+        if (!inputLayout)
+        {
+            return false;
+        }
+
         _context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        _context->IASetInputLayout(shaderD3D11->getInputLayout());
+        _context->IASetInputLayout(inputLayout);
 
-        ID3D11Buffer* buffers[] = { meshBufferD3D11->getVertexBuffer() };
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        _context->IASetVertexBuffers(0, 1, buffers, &stride, &offset);
-        _context->IASetIndexBuffer(meshBufferD3D11->getIndexBuffer(), DXGI_FORMAT_R16_UINT, 0);
+        ID3D11Buffer* buffers[] = { meshBufferD3D11->getVertexBuffer(), _defaultAttributeBuffer };
+        UINT strides[] = { meshBufferD3D11->getVertexFormat().getStride(), 0 };
+        UINT offsets[] = { 0, 0 };
+        _context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+        _context->IASetIndexBuffer(meshBufferD3D11->getIndexBuffer(), meshBufferD3D11->getIndexFormat(), 0);
 
         _context->DrawIndexed(meshBufferD3D11->getIndexCount(), 0, 0);
 
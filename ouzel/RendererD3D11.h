@@ -4,7 +4,7 @@
 #pragma once
 
 #include <windows.h>
-#include <d3d11.h>
+#include <d3d11_1.h>
 #include "Renderer.h"
 
 namespace ouzel
@@ -18,32 +18,72 @@ namespace ouzel
         void initWindow();
         void initD3D11();
 
+        virtual void setDrawDepth(float depth) override;
+
+        virtual RenderTarget* createRenderTarget(const Size2& size) override;
+        virtual bool activateRenderTarget(RenderTarget* renderTarget) override;
+        virtual void setViewport(const Rectangle& viewport) override;
+        virtual void setScissorTest(bool enabled, const Rectangle& rectangle = Rectangle()) override;
+        virtual bool canRedrawPartially() const override { return _context1 != nullptr; }
+
         virtual void clear() override;
+        virtual void clearDepth() override;
         virtual void flush() override;
 
         virtual Texture* loadTextureFromFile(const std::string& filename) override;
+        virtual Texture* loadTextureFromImage(Image* image) override;
 
         virtual Shader* loadShaderFromFiles(const std::string& fragmentShader, const std::string& vertexShader) override;
         virtual Shader* loadShaderFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize) override;
         virtual bool activateShader(Shader* shader);
 
-        virtual MeshBuffer* createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices);
+        using Renderer::createMeshBuffer;
+        virtual MeshBuffer* createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                             const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false) override;
         virtual bool drawMeshBuffer(MeshBuffer* meshBuffer);
 
         ID3D11Device* getDevice() const { return _device; }
         ID3D11DeviceContext* getContext() const { return _context; }
 
+    protected:
+        virtual void startCaptures() override;
+        virtual void finishCaptures() override;
+
     private:
+        struct PendingCapture
+        {
+            CaptureCallback callback;
+            Size2 size;
+            ID3D11Texture2D* stagingTexture = nullptr;
+        };
+
+        void updateViewport();
+
         HWND _window;
 
         ID3D11Device* _device = nullptr;
         ID3D11DeviceContext* _context = nullptr;
+        ID3D11DeviceContext1* _context1 = nullptr;
         IDXGISwapChain* _swapChain = nullptr;
         ID3D11Texture2D* _backBuffer = nullptr;
         ID3D11RenderTargetView* _rtView = nullptr;
         ID3D11SamplerState* _samplerState = nullptr;
         ID3D11RasterizerState* _rasterizerState = nullptr;
+        ID3D11RasterizerState* _scissorRasterizerState = nullptr;
+        // white color and zero texture coordinates for vertex formats that lack them
+        ID3D11Buffer* _defaultAttributeBuffer = nullptr;
         ID3D11BlendState* _blendState = nullptr;
-        ID3D11DepthStencilState* _depthStencilState = nullptr;
+        ID3D11BlendState* _noBlendState = nullptr;
+        // used for clearing the depth of a part of the target, which ClearDepthStencilView can't do
+        ID3D11BlendState* _noColorWriteBlendState = nullptr;
+        ID3D11DepthStencilState* _depthOverwriteState = nullptr;
+        ID3D11Texture2D* _depthStencilTexture = nullptr;
+        ID3D11DepthStencilView* _depthStencilView = nullptr;
+        // indexed by depth test * 2 + depth write
+        ID3D11DepthStencilState* _depthStencilStates[4] = { nullptr, nullptr, nullptr, nullptr };
+
+        std::vector<PendingCapture> _pendingCaptures;
+        // staging textures are reused, because creating them can take longer than a frame
+        std::vector<ID3D11Texture2D*> _freeStagingTextures;
     };
 }
@@ -1,6 +1,7 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <cstring>
 #include "RendererOGL.h"
 #include "TextureOGL.h"
 #include "RenderTargetOGL.h"
@@ -17,20 +18,85 @@
 
 namespace ouzel
 {
+#ifdef OUZEL_OPENGL_DEBUG_OUTPUT
+    static void APIENTRY debugMessageCallback(GLenum, GLenum, GLuint id, GLenum severity,
+                                              GLsizei, const GLchar* message, const void*)
+    {
+        if (severity != GL_DEBUG_SEVERITY_NOTIFICATION)
+        {
+            log("OpenGL debug message: %s (%x)", message, id);
+        }
+    }
+    
+    static bool hasExtension(const char* name)
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        
+        for (GLint i = 0; i < extensionCount; ++i)
+        {
+            if (strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+#endif
+    
     RendererOGL::RendererOGL(const Size2& size, bool fullscreen, Engine* engine):
         Renderer(size, fullscreen, engine, Driver::OPENGL)
     {
         recalculateProjection();
     }
     
+    RendererOGL::~RendererOGL()
+    {
+#ifndef OUZEL_PLATFORM_IOS
+        for (const PendingCapture& capture : _pendingCaptures)
+        {
+            glDeleteSync(capture.fence);
+            glDeleteBuffers(1, &capture.pixelBufferId);
+        }
+        
+        if (!_freePixelBuffers.empty())
+        {
+            glDeleteBuffers(static_cast<GLsizei>(_freePixelBuffers.size()), _freePixelBuffers.data());
+        }
+#endif
+    }
+    
     bool RendererOGL::initOpenGL(uint32_t width, uint32_t height)
     {
-        //glEnable(GL_DEPTH_TEST);
+#ifdef OUZEL_OPENGL_DEBUG_OUTPUT
+        if (hasExtension("GL_KHR_debug"))
+        {
+            glEnable(GL_DEBUG_OUTPUT);
+            glDebugMessageCallback(debugMessageCallback, this);
+            _debugOutput = true;
+        }
+#endif
+        
+        // the screen is not necessarily frame buffer 0, e.g. on iOS
+        GLint frameBufferId = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &frameBufferId);
+        _frameBufferId = static_cast<GLuint>(frameBufferId);
+        
+        // depth test is enabled by the scene only while drawing opaque nodes
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_FALSE);
         glClearColor(_clearColor.getR(), _clearColor.getG(), _clearColor.getB(), _clearColor.getA());
         
+        setVerticalSync(_verticalSync);
+        
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         
+        // used by vertex formats without colors or texture coordinates
+        glVertexAttrib4f(static_cast<GLuint>(VertexUsage::COLOR), 1.0f, 1.0f, 1.0f, 1.0f);
+        glVertexAttrib4f(static_cast<GLuint>(VertexUsage::TEXCOORD), 0.0f, 0.0f, 0.0f, 1.0f);
+        
         //glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
         //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
         
@@ -46,13 +112,13 @@ namespace ouzel
         Shader* textureShader = loadShaderFromBuffers(TEXTURE_PIXEL_SHADER_OGL, sizeof(TEXTURE_PIXEL_SHADER_OGL), TEXTURE_VERTEX_SHADER_OGL, sizeof(TEXTURE_VERTEX_SHADER_OGL));
         if (textureShader)
         {
-            _shaders[SHADER_TEXTURE] = textureShader;
+            setShader(SHADER_TEXTURE, textureShader);
         }
         
         Shader* colorShader = loadShaderFromBuffers(COLOR_PIXEL_SHADER_OGL, sizeof(COLOR_PIXEL_SHADER_OGL), COLOR_VERTEX_SHADER_OGL, sizeof(COLOR_VERTEX_SHADER_OGL));
         if (colorShader)
         {
-            _shaders[SHADER_COLOR] = colorShader;
+            setShader(SHADER_COLOR, colorShader);
         }
         
         _ready = true;
@@ -62,11 +128,19 @@ namespace ouzel
         return true;
     }
     
+#ifdef OUZEL_DEBUG
     bool RendererOGL::checkOpenGLErrors()
     {
-        bool error = false;
+        // errors are already reported by the debug message callback
+        if (_debugOutput)
+        {
+            return false;
+        }
+        
+        bool result = false;
+        GLenum error;
         
-        while (GLenum error = glGetError() != GL_NO_ERROR)
+        while ((error = glGetError()) != GL_NO_ERROR)
         {
             printf("OpenGL error: ");
             
@@ -82,10 +156,27 @@ namespace ouzel
             
             printf(" (%x)\n", error);
             
-            error = true;
+            result = true;
         }
         
-        return error;
+        return result;
+    }
+#endif
+    
+    void RendererOGL::setVerticalSync(bool verticalSync)
+    {
+        Renderer::setVerticalSync(verticalSync);
+        
+#if defined(OUZEL_PLATFORM_OSX)
+        // iOS always presents on the vertical blank
+        CGLContextObj context = CGLGetCurrentContext();
+        
+        if (context)
+        {
+            GLint swapInterval = _verticalSync ? 1 : 0;
+            CGLSetParameter(context, kCGLCPSwapInterval, &swapInterval);
+        }
+#endif
     }
     
     void RendererOGL::setClearColor(Color color)
@@ -99,24 +190,320 @@ namespace ouzel
     {
         Renderer::recalculateProjection();
         
-        if (_ready)
+        if (_ready && !_activeRenderTarget)
         {
             glViewport(0, 0, _size.width, _size.height);
         }
     }
     
+    void RendererOGL::setDrawDepth(float depth)
+    {
+        Renderer::setDrawDepth(depth);
+        
+#if defined(OUZEL_PLATFORM_IOS)
+        glDepthRangef(depth, depth);
+#else
+        glDepthRange(depth, depth);
+#endif
+    }
+    
+    void RendererOGL::setDepthState(bool depthTest, bool depthWrite)
+    {
+        if (depthTest != _depthTest)
+        {
+            if (depthTest) glEnable(GL_DEPTH_TEST);
+            else glDisable(GL_DEPTH_TEST);
+        }
+        
+        if (depthWrite != _depthWrite)
+        {
+            glDepthMask(depthWrite ? GL_TRUE : GL_FALSE);
+        }
+        
+        Renderer::setDepthState(depthTest, depthWrite);
+    }
+    
+    void RendererOGL::setBlendEnabled(bool blendEnabled)
+    {
+        if (blendEnabled != _blendEnabled)
+        {
+            if (blendEnabled) glEnable(GL_BLEND);
+            else glDisable(GL_BLEND);
+        }
+        
+        Renderer::setBlendEnabled(blendEnabled);
+    }
+    
+    RenderTarget* RendererOGL::createRenderTarget(const Size2& size)
+    {
+        RenderTargetOGL* renderTarget = new RenderTargetOGL(this);
+        
+        if (!renderTarget->init(size))
+        {
+            delete renderTarget;
+            renderTarget = nullptr;
+        }
+        
+        return renderTarget;
+    }
+    
+    bool RendererOGL::activateRenderTarget(RenderTarget* renderTarget)
+    {
+        if (_activeRenderTarget == renderTarget)
+        {
+            return true;
+        }
+        
+        Renderer::activateRenderTarget(renderTarget);
+        
+        glBindFramebuffer(GL_FRAMEBUFFER, getActiveFrameBufferId());
+        
+        if (checkOpenGLErrors())
+        {
+            return false;
+        }
+        
+        return true;
+    }
+    
+    GLuint RendererOGL::getActiveFrameBufferId() const
+    {
+        if (_activeRenderTarget)
+        {
+            return static_cast<RenderTargetOGL*>(_activeRenderTarget.item)->getFrameBufferId();
+        }
+        
+        return _frameBufferId;
+    }
+    
+    void RendererOGL::setViewport(const Rectangle& viewport)
+    {
+        Renderer::setViewport(viewport);
+        
+        glViewport(static_cast<GLint>(viewport.x), static_cast<GLint>(viewport.y),
+                   static_cast<GLsizei>(viewport.width), static_cast<GLsizei>(viewport.height));
+    }
+    
+    void RendererOGL::setScissorTest(bool enabled, const Rectangle& rectangle)
+    {
+        if (enabled != _scissorTest)
+        {
+            if (enabled) glEnable(GL_SCISSOR_TEST);
+            else glDisable(GL_SCISSOR_TEST);
+        }
+        
+        if (enabled)
+        {
+            glScissor(static_cast<GLint>(rectangle.x), static_cast<GLint>(rectangle.y),
+                      static_cast<GLsizei>(rectangle.width), static_cast<GLsizei>(rectangle.height));
+        }
+        
+        Renderer::setScissorTest(enabled, rectangle);
+    }
+    
     void RendererOGL::clear()
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // depth mask also applies to clearing
+        if (!_depthWrite) glDepthMask(GL_TRUE);
+        
+        if (_activeRenderTarget)
+        {
+            const Color& clearColor = _activeRenderTarget->getClearColor();
+            glClearColor(clearColor.getR(), clearColor.getG(), clearColor.getB(), clearColor.getA());
+            
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            
+            glClearColor(_clearColor.getR(), _clearColor.getG(), _clearColor.getB(), _clearColor.getA());
+        }
+        else
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        
+        if (!_depthWrite) glDepthMask(GL_FALSE);
+        
+        checkOpenGLErrors();
+    }
+    
+    void RendererOGL::clearDepth()
+    {
+        // glClear ignores the viewport, so the scissor rectangle limits it
+        Rectangle rectangle = _viewport;
+        
+        if (_scissorTest && !Rectangle::intersect(_viewport, _scissorRectangle, &rectangle))
+        {
+            return;
+        }
+        
+        if (!_scissorTest) glEnable(GL_SCISSOR_TEST);
+        glScissor(static_cast<GLint>(rectangle.x), static_cast<GLint>(rectangle.y),
+                  static_cast<GLsizei>(rectangle.width), static_cast<GLsizei>(rectangle.height));
+        
+        if (!_depthWrite) glDepthMask(GL_TRUE);
+        
+        glClear(GL_DEPTH_BUFFER_BIT);
+        
+        if (!_depthWrite) glDepthMask(GL_FALSE);
+        
+        if (_scissorTest)
+        {
+            glScissor(static_cast<GLint>(_scissorRectangle.x), static_cast<GLint>(_scissorRectangle.y),
+                      static_cast<GLsizei>(_scissorRectangle.width), static_cast<GLsizei>(_scissorRectangle.height));
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        
         checkOpenGLErrors();
     }
     
     void RendererOGL::flush()
     {
+        startCaptures();
+        
         glFlush();
         checkOpenGLErrors();
     }
     
+    // OpenGL stores the bottom row first
+    static void copyFlipped(const uint8_t* source, const Size2& size, std::vector<uint8_t>& pixels)
+    {
+        uint32_t width = static_cast<uint32_t>(size.width);
+        uint32_t height = static_cast<uint32_t>(size.height);
+        uint32_t pitch = width * 4;
+        
+        pixels.resize(pitch * height);
+        
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            memcpy(pixels.data() + row * pitch, source + (height - row - 1) * pitch, pitch);
+        }
+    }
+    
+    void RendererOGL::startCaptures()
+    {
+        if (_captureRequests.empty())
+        {
+            return;
+        }
+        
+        for (const CaptureRequest& request : _captureRequests)
+        {
+            PendingCapture capture;
+            capture.callback = request.callback;
+            capture.size = request.renderTarget ? request.renderTarget->getSize() : _size;
+            
+            GLsizei width = static_cast<GLsizei>(capture.size.width);
+            GLsizei height = static_cast<GLsizei>(capture.size.height);
+            
+            if (request.renderTarget)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, static_cast<RenderTargetOGL*>(request.renderTarget.item)->getFrameBufferId());
+            }
+            else
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferId);
+            }
+            
+#ifdef OUZEL_PLATFORM_IOS
+            // OpenGL ES 2 has no pixel buffer objects, so the pixels have to be read right away
+            capture.pixels.resize(static_cast<size_t>(width * height * 4));
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, capture.pixels.data());
+#else
+            if (_freePixelBuffers.empty())
+            {
+                glGenBuffers(1, &capture.pixelBufferId);
+            }
+            else
+            {
+                capture.pixelBufferId = _freePixelBuffers.back();
+                _freePixelBuffers.pop_back();
+            }
+            
+            // reading into a pixel buffer returns right away, the copy is done by the GPU
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pixelBufferId);
+            glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            
+            capture.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+            
+            if (checkOpenGLErrors())
+            {
+                log("Failed to capture frame");
+                
+#ifndef OUZEL_PLATFORM_IOS
+                glDeleteSync(capture.fence);
+                _freePixelBuffers.push_back(capture.pixelBufferId);
+#endif
+                
+                capture.callback(capture.size, std::vector<uint8_t>());
+                continue;
+            }
+            
+            _pendingCaptures.push_back(capture);
+        }
+        
+        _captureRequests.clear();
+        
+        glBindFramebuffer(GL_FRAMEBUFFER, getActiveFrameBufferId());
+    }
+    
+    void RendererOGL::finishCaptures()
+    {
+        std::vector<PendingCapture> finishedCaptures;
+        
+        for (std::vector<PendingCapture>::iterator i = _pendingCaptures.begin(); i != _pendingCaptures.end();)
+        {
+#ifndef OUZEL_PLATFORM_IOS
+            if (glClientWaitSync(i->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                ++i;
+                continue;
+            }
+#endif
+            
+            finishedCaptures.push_back(*i);
+            i = _pendingCaptures.erase(i);
+        }
+        
+        // callbacks can request new captures
+        for (PendingCapture& capture : finishedCaptures)
+        {
+            std::vector<uint8_t> pixels;
+            
+#ifdef OUZEL_PLATFORM_IOS
+            copyFlipped(capture.pixels.data(), capture.size, pixels);
+#else
+            glDeleteSync(capture.fence);
+            
+            GLsizeiptr size = static_cast<GLsizeiptr>(capture.size.width) * static_cast<GLsizeiptr>(capture.size.height) * 4;
+            
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pixelBufferId);
+            
+            const uint8_t* data = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+            
+            if (data)
+            {
+                copyFlipped(data, capture.size, pixels);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            else
+            {
+                log("Failed to map pixel buffer");
+            }
+            
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            
+            _freePixelBuffers.push_back(capture.pixelBufferId);
+#endif
+            
+            capture.callback(capture.size, pixels);
+        }
+    }
+    
     Texture* RendererOGL::loadTextureFromFile(const std::string& filename)
     {
         TextureOGL* texture = new TextureOGL(this);
@@ -130,6 +517,19 @@ namespace ouzel
         return texture;
     }
     
+    Texture* RendererOGL::loadTextureFromImage(Image* image)
+    {
+        TextureOGL* texture = new TextureOGL(this);
+        
+        if (!texture->initFromFile(image))
+        {
+            delete texture;
+            texture = nullptr;
+        }
+        
+        return texture;
+    }
+    
     bool RendererOGL::activateTexture(Texture* texture, uint32_t layer)
     {
         if (!Renderer::activateTexture(texture, layer))
@@ -209,11 +609,12 @@ namespace ouzel
         return true;
     }
     
-    MeshBuffer* RendererOGL::createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices)
+    MeshBuffer* RendererOGL::createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                              const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic)
     {
         MeshBufferOGL* meshBuffer = new MeshBufferOGL(this);
         
-        if (!meshBuffer->initFromData(indices, vertices))
+        if (!meshBuffer->initFromData(indices, indexSize, indexCount, vertices, vertexFormat, vertexCount, dynamic))
         {
             delete meshBuffer;
             meshBuffer = nullptr;
@@ -231,9 +632,12 @@ namespace ouzel
         
         MeshBufferOGL* meshBufferOGL = static_cast<MeshBufferOGL*>(meshBuffer);
         
-        glBindVertexArray(meshBufferOGL->getVertexArrayId());
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBufferOGL->getIndexBufferId());
-        glDrawElements(GL_TRIANGLES, meshBufferOGL->getIndexCount(), GL_UNSIGNED_SHORT, nullptr);
+        if (!meshBufferOGL->bindBuffers())
+        {
+            return false;
+        }
+        
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(meshBufferOGL->getIndexCount()), meshBufferOGL->getIndexFormat(), nullptr);
         
         if (checkOpenGLErrors())
         {
@@ -7,6 +7,7 @@
 #include "Renderer.h"
 
 #if defined(OUZEL_PLATFORM_OSX)
+#include <OpenGL/OpenGL.h>
 #include <OpenGL/gl3.h>
 #elif defined(OUZEL_PLATFORM_IOS)
 #import <OpenGLES/ES2/gl.h>
@@ -19,38 +20,99 @@
 #define glDeleteVertexArrays glDeleteVertexArraysOES
 #endif
 
+// asynchronous error reporting, Apple's OpenGL headers do not expose KHR_debug
+#if defined(OUZEL_DEBUG) && defined(GL_KHR_debug) && !defined(OUZEL_PLATFORM_IOS)
+#define OUZEL_OPENGL_DEBUG_OUTPUT
+#endif
+
 namespace ouzel
 {
     class RendererOGL: public Renderer
     {
     public:
         RendererOGL(const Size2& size, bool fullscreen, Engine* engine);
+        virtual ~RendererOGL();
         
         bool initOpenGL(uint32_t width, uint32_t height);
+        
+        // glGetError stalls the pipeline, so errors are only checked in debug builds
+#ifdef OUZEL_DEBUG
         bool checkOpenGLErrors();
+#else
+        bool checkOpenGLErrors() { return false; }
+#endif
         
+        // requested for Settings::partialRedraw and set by the view to what the context got,
+        // the OS X screen keeps its contents between frames only with a backing store, which is copied on every swap
+        void setBackingStore(bool backingStore) { _backingStore = backingStore; }
+        bool hasBackingStore() const { return _backingStore; }
+#ifdef OUZEL_PLATFORM_OSX
+        virtual bool canRedrawPartially() const override { return _backingStore; }
+#endif
+        
+        virtual void setVerticalSync(bool verticalSync) override;
         virtual void setClearColor(Color color) override;
         
         virtual void recalculateProjection() override;
         
+        virtual void setDrawDepth(float depth) override;
+        virtual void setDepthState(bool depthTest, bool depthWrite) override;
+        virtual void setBlendEnabled(bool blendEnabled) override;
+        
+        virtual RenderTarget* createRenderTarget(const Size2& size) override;
+        virtual bool activateRenderTarget(RenderTarget* renderTarget) override;
+        virtual void setViewport(const Rectangle& viewport) override;
+        virtual void setScissorTest(bool enabled, const Rectangle& rectangle = Rectangle()) override;
+        
+        // frame buffer of the active render target or the screen
+        GLuint getActiveFrameBufferId() const;
+        
         virtual void clear() override;
+        virtual void clearDepth() override;
         virtual void flush() override;
         
         virtual Texture* loadTextureFromFile(const std::string& filename) override;
+        virtual Texture* loadTextureFromImage(Image* image) override;
         virtual bool activateTexture(Texture* texture, uint32_t layer) override;
         
         virtual Shader* loadShaderFromFiles(const std::string& fragmentShader, const std::string& vertexShader) override;
         virtual Shader* loadShaderFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize) override;
         virtual bool activateShader(Shader* shader) override;
         
-        virtual MeshBuffer* createMeshBuffer(const std::vector<uint16_t>& indices, const std::vector<Vertex>& vertices) override;
+        using Renderer::createMeshBuffer;
+        virtual MeshBuffer* createMeshBuffer(const void* indices, uint32_t indexSize, uint32_t indexCount,
+                                             const void* vertices, const VertexFormat& vertexFormat, uint32_t vertexCount, bool dynamic = false) override;
         virtual bool drawMeshBuffer(MeshBuffer* meshBuffer) override;
         
         virtual void drawLine(const Vector2& start, const Vector2& finish, const Color& color, const Matrix4& transform = Matrix4()) override;
         virtual void drawRectangle(const Rectangle& rectangle, const Color& color, const Matrix4& transform = Matrix4()) override;
         virtual void drawQuad(const Rectangle& rectangle, const Color& color, const Matrix4& transform = Matrix4()) override;
         
+    protected:
+        virtual void startCaptures() override;
+        virtual void finishCaptures() override;
+        
     private:
+        struct PendingCapture
+        {
+            CaptureCallback callback;
+            Size2 size;
+#ifdef OUZEL_PLATFORM_IOS
+            std::vector<uint8_t> pixels;
+#else
+            GLuint pixelBufferId = 0;
+            GLsync fence = 0;
+#endif
+        };
+        
         bool _ready = false;
+        bool _debugOutput = false;
+        bool _backingStore = false;
+        GLuint _frameBufferId = 0;
+        
+        std::vector<PendingCapture> _pendingCaptures;
+#ifndef OUZEL_PLATFORM_IOS
+        std::vector<GLuint> _freePixelBuffers;
+#endif
     };
 }
@@ -2,9 +2,12 @@
 // This file is part of the Ouzel engine.
 
 #include <algorithm>
+#include <cmath>
 #include "Scene.h"
 #include "Engine.h"
 #include "Camera.h"
+#include "Renderer.h"
+#include "TextLabel.h"
 
 namespace ouzel
 {
@@ -21,7 +24,8 @@ namespace ouzel
     
     bool Scene::init()
     {
-        _camera = new Camera(this);
+        _cameras.push_back(new Camera(this));
+        _spriteAnimator = new SpriteAnimator();
         
         _rootNode = new Node(this);
         _rootNode->addToScene();
@@ -46,6 +50,18 @@ namespace ouzel
         
         if (i != _nodes.end())
         {
+            if (_partialRedrawEnabled)
+            {
+                if (node->_drawnBoundingBox.isEmpty())
+                {
+                    _redrawAll = true;
+                }
+                else
+                {
+                    _dirtyRectangles.push_back(node->_drawnBoundingBox);
+                }
+            }
+            
             _nodes.erase(i);
         }
     }
@@ -55,9 +71,54 @@ namespace ouzel
         _reorderNodes = true;
     }
     
+    Camera* Scene::getCamera() const
+    {
+        if (_cameras.empty())
+        {
+            return nullptr;
+        }
+        
+        return _cameras.front();
+    }
+    
     void Scene::setCamera(Camera* camera)
     {
-        _camera = camera;
+        if (camera)
+        {
+            std::vector<AutoPtr<Camera>>::iterator i = std::find(_cameras.begin(), _cameras.end(), camera);
+            
+            if (i != _cameras.end())
+            {
+                // keeps the order of the other cameras
+                std::rotate(_cameras.begin(), i, i + 1);
+            }
+            else
+            {
+                _cameras.insert(_cameras.begin(), camera);
+            }
+        }
+        else if (!_cameras.empty())
+        {
+            _cameras.erase(_cameras.begin());
+        }
+    }
+    
+    void Scene::addCamera(Camera* camera)
+    {
+        if (camera && std::find(_cameras.begin(), _cameras.end(), camera) == _cameras.end())
+        {
+            _cameras.push_back(camera);
+        }
+    }
+    
+    void Scene::removeCamera(Camera* camera)
+    {
+        std::vector<AutoPtr<Camera>>::iterator i = std::find(_cameras.begin(), _cameras.end(), camera);
+        
+        if (i != _cameras.end())
+        {
+            _cameras.erase(i);
+        }
     }
     
     Node* Scene::pickNode(const Vector2& position)
@@ -92,8 +153,60 @@ namespace ouzel
         return result;
     }
     
-    void Scene::drawAll()
-    {        
+    void Scene::setPartialRedrawEnabled(bool enabled)
+    {
+        _partialRedrawEnabled = enabled;
+        _redrawAll = true;
+        _dirtyRectangles.clear();
+        _previousRedrawRectangle = Rectangle();
+    }
+    
+    void Scene::addDirtyRectangle(const Rectangle& rectangle)
+    {
+        if (_partialRedrawEnabled)
+        {
+            _dirtyRectangles.push_back(rectangle);
+        }
+    }
+    
+    void Scene::update(float delta)
+    {
+        // the simulation works with the transformations of the current state
+        _rootNode->restoreTransform();
+        
+        for (const AutoPtr<Camera>& camera : _cameras)
+        {
+            if (!camera->isAddedToScene())
+            {
+                camera->restoreTransform();
+                camera->storePreviousState();
+            }
+        }
+        
+        for (const AutoPtr<Node>& node : _nodes)
+        {
+            node->storePreviousState();
+        }
+        
+        _spriteAnimator->update(delta);
+    }
+    
+    void Scene::interpolate(float alpha)
+    {
+        _rootNode->interpolate(alpha);
+        
+        // cameras are usually not part of the node tree
+        for (const AutoPtr<Camera>& camera : _cameras)
+        {
+            if (!camera->isAddedToScene())
+            {
+                camera->interpolate(alpha);
+            }
+        }
+    }
+    
+    bool Scene::prepareFrame()
+    {
         if (_reorderNodes)
         {
             std::sort(_nodes.begin(), _nodes.end(), [](Node* a, Node* b){
@@ -103,16 +216,413 @@ namespace ouzel
             _reorderNodes = false;
         }
         
-        // render only if there is an active camera
-        if (_camera)
+        // without cameras the screen is only cleared
+        if (_cameras.empty())
+        {
+            return true;
+        }
+        
+        updateWorldBoundingBoxes();
+        
+        // the size of the screen or render targets might have changed since the last frame
+        for (const AutoPtr<Camera>& camera : _cameras)
+        {
+            camera->recalculateViewProjection();
+        }
+        
+        Renderer* renderer = _engine->getRenderer();
+        
+        _partialRedraw = _partialRedrawEnabled && renderer->canRedrawPartially();
+        
+        if (!_partialRedraw)
+        {
+            return true;
+        }
+        
+        if (!updateRedrawRectangle())
+        {
+            return false;
+        }
+        
+        renderer->setScissorTest(true, _redrawRectangle);
+        
+        return true;
+    }
+    
+    void Scene::drawAll()
+    {
+        if (_cameras.empty())
+        {
+            return;
+        }
+        
+        Renderer* renderer = _engine->getRenderer();
+        
+        // the screen is cleared by the engine, every render target is cleared before the first camera that draws to it,
+        // the later cameras clear only the depth in their viewport, so that the earlier passes don't hide their nodes
+        std::vector<RenderTarget*> drawnRenderTargets;
+        
+        for (const AutoPtr<Camera>& camera : _cameras)
         {
-            for (AutoPtr<Node> node : _nodes)
+            RenderTarget* renderTarget = camera->getRenderTarget();
+            
+            renderer->activateRenderTarget(renderTarget);
+            
+            // render targets are always redrawn completely
+            if (_partialRedraw)
             {
-                if (node->checkVisibility())
+                renderer->setScissorTest(!renderTarget, _redrawRectangle);
+            }
+            
+            if (std::find(drawnRenderTargets.begin(), drawnRenderTargets.end(), renderTarget) != drawnRenderTargets.end())
+            {
+                renderer->setViewport(camera->getRenderViewport());
+                renderer->clearDepth();
+            }
+            else
+            {
+                if (renderTarget)
                 {
-                    node->draw();
+                    renderer->clear();
                 }
+                
+                drawnRenderTargets.push_back(renderTarget);
             }
+            
+            drawCamera(camera);
         }
+        
+        renderer->activateRenderTarget(nullptr);
+        renderer->setViewport(Rectangle(0.0f, 0.0f, renderer->getSize().width, renderer->getSize().height));
+        
+        if (_partialRedraw)
+        {
+            renderer->setScissorTest(false);
+        }
+    }
+    
+    bool Scene::updateRedrawRectangle()
+    {
+        const Size2& screenSize = _engine->getRenderer()->getSize();
+        
+        if (screenSize.width != _screenSize.width || screenSize.height != _screenSize.height)
+        {
+            _screenSize = screenSize;
+            _redrawAll = true;
+        }
+        
+        for (uint32_t i = 0; i < _nodes.size(); ++i)
+        {
+            Node* node = _nodes[i];
+            
+            if (node->_dirty)
+            {
+                // the area covered by nodes without a bounding box is unknown
+                if (_worldBoundingBoxes[i].isEmpty())
+                {
+                    _redrawAll = true;
+                }
+                else
+                {
+                    _dirtyRectangles.push_back(_worldBoundingBoxes[i]);
+                    
+                    if (!node->_drawnBoundingBox.isEmpty())
+                    {
+                        _dirtyRectangles.push_back(node->_drawnBoundingBox);
+                    }
+                }
+                
+                node->_dirty = false;
+            }
+            
+            node->_drawnBoundingBox = _worldBoundingBoxes[i];
+        }
+        
+        for (const AutoPtr<Camera>& camera : _cameras)
+        {
+            if (camera->_dirty)
+            {
+                _redrawAll = true;
+                camera->_dirty = false;
+            }
+            
+            // contents of render targets can be shown anywhere on the screen
+            if (camera->getRenderTarget() && !_dirtyRectangles.empty())
+            {
+                _redrawAll = true;
+            }
+        }
+        
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+        
+        if (_redrawAll)
+        {
+            minX = 0.0f;
+            minY = 0.0f;
+            maxX = _screenSize.width;
+            maxY = _screenSize.height;
+        }
+        else
+        {
+            for (const AutoPtr<Camera>& camera : _cameras)
+            {
+                if (camera->getRenderTarget())
+                {
+                    continue;
+                }
+                
+                Rectangle viewport = camera->getRenderViewport();
+                const Matrix4& viewProjection = camera->getViewProjection();
+                
+                for (const Rectangle& rectangle : _dirtyRectangles)
+                {
+                    if (!rectangle.intersects(camera->getVisibleRectangle()))
+                    {
+                        continue;
+                    }
+                    
+                    Vector3 corners[4] = {
+                        Vector3(rectangle.x, rectangle.y, 0.0f),
+                        Vector3(rectangle.x + rectangle.width, rectangle.y, 0.0f),
+                        Vector3(rectangle.x, rectangle.y + rectangle.height, 0.0f),
+                        Vector3(rectangle.x + rectangle.width, rectangle.y + rectangle.height, 0.0f)
+                    };
+                    
+                    for (Vector3& corner : corners)
+                    {
+                        viewProjection.transformPoint(&corner);
+                        
+                        float x = std::max(0.0f, std::min(1.0f, (corner.x + 1.0f) / 2.0f));
+                        float y = std::max(0.0f, std::min(1.0f, (corner.y + 1.0f) / 2.0f));
+                        
+                        x = viewport.x + x * viewport.width;
+                        y = viewport.y + y * viewport.height;
+                        
+                        minX = std::min(minX, x);
+                        minY = std::min(minY, y);
+                        maxX = std::max(maxX, x);
+                        maxY = std::max(maxY, y);
+                    }
+                }
+            }
+        }
+        
+        _dirtyRectangles.clear();
+        _redrawAll = false;
+        
+        // nothing changed, the previous frame is still on the screen
+        if (minX >= maxX || minY >= maxY)
+        {
+            return false;
+        }
+        
+        // one extra pixel for the filtering of the edges
+        minX = std::max(0.0f, floorf(minX) - 1.0f);
+        minY = std::max(0.0f, floorf(minY) - 1.0f);
+        maxX = std::min(_screenSize.width, ceilf(maxX) + 1.0f);
+        maxY = std::min(_screenSize.height, ceilf(maxY) + 1.0f);
+        
+        Rectangle currentRectangle(minX, minY, maxX - minX, maxY - minY);
+        
+        // the back buffer was last drawn two frames ago, so it lacks the changes of the previous frame too
+        if (_previousRedrawRectangle.width > 0.0f && _previousRedrawRectangle.height > 0.0f)
+        {
+            Rectangle::combine(currentRectangle, _previousRedrawRectangle, &_redrawRectangle);
+        }
+        else
+        {
+            _redrawRectangle = currentRectangle;
+        }
+        
+        _previousRedrawRectangle = currentRectangle;
+        
+        return true;
+    }
+    
+    Rectangle Scene::getRedrawWorldRectangle(Camera* camera) const
+    {
+        Rectangle viewport = camera->getRenderViewport();
+        
+        Matrix4 inverseViewProjection = camera->getViewProjection();
+        inverseViewProjection.invert();
+        
+        float left = (_redrawRectangle.x - viewport.x) / viewport.width * 2.0f - 1.0f;
+        float right = (_redrawRectangle.x + _redrawRectangle.width - viewport.x) / viewport.width * 2.0f - 1.0f;
+        float bottom = (_redrawRectangle.y - viewport.y) / viewport.height * 2.0f - 1.0f;
+        float top = (_redrawRectangle.y + _redrawRectangle.height - viewport.y) / viewport.height * 2.0f - 1.0f;
+        
+        Vector3 corners[4] = {
+            Vector3(left, bottom, 0.0f),
+            Vector3(right, bottom, 0.0f),
+            Vector3(left, top, 0.0f),
+            Vector3(right, top, 0.0f)
+        };
+        
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+        
+        for (Vector3& corner : corners)
+        {
+            inverseViewProjection.transformPoint(&corner);
+            
+            minX = std::min(minX, corner.x);
+            minY = std::min(minY, corner.y);
+            maxX = std::max(maxX, corner.x);
+            maxY = std::max(maxY, corner.y);
+        }
+        
+        return Rectangle(minX, minY, maxX - minX, maxY - minY);
+    }
+    
+    void Scene::updateWorldBoundingBoxes()
+    {
+        _worldBoundingBoxes.resize(_nodes.size());
+        
+        for (uint32_t i = 0; i < _nodes.size(); ++i)
+        {
+            const Rectangle& boundingBox = _nodes[i]->getBoundingBox();
+            
+            _worldBoundingBoxes[i] = boundingBox.isEmpty() ? Rectangle() : _nodes[i]->getWorldRectangle(boundingBox);
+        }
+    }
+    
+    void Scene::drawCamera(Camera* camera)
+    {
+        Renderer* renderer = _engine->getRenderer();
+        
+        renderer->setViewport(camera->getRenderViewport());
+        
+        Rectangle visibleRectangle = camera->getVisibleRectangle();
+        bool visible = true;
+        
+        // nodes outside of the scissor rectangle would not change any pixels
+        if (_partialRedraw && !camera->getRenderTarget())
+        {
+            visible = Rectangle::intersect(visibleRectangle, getRedrawWorldRectangle(camera), &visibleRectangle);
+        }
+        
+        _opaqueNodes.clear();
+        _translucentNodes.clear();
+        
+        for (uint32_t i = 0; i < _nodes.size(); ++i)
+        {
+            Node* node = _nodes[i];
+            
+            if (!(node->getLayers() & camera->getLayerMask()))
+            {
+                continue;
+            }
+            
+            // nodes without a bounding box are always drawn
+            if (!_worldBoundingBoxes[i].isEmpty() && (!visible || !_worldBoundingBoxes[i].intersects(visibleRectangle)))
+            {
+                continue;
+            }
+            
+            if (node->isOpaque())
+            {
+                _opaqueNodes.push_back(i);
+            }
+            else
+            {
+                _translucentNodes.push_back(i);
+            }
+        }
+        
+        // every node gets its own depth from its position in the z order, the last one is the nearest
+        float depthStep = 1.0f / static_cast<float>(_nodes.size() + 1);
+        
+        // opaque nodes front to back, so that the hidden fragments are rejected by the depth test before shading
+        renderer->setBlendEnabled(false);
+        renderer->setDepthState(true, true);
+        
+        for (std::vector<uint32_t>::const_reverse_iterator i = _opaqueNodes.rbegin(); i != _opaqueNodes.rend(); ++i)
+        {
+            renderer->setDrawDepth(1.0f - (*i + 1) * depthStep);
+            _nodes[*i]->draw(camera);
+        }
+        
+        // translucent nodes back to front, tested against the opaque ones but not written
+        renderer->setBlendEnabled(true);
+        renderer->setDepthState(true, false);
+        
+        for (uint32_t i : _translucentNodes)
+        {
+            Node* node = _nodes[i];
+            
+            if (node->isTextLabel())
+            {
+                TextLabel* label = static_cast<TextLabel*>(node);
+                
+                if (_textBatchLabel)
+                {
+                    // the opaque nodes are already drawn, one between the labels would be tested against the wrong depth
+                    std::vector<uint32_t>::const_iterator opaqueNode = std::upper_bound(_opaqueNodes.begin(), _opaqueNodes.end(), _textBatchEnd);
+                    
+                    if (!label->canBatchWith(_textBatchLabel) || (opaqueNode != _opaqueNodes.end() && *opaqueNode < i))
+                    {
+                        flushTextBatch(camera, 1.0f - (_textBatchEnd + 1) * depthStep);
+                    }
+                }
+                
+                if (label->addToBatch(_textBatchIndices, _textBatchVertices))
+                {
+                    if (!_textBatchLabel)
+                    {
+                        _textBatchLabel = label;
+                    }
+                    
+                    _textBatchEnd = i;
+                }
+                
+                continue;
+            }
+            
+            if (_textBatchLabel)
+            {
+                flushTextBatch(camera, 1.0f - (_textBatchEnd + 1) * depthStep);
+            }
+            
+            renderer->setDrawDepth(1.0f - (i + 1) * depthStep);
+            node->draw(camera);
+        }
+        
+        if (_textBatchLabel)
+        {
+            flushTextBatch(camera, 1.0f - (_textBatchEnd + 1) * depthStep);
+        }
+        
+        renderer->setDepthState(false, false);
+    }
+    
+    void Scene::flushTextBatch(Camera* camera, float depth)
+    {
+        // one mesh buffer is refilled for every batch, the renderer orphans its storage when it is rewritten
+        if (_textBatchMeshBuffer)
+        {
+            if (!_textBatchMeshBuffer->setIndices(_textBatchIndices) || !_textBatchMeshBuffer->setVertices(_textBatchVertices))
+            {
+                _textBatchMeshBuffer = nullptr;
+            }
+        }
+        else
+        {
+            _textBatchMeshBuffer = _engine->getRenderer()->createMeshBuffer(_textBatchIndices, _textBatchVertices, true);
+        }
+        
+        if (_textBatchMeshBuffer)
+        {
+            _engine->getRenderer()->setDrawDepth(depth);
+            _textBatchLabel->drawBatch(camera, _textBatchMeshBuffer);
+        }
+        
+        _textBatchLabel = nullptr;
+        _textBatchIndices.clear();
+        _textBatchVertices.clear();
     }
 }
@@ -10,12 +10,17 @@
 #include "ReferenceCounted.h"
 #include "Vector2.h"
 #include "Rectangle.h"
+#include "Size2.h"
+#include "Vertex.h"
+#include "MeshBuffer.h"
+#include "SpriteAnimator.h"
 
 namespace ouzel
 {
     class Engine;
     class Camera;
     class Node;
+    class TextLabel;
     
     class Scene: public Noncopyable, public ReferenceCounted
     {
@@ -33,20 +38,79 @@ namespace ouzel
         
         Node* getRootNode() const { return _rootNode; }
         
-        Camera* getCamera() const { return _camera; }
+        // the main camera, used for converting input coordinates and rendered first,
+        // setting a camera that is not in the scene yet keeps the previous main camera as the second one
+        Camera* getCamera() const;
         void setCamera(Camera* camera);
+        
+        // cameras are rendered in the order they were added
+        void addCamera(Camera* camera);
+        void removeCamera(Camera* camera);
+        const std::vector<AutoPtr<Camera>>& getCameras() const { return _cameras; }
 
         Node* pickNode(const Vector2& position);
         std::set<Node*> pickNodes(const Rectangle& rectangle);
         
+        SpriteAnimator* getSpriteAnimator() const { return _spriteAnimator; }
+        
+        // only the areas covered by changed nodes are redrawn and frames without changes are skipped
+        void setPartialRedrawEnabled(bool enabled);
+        bool isPartialRedrawEnabled() const { return _partialRedrawEnabled; }
+        
+        // in world coordinates
+        void addDirtyRectangle(const Rectangle& rectangle);
+        // for changes the scene can not track, e.g. the clear color
+        void redrawAll() { _redrawAll = true; }
+        
+        // one simulation step, the current state of the nodes becomes the previous one
+        void update(float delta);
+        
+        // draws the nodes between their previous and current state, alpha is the fraction of the step since the current state
+        void interpolate(float alpha);
+        
+        // returns false if nothing has to be drawn
+        bool prepareFrame();
         void drawAll();
         
     protected:
+        void updateWorldBoundingBoxes();
+        bool updateRedrawRectangle();
+        Rectangle getRedrawWorldRectangle(Camera* camera) const;
+        void drawCamera(Camera* camera);
+        void flushTextBatch(Camera* camera, float depth);
+        
         Engine* _engine;
         
+        // declared before the nodes, so that it outlives them
+        AutoPtr<SpriteAnimator> _spriteAnimator;
+        
         AutoPtr<Node> _rootNode;
-        AutoPtr<Camera> _camera;
+        std::vector<AutoPtr<Camera>> _cameras;
         std::vector<AutoPtr<Node>> _nodes;
         bool _reorderNodes = false;
+        
+        // world space bounding boxes of the nodes, computed once per frame and shared by all cameras
+        std::vector<Rectangle> _worldBoundingBoxes;
+        
+        bool _partialRedrawEnabled = false;
+        bool _redrawAll = true;
+        std::vector<Rectangle> _dirtyRectangles;
+        Size2 _screenSize;
+        // in screen pixels, the back buffer contains the frame before the previous one after swapping
+        bool _partialRedraw = false;
+        Rectangle _redrawRectangle;
+        Rectangle _previousRedrawRectangle;
+        
+        // indices of the visible nodes, kept between frames to avoid reallocating
+        std::vector<uint32_t> _opaqueNodes;
+        std::vector<uint32_t> _translucentNodes;
+        
+        // text labels with the same font page and no other node between them in the z order,
+        // drawn with the font page and shader of the first one at the depth of the last one
+        TextLabel* _textBatchLabel = nullptr;
+        uint32_t _textBatchEnd = 0;
+        std::vector<uint32_t> _textBatchIndices;
+        std::vector<Vertex> _textBatchVertices;
+        AutoPtr<MeshBuffer> _textBatchMeshBuffer;
     };
 }
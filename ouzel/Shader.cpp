@@ -1,7 +1,7 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
-#include <fstream>
+#include <vector>
 #include "Shader.h"
 #include "Engine.h"
 #include "Renderer.h"
@@ -18,6 +18,10 @@ namespace ouzel
 
     Shader::~Shader()
     {
+        FileSystem* fileSystem = _renderer->getEngine()->getFileSystem();
+        fileSystem->unwatchFile(_fragmentShaderWatchId);
+        fileSystem->unwatchFile(_vertexShaderWatchId);
+        
         if (_renderer->getActiveShader() == this)
         {
             _renderer->activateShader(nullptr);
@@ -29,42 +33,65 @@ namespace ouzel
         _fragmentShaderFilename = fragmentShader;
         _vertexShaderFilename = vertexShader;
         
-        std::ifstream fragmentShaderFile(_renderer->getEngine()->getFileSystem()->getPath(fragmentShader));
+        FileSystem* fileSystem = _renderer->getEngine()->getFileSystem();
+        
+        std::vector<uint8_t> fragmentShaderBuffer;
         
-        if (!fragmentShaderFile)
+        if (!fileSystem->readFile(fragmentShader, fragmentShaderBuffer))
         {
             log("Failed to open fragment shader file %s", fragmentShader.c_str());
             return false;
         }
         
-        fragmentShaderFile.seekg(0, std::ios::end);
-        size_t fragmentShaderSize = static_cast<size_t>(fragmentShaderFile.tellg());
-        fragmentShaderFile.seekg(0, std::ios::beg);
+        std::vector<uint8_t> vertexShaderBuffer;
         
-        std::vector<char> fragmentShaderBuffer(fragmentShaderSize);
+        if (!fileSystem->readFile(vertexShader, vertexShaderBuffer))
+        {
+            log("Failed to open vertex shader file %s", vertexShader.c_str());
+            return false;
+        }
         
-        fragmentShaderFile.read(fragmentShaderBuffer.data(), fragmentShaderSize);
+        if (!initFromBuffers(fragmentShaderBuffer.data(), static_cast<uint32_t>(fragmentShaderBuffer.size()),
+                             vertexShaderBuffer.data(), static_cast<uint32_t>(vertexShaderBuffer.size())))
+        {
+            return false;
+        }
         
-        std::ifstream vertexShaderFile(_renderer->getEngine()->getFileSystem()->getPath(vertexShader));
+        if (!_fragmentShaderWatchId)
+        {
+            _fragmentShaderWatchId = fileSystem->watchFile(fragmentShader, [this]() { reload(); });
+        }
         
-        if (!vertexShaderFile)
+        if (!_vertexShaderWatchId)
         {
-            log("Failed to open vertex shader file %s", fragmentShader.c_str());
-            return false;
+            _vertexShaderWatchId = fileSystem->watchFile(vertexShader, [this]() { reload(); });
         }
         
-        std::string vertexShaderCode;
+        return true;
+    }
+    
+    bool Shader::reload()
+    {
+        if (_fragmentShaderFilename.empty() || _vertexShaderFilename.empty())
+        {
+            return false;
+        }
         
-        vertexShaderFile.seekg(0, std::ios::end);
-        size_t vertexShaderSize = static_cast<size_t>(vertexShaderFile.tellg());
-        vertexShaderFile.seekg(0, std::ios::beg);
+        if (!initFromFiles(_fragmentShaderFilename, _vertexShaderFilename))
+        {
+            return false;
+        }
         
-        std::vector<char> vertexShaderBuffer(vertexShaderSize);
+        // the renderer has to bind the new program
+        if (_renderer->getActiveShader() == this)
+        {
+            _renderer->activateShader(nullptr);
+            _renderer->activateShader(this);
+        }
         
-        vertexShaderFile.read(vertexShaderBuffer.data(), vertexShaderSize);
+        log("Reloaded shader %s %s", _fragmentShaderFilename.c_str(), _vertexShaderFilename.c_str());
         
-        return initFromBuffers(reinterpret_cast<const uint8_t*>(fragmentShaderBuffer.data()), static_cast<int32_t>(fragmentShaderSize),
-                               reinterpret_cast<const uint8_t*>(vertexShaderBuffer.data()), static_cast<int32_t>(vertexShaderSize));
+        return true;
     }
     
     bool Shader::initFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize)
@@ -109,6 +136,11 @@ namespace ouzel
     
     bool Shader::setVertexShaderConstant(uint32_t index, const Matrix4* matrices, uint32_t count)
     {
+        if (count > 0)
+        {
+            _vertexTransform = matrices[0];
+        }
+        
         return true;
     }
 }
@@ -23,6 +23,9 @@ namespace ouzel
         virtual bool initFromFiles(const std::string& fragmentShader, const std::string& vertexShader);
         virtual bool initFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize);
         
+        // compiles the files again, the current program stays if they fail to compile
+        virtual bool reload();
+        
         virtual uint32_t getPixelShaderConstantId(const std::string& name);
         virtual bool setPixelShaderConstant(uint32_t index, const Vector3* vectors, uint32_t count);
         virtual bool setPixelShaderConstant(uint32_t index, const Vector4* vectors, uint32_t count);
@@ -33,9 +36,17 @@ namespace ouzel
         virtual bool setVertexShaderConstant(uint32_t index, const Vector4* vectors, uint32_t count);
         virtual bool setVertexShaderConstant(uint32_t index, const Matrix4* matrices, uint32_t count);
         
+        // last matrix passed to the software shader, used for measuring overdraw
+        const Matrix4& getVertexTransform() const { return _vertexTransform; }
+        
     protected:
         std::string _fragmentShaderFilename;
         std::string _vertexShaderFilename;
         Renderer* _renderer;
+        
+        uint32_t _fragmentShaderWatchId = 0;
+        uint32_t _vertexShaderWatchId = 0;
+        
+        Matrix4 _vertexTransform;
     };
 }
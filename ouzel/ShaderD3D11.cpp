@@ -10,12 +10,40 @@
 
 namespace ouzel
 {
-    const D3D11_INPUT_ELEMENT_DESC VERTEX_INPUT_ELEMENTS[] =
+    static const char* getSemanticName(VertexUsage usage)
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-    };
+        switch (usage)
+        {
+            case VertexUsage::POSITION: return "POSITION";
+            case VertexUsage::COLOR: return "COLOR";
+            case VertexUsage::TEXCOORD: return "TEXCOORD";
+        }
+
+        return nullptr;
+    }
+
+    static DXGI_FORMAT getAttributeFormat(const VertexAttribute& attribute)
+    {
+        static const DXGI_FORMAT FLOAT_FORMATS[] = { DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT };
+        static const DXGI_FORMAT BYTE_FORMATS[] = { DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_R8G8_UNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R8G8B8A8_UNORM };
+        static const DXGI_FORMAT SHORT_FORMATS[] = { DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_UNORM };
+
+        if (attribute.components < 1 || attribute.components > 4)
+        {
+            return DXGI_FORMAT_UNKNOWN;
+        }
+
+        switch (attribute.type)
+        {
+            case VertexAttributeType::FLOAT: return FLOAT_FORMATS[attribute.components - 1];
+            case VertexAttributeType::UNSIGNED_BYTE_NORM: return BYTE_FORMATS[attribute.components - 1];
+            case VertexAttributeType::UNSIGNED_SHORT_NORM: return SHORT_FORMATS[attribute.components - 1];
+            // the input assembler can not convert integers to floats without normalizing them
+            case VertexAttributeType::SHORT: return DXGI_FORMAT_UNKNOWN;
+        }
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
 
     ShaderD3D11::ShaderD3D11(Renderer* renderer):
         Shader(renderer)
@@ -24,13 +52,25 @@ namespace ouzel
 
     ShaderD3D11::~ShaderD3D11()
     {
-        if (_pixelShader) _pixelShader->Release();
-        if (_vertexShader) _vertexShader->Release();
-        if (_inputLayout) _inputLayout->Release();
+        releaseShaders();
 
         if (_pixelShaderConstantBuffer) _pixelShaderConstantBuffer->Release();
         if (_vertexShaderConstantBuffer) _vertexShaderConstantBuffer->Release();
     }
+
+    void ShaderD3D11::releaseShaders()
+    {
+        if (_pixelShader) _pixelShader->Release();
+        if (_vertexShader) _vertexShader->Release();
+        for (const std::pair<VertexFormat, ID3D11InputLayout*>& inputLayout : _inputLayouts)
+        {
+            if (inputLayout.second) inputLayout.second->Release();
+        }
+
+        _pixelShader = nullptr;
+        _vertexShader = nullptr;
+        _inputLayouts.clear();
+    }
     
     bool ShaderD3D11::initFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize)
     {
@@ -41,32 +81,56 @@ namespace ouzel
 
         RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
 
-        HRESULT hr = rendererD3D11->getDevice()->CreatePixelShader(fragmentShader, fragmentShaderSize, NULL, &_pixelShader);
-        if (FAILED(hr) || !_pixelShader)
+        // the previous shaders stay in use until the new ones are created
+        ID3D11PixelShader* pixelShader = nullptr;
+        HRESULT hr = rendererD3D11->getDevice()->CreatePixelShader(fragmentShader, fragmentShaderSize, NULL, &pixelShader);
+        if (FAILED(hr) || !pixelShader)
         {
             log("Failed to create a D3D11 pixel shader");
             return false;
         }
 
-        hr = rendererD3D11->getDevice()->CreateVertexShader(vertexShader, vertexShaderSize, NULL, &_vertexShader);
-        if (FAILED(hr) || !_vertexShader)
+        ID3D11VertexShader* newVertexShader = nullptr;
+        hr = rendererD3D11->getDevice()->CreateVertexShader(vertexShader, vertexShaderSize, NULL, &newVertexShader);
+        if (FAILED(hr) || !newVertexShader)
         {
             log("Failed to create a D3D11 vertex shader");
+            pixelShader->Release();
             return false;
         }
 
-        hr = rendererD3D11->getDevice()->CreateInputLayout(
-            VERTEX_INPUT_ELEMENTS,
-            static_cast<UINT>(sizeof(VERTEX_INPUT_ELEMENTS) / sizeof(D3D11_INPUT_ELEMENT_DESC)),
-            vertexShader,
-            vertexShaderSize,
-            &_inputLayout);
+        std::vector<uint8_t> previousVertexShaderData;
+        previousVertexShaderData.swap(_vertexShaderData);
+        std::vector<std::pair<VertexFormat, ID3D11InputLayout*>> previousInputLayouts;
+        previousInputLayouts.swap(_inputLayouts);
+
+        _vertexShaderData.assign(vertexShader, vertexShader + vertexShaderSize);
 
-        if (FAILED(hr) || !_inputLayout)
+        // validates the shader against the layout of Vertex
+        if (!getInputLayout(VertexFormat::getDefault()))
         {
-            log("Failed to create D3D11 input layout for vertex shader");
+            pixelShader->Release();
+            newVertexShader->Release();
+            _vertexShaderData.swap(previousVertexShaderData);
+            _inputLayouts.swap(previousInputLayouts);
             return false;
         }
+
+        std::vector<std::pair<VertexFormat, ID3D11InputLayout*>> inputLayouts;
+        inputLayouts.swap(_inputLayouts);
+        _inputLayouts.swap(previousInputLayouts);
+
+        releaseShaders();
+
+        _pixelShader = pixelShader;
+        _vertexShader = newVertexShader;
+        _inputLayouts.swap(inputLayouts);
+
+        // constant buffers don't depend on the shader code, so they are kept on reload
+        if (_pixelShaderConstantBuffer && _vertexShaderConstantBuffer)
+        {
+            return true;
+        }
         
         D3D11_BUFFER_DESC pixelShaderConstantBufferDesc;
         memset(&pixelShaderConstantBufferDesc, 0, sizeof(pixelShaderConstantBufferDesc));
@@ -101,6 +165,64 @@ namespace ouzel
         return true;
     }
 	
+    ID3D11InputLayout* ShaderD3D11::getInputLayout(const VertexFormat& vertexFormat)
+    {
+        for (const std::pair<VertexFormat, ID3D11InputLayout*>& inputLayout : _inputLayouts)
+        {
+            if (inputLayout.first == vertexFormat)
+            {
+                return inputLayout.second;
+            }
+        }
+
+        std::vector<D3D11_INPUT_ELEMENT_DESC> inputElements;
+
+        for (const VertexAttribute& attribute : vertexFormat.getAttributes())
+        {
+            DXGI_FORMAT format = getAttributeFormat(attribute);
+
+            if (format == DXGI_FORMAT_UNKNOWN)
+            {
+                log("Vertex attribute format is not supported by D3D11");
+                return nullptr;
+            }
+
+            inputElements.push_back({ getSemanticName(attribute.usage), 0, format, 0, attribute.offset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        }
+
+        // missing attributes are read from the renderer's default attribute buffer, which is bound as the first instance
+        if (!vertexFormat.getAttribute(VertexUsage::COLOR))
+        {
+            inputElements.push_back({ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 });
+        }
+
+        if (!vertexFormat.getAttribute(VertexUsage::TEXCOORD))
+        {
+            inputElements.push_back({ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 1, 4, D3D11_INPUT_PER_INSTANCE_DATA, 1 });
+        }
+
+        RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
+
+        ID3D11InputLayout* inputLayout = nullptr;
+
+        HRESULT hr = rendererD3D11->getDevice()->CreateInputLayout(
+            inputElements.data(),
+            static_cast<UINT>(inputElements.size()),
+            _vertexShaderData.data(),
+            _vertexShaderData.size(),
+            &inputLayout);
+
+        if (FAILED(hr) || !inputLayout)
+        {
+            log("Failed to create D3D11 input layout for vertex shader");
+            return nullptr;
+        }
+
+        _inputLayouts.push_back(std::make_pair(vertexFormat, inputLayout));
+
+        return inputLayout;
+    }
+
     uint32_t ShaderD3D11::getPixelShaderConstantId(const std::string& name)
     {
         log("getPixelShaderConstantId not available for D3D11");
@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include <vector>
+#include <utility>
 #include <d3d11.h>
 #include "CompileConfig.h"
 #include "Shader.h"
+#include "VertexFormat.h"
 
 namespace ouzel
 {
@@ -22,7 +25,8 @@ namespace ouzel
 
         virtual ID3D11Buffer* getPixelShaderConstantBuffer() const { return _pixelShaderConstantBuffer; }
         virtual ID3D11Buffer* getVertexShaderConstantBuffer() const { return _vertexShaderConstantBuffer; }
-        virtual ID3D11InputLayout* getInputLayout() const { return _inputLayout;  }
+        // input layouts are created on first use and cached per vertex format
+        virtual ID3D11InputLayout* getInputLayout(const VertexFormat& vertexFormat);
 
         virtual uint32_t getPixelShaderConstantId(const std::string& name) override;
         virtual bool setPixelShaderConstant(uint32_t index, const Vector3* vectors, uint32_t count);
@@ -35,11 +39,13 @@ namespace ouzel
         virtual bool setVertexShaderConstant(uint32_t index, const Matrix4* matrices, uint32_t count);
         
     protected:
+        void releaseShaders();
         virtual bool uploadData(ID3D11Buffer* buffer, const void* data, uint32_t size);
 
         ID3D11PixelShader* _pixelShader = nullptr;
         ID3D11VertexShader* _vertexShader = nullptr;
-        ID3D11InputLayout* _inputLayout = nullptr;
+        std::vector<uint8_t> _vertexShaderData;
+        std::vector<std::pair<VertexFormat, ID3D11InputLayout*>> _inputLayouts;
 
         ID3D11Buffer* _pixelShaderConstantBuffer = nullptr;
         ID3D11Buffer* _vertexShaderConstantBuffer = nullptr;
@@ -16,7 +16,9 @@ namespace ouzel
 
     ShaderOGL::~ShaderOGL()
     {
-        
+        if (_programId) glDeleteProgram(_programId);
+        if (_vertexShader) glDeleteShader(_vertexShader);
+        if (_fragmentShader) glDeleteShader(_fragmentShader);
     }
     
     bool ShaderOGL::initFromBuffers(const uint8_t* fragmentShader, uint32_t fragmentShaderSize, const uint8_t* vertexShader, uint32_t vertexShaderSize)
@@ -40,38 +42,86 @@ namespace ouzel
             return false;
         }
         
-        _fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(_fragmentShader, 1, reinterpret_cast<const GLchar* const*>(&fragmentShader), reinterpret_cast<const GLint*>(&fragmentShaderSize));
-        glCompileShader(_fragmentShader);
+        // the previous program stays in use until the new one is compiled and linked
+        GLuint newFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(newFragmentShader, 1, reinterpret_cast<const GLchar* const*>(&fragmentShader), reinterpret_cast<const GLint*>(&fragmentShaderSize));
+        glCompileShader(newFragmentShader);
         
-        if (checkShaderError(_fragmentShader))
+        if (checkShaderError(newFragmentShader))
         {
+            glDeleteShader(newFragmentShader);
             return false;
         }
         
-        _vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(_vertexShader, 1, reinterpret_cast<const GLchar* const*>(&vertexShader), reinterpret_cast<const GLint*>(&vertexShaderSize));
-        glCompileShader(_vertexShader);
+        GLuint newVertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(newVertexShader, 1, reinterpret_cast<const GLchar* const*>(&vertexShader), reinterpret_cast<const GLint*>(&vertexShaderSize));
+        glCompileShader(newVertexShader);
         
-        if (checkShaderError(_vertexShader))
+        if (checkShaderError(newVertexShader))
         {
+            glDeleteShader(newFragmentShader);
+            glDeleteShader(newVertexShader);
             return false;
         }
         
-        _programId = glCreateProgram();
-        glAttachShader(_programId, _vertexShader);
-        glAttachShader(_programId, _fragmentShader);
-        glLinkProgram(_programId);
+        GLuint newProgramId = glCreateProgram();
+        glAttachShader(newProgramId, newVertexShader);
+        glAttachShader(newProgramId, newFragmentShader);
+        glLinkProgram(newProgramId);
+        
+        GLint linked;
+        glGetProgramiv(newProgramId, GL_LINK_STATUS, &linked);
         
-        glUseProgram(_programId);
+        if (linked == GL_FALSE)
+        {
+            log("Failed to link shader program");
+            glDeleteProgram(newProgramId);
+            glDeleteShader(newFragmentShader);
+            glDeleteShader(newVertexShader);
+            return false;
+        }
+        
+        glUseProgram(newProgramId);
         
         if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
         {
+            glDeleteProgram(newProgramId);
+            glDeleteShader(newFragmentShader);
+            glDeleteShader(newVertexShader);
             return false;
         }
         
+        if (_programId) glDeleteProgram(_programId);
+        if (_vertexShader) glDeleteShader(_vertexShader);
+        if (_fragmentShader) glDeleteShader(_fragmentShader);
+        
+        _programId = newProgramId;
+        _vertexShader = newVertexShader;
+        _fragmentShader = newFragmentShader;
+        
+        for (size_t i = 0; i < _uniformNames.size(); ++i)
+        {
+            _uniformLocations[i] = glGetUniformLocation(_programId, _uniformNames[i].c_str());
+        }
+        
         return true;
     }
+    
+    uint32_t ShaderOGL::getUniformId(const std::string& name)
+    {
+        for (size_t i = 0; i < _uniformNames.size(); ++i)
+        {
+            if (_uniformNames[i] == name)
+            {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        
+        _uniformNames.push_back(name);
+        _uniformLocations.push_back(glGetUniformLocation(_programId, name.c_str()));
+        
+        return static_cast<uint32_t>(_uniformNames.size() - 1);
+    }
 
     bool ShaderOGL::checkShaderError(GLuint shader)
     {
@@ -98,47 +148,47 @@ namespace ouzel
     
     uint32_t ShaderOGL::getPixelShaderConstantId(const std::string& name)
     {
-        return glGetUniformLocation(_programId, name.c_str());
+        return getUniformId(name);
     }
     
     bool ShaderOGL::setPixelShaderConstant(uint32_t index, const Vector3* vectors, uint32_t count)
     {
-        glUniform3fv(index, count, reinterpret_cast<const float*>(vectors));
+        glUniform3fv(_uniformLocations[index], count, reinterpret_cast<const float*>(vectors));
         return true;
     }
     
     bool ShaderOGL::setPixelShaderConstant(uint32_t index, const Vector4* vectors, uint32_t count)
     {
-        glUniform4fv(index, count, reinterpret_cast<const float*>(vectors));
+        glUniform4fv(_uniformLocations[index], count, reinterpret_cast<const float*>(vectors));
         return true;
     }
     
     bool ShaderOGL::setPixelShaderConstant(uint32_t index, const Matrix4* matrices, uint32_t count)
     {
-        glUniformMatrix4fv(index, count, GL_FALSE, reinterpret_cast<const float*>(matrices));
+        glUniformMatrix4fv(_uniformLocations[index], count, GL_FALSE, reinterpret_cast<const float*>(matrices));
         return true;
     }
     
     uint32_t ShaderOGL::getVertexShaderConstantId(const std::string& name)
     {
-        return glGetUniformLocation(_programId, name.c_str());
+        return getUniformId(name);
     }
     
     bool ShaderOGL::setVertexShaderConstant(uint32_t index, const Vector3* vectors, uint32_t count)
     {
-        glUniform3fv(index, count, reinterpret_cast<const float*>(vectors));
+        glUniform3fv(_uniformLocations[index], count, reinterpret_cast<const float*>(vectors));
         return true;
     }
     
     bool ShaderOGL::setVertexShaderConstant(uint32_t index, const Vector4* vectors, uint32_t count)
     {
-        glUniform4fv(index, count, reinterpret_cast<const float*>(vectors));
+        glUniform4fv(_uniformLocations[index], count, reinterpret_cast<const float*>(vectors));
         return true;
     }
     
     bool ShaderOGL::setVertexShaderConstant(uint32_t index, const Matrix4* matrices, uint32_t count)
     {
-        glUniformMatrix4fv(index, count, GL_FALSE, reinterpret_cast<const float*>(matrices));
+        glUniformMatrix4fv(_uniformLocations[index], count, GL_FALSE, reinterpret_cast<const float*>(matrices));
         return true;
     }
 }
@@ -12,6 +12,8 @@
 #import <OpenGLES/ES2/glext.h>
 #endif
 
+#include <string>
+#include <vector>
 #include "Shader.h"
 
 namespace ouzel
@@ -38,9 +40,14 @@ namespace ouzel
         
     protected:
         bool checkShaderError(GLuint shader);
+        uint32_t getUniformId(const std::string& name);
         
-        GLuint _vertexShader;
-        GLuint _fragmentShader;
-        GLuint _programId;
+        GLuint _vertexShader = 0;
+        GLuint _fragmentShader = 0;
+        GLuint _programId = 0;
+        
+        // constant ids index these, so they stay valid when the program is relinked after a reload
+        std::vector<std::string> _uniformNames;
+        std::vector<GLint> _uniformLocations;
     };
 }
@@ -1,6 +1,8 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
 #include "Sprite.h"
 #include "CompileConfig.h"
 #include "Engine.h"
@@ -10,6 +12,7 @@
 #include "Utils.h"
 #include "Camera.h"
 #include "Scene.h"
+#include "SpriteAnimator.h"
 
 namespace ouzel
 {
@@ -20,11 +23,7 @@ namespace ouzel
         
         _texture = _engine->getRenderer()->getTexture(filename);
         
-        if (_texture)
-        {
-            _size = _texture->getSize();
-            _boundingBox.set(-_size.width / 2.0f, -_size.height / 2.0f, _size.width, _size.height);
-        }
+        updateTextureFrame();
 
         _shader = _engine->getRenderer()->getShader(SHADER_TEXTURE);
         
@@ -37,36 +36,53 @@ namespace ouzel
 #endif
         }
         
-        std::vector<uint16_t> indices = {0, 1, 2, 1, 3, 2};
-        
-        std::vector<Vertex> vertices = {
-            Vertex(Vector3(-_size.width / 2.0f, -_size.height / 2.0f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(0.0f, 1.0f)),
-            Vertex(Vector3(_size.width / 2.0f, -_size.height / 2.0f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(1.0f, 1.0f)),
-            Vertex(Vector3(-_size.width / 2.0f, _size.height / 2.0f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(0.0f, 0.0f)),
-            Vertex(Vector3(_size.width / 2.0f, _size.height / 2.0f, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF), Vector2(1.0f, 0.0f))
-        };
-        
-        _meshBuffer = _scene->getEngine()->getRenderer()->createMeshBuffer(indices, vertices);
+        updateTransform();
     }
 
     Sprite::~Sprite()
     {
-
+        if (_animationIndex != SpriteAnimator::INVALID_INDEX)
+        {
+            _scene->getSpriteAnimator()->stop(this);
+        }
     }
 
-    void Sprite::draw()
+    void Sprite::draw(Camera* camera)
     {
-        Node::draw();
+        Node::draw(camera);
         
         if (_shader && _texture)
         {
+            // a reloaded texture can have a different size and trimmed mesh, sprite sheet frames keep theirs
+            if (_texture->getVersion() != _textureVersion)
+            {
+                _textureVersion = _texture->getVersion();
+                
+                if (!_showsSpriteFrame)
+                {
+                    updateTextureFrame();
+                    updateDrawTransform();
+                    markDirty();
+                }
+            }
+            
             _engine->getRenderer()->activateTexture(_texture, 0);
             _engine->getRenderer()->activateShader(_shader);
             
-            Matrix4 modelViewProj = _engine->getRenderer()->getProjection() * _engine->getScene()->getCamera()->getTransform() * _transform;
+            Matrix4 modelViewProj = camera->getViewProjection() * _drawTransform;
             
             _shader->setVertexShaderConstant(_uniModelViewProj, &modelViewProj, 1);
             
+            if (_texture->isStreamed() && _frameSize.width > 0.0f && _frameSize.height > 0.0f)
+            {
+                // the unit quad's axes in clip space, scaled to pixels
+                const Size2& screenSize = _engine->getRenderer()->getSize();
+                float screenWidth = sqrtf(powf(modelViewProj.m[0] * screenSize.width / 2.0f, 2.0f) + powf(modelViewProj.m[1] * screenSize.height / 2.0f, 2.0f));
+                float screenHeight = sqrtf(powf(modelViewProj.m[4] * screenSize.width / 2.0f, 2.0f) + powf(modelViewProj.m[5] * screenSize.height / 2.0f, 2.0f));
+                
+                _texture->requestScale(std::max(screenWidth / _frameSize.width, screenHeight / _frameSize.height));
+            }
+            
             _engine->getRenderer()->drawMeshBuffer(_meshBuffer);
         }
         
@@ -75,24 +91,73 @@ namespace ouzel
     void Sprite::setTexture(Texture* texture)
     {
         _texture = texture;
+        
+        updateTextureFrame();
+        updateDrawTransform();
+        markDirty();
     }
     
     void Sprite::setShader(Shader* shader)
     {
         _shader = shader;
+        
+        markDirty();
     }
     
-    bool Sprite::checkVisibility() const
+    void Sprite::setSpriteFrame(const SpriteFrame& frame)
     {
-        Matrix4 mvp = _engine->getRenderer()->getProjection() * _engine->getScene()->getCamera()->getTransform() * _transform;
+        _showsSpriteFrame = true;
+        _meshBuffer = frame.meshBuffer;
+        _frameSize = frame.size;
+        _frameOffset = frame.offset;
         
-        Vector3 topRight(_size.width / 2.0f, _size.height / 2.0f, 0.0f);
-        Vector3 bottomLeft(-_size.width / 2.0f, -_size.height / 2.0f, 0.0f);
+        if (_size.width != frame.sourceSize.width || _size.height != frame.sourceSize.height)
+        {
+            _size = frame.sourceSize;
+            _boundingBox.set(-_size.width / 2.0f, -_size.height / 2.0f, _size.width, _size.height);
+        }
         
-        mvp.transformPoint(&topRight);
-        mvp.transformPoint(&bottomLeft);
+        updateDrawTransform();
+        markDirty();
+    }
+    
+    void Sprite::updateTextureFrame()
+    {
+        // the whole texture is shown, skipping its transparent border if it has a trimmed mesh
+        _textureVersion = _texture ? _texture->getVersion() : 0;
+        _showsSpriteFrame = false;
+        
+        _size = _texture ? _texture->getSize() : Size2();
+        _frameSize = _size;
+        _frameOffset = Vector2();
+        _boundingBox.set(-_size.width / 2.0f, -_size.height / 2.0f, _size.width, _size.height);
+        
+        if (_texture && _texture->getTrimmedMeshBuffer())
+        {
+            _meshBuffer = _texture->getTrimmedMeshBuffer();
+        }
+        else
+        {
+            _meshBuffer = _engine->getRenderer()->getQuadMeshBuffer();
+        }
+    }
+    
+    void Sprite::updateTransform()
+    {
+        Node::updateTransform();
         
-        return (topRight.x >= -1.0f && topRight.y >= -1.0f &&
-                bottomLeft.x <= 1.0f && bottomLeft.y <= 1.0f);
+        updateDrawTransform();
+    }
+    
+    void Sprite::updateDrawTransform()
+    {
+        _drawTransform = _transform;
+        _drawTransform.translate(_frameOffset.x, _frameOffset.y, 0.0f);
+        _drawTransform.scale(_frameSize.width, _frameSize.height, 1.0f);
+    }
+    
+    bool Sprite::isOpaque() const
+    {
+        return _texture && _texture->isOpaque();
     }
 }
@@ -7,6 +7,8 @@
 #include "Node.h"
 #include "Size2.h"
 #include "MeshBuffer.h"
+#include "SpriteSheet.h"
+#include "SpriteAnimator.h"
 
 namespace ouzel
 {
@@ -17,11 +19,12 @@ namespace ouzel
     
     class Sprite: public Node
     {
+        friend SpriteAnimator;
     public:
         Sprite(const std::string& filename, Scene* scene);
         virtual ~Sprite();
         
-        virtual void draw() override;
+        virtual void draw(Camera* camera) override;
         
         Texture* getTexture() const { return _texture; }
         void setTexture(Texture* texture);
@@ -31,9 +34,17 @@ namespace ouzel
         
         const Size2& getSize() const { return _size; }
         
-        virtual bool checkVisibility() const override;
+        // shows one frame of a sprite sheet, the texture has to be set to the sprite sheet's texture
+        void setSpriteFrame(const SpriteFrame& frame);
+        
+        virtual bool isOpaque() const override;
+        
+        virtual void updateTransform() override;
         
     protected:
+        void updateTextureFrame();
+        void updateDrawTransform();
+        
         AutoPtr<Texture> _texture;
         AutoPtr<Shader> _shader;
         
@@ -41,7 +52,18 @@ namespace ouzel
         
         Size2 _size;
         
+        // shared unit quad, scaled to the frame size by _drawTransform
         AutoPtr<MeshBuffer> _meshBuffer;
+        Matrix4 _drawTransform;
+        
+        // trimmed sprite sheet frames are smaller than the sprite and not centered
+        Size2 _frameSize;
+        Vector2 _frameOffset;
+        bool _showsSpriteFrame = false;
+        
+        uint32_t _textureVersion = 0;
+        
+        uint32_t _animationIndex = SpriteAnimator::INVALID_INDEX;
         
         uint32_t _uniModelViewProj;
     };
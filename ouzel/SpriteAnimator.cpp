@@ -0,0 +1,171 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include "SpriteAnimator.h"
+#include "Sprite.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    SpriteAnimator::SpriteAnimator()
+    {
+        
+    }
+    
+    SpriteAnimator::~SpriteAnimator()
+    {
+        for (Animation& animation : _animations)
+        {
+            animation.sprite->_animationIndex = INVALID_INDEX;
+        }
+    }
+    
+    bool SpriteAnimator::play(Sprite* sprite, SpriteSheet* spriteSheet, const std::string& animation, bool loop)
+    {
+        SpriteAnimationDefinition definition;
+        
+        if (!sprite || !spriteSheet || !spriteSheet->getAnimation(animation, definition))
+        {
+            log("Failed to play animation %s", animation.c_str());
+            return false;
+        }
+        
+        if (sprite->_animationIndex == INVALID_INDEX)
+        {
+            sprite->_animationIndex = static_cast<uint32_t>(_animations.size());
+            _animations.push_back(Animation());
+        }
+        
+        Animation& state = _animations[sprite->_animationIndex];
+        state.sprite = sprite;
+        state.spriteSheet = spriteSheet;
+        state.firstFrame = definition.firstFrame;
+        state.lastFrame = definition.lastFrame;
+        state.direction = definition.direction;
+        state.loop = loop;
+        state.time = 0.0f;
+        
+        if (definition.direction == SpriteAnimationDefinition::Direction::REVERSE)
+        {
+            state.currentFrame = definition.lastFrame;
+            state.step = -1;
+        }
+        else
+        {
+            state.currentFrame = definition.firstFrame;
+            state.step = 1;
+        }
+        
+        sprite->setTexture(spriteSheet->getTexture());
+        sprite->setSpriteFrame(spriteSheet->getFrame(state.currentFrame));
+        
+        return true;
+    }
+    
+    void SpriteAnimator::stop(Sprite* sprite)
+    {
+        if (sprite && sprite->_animationIndex != INVALID_INDEX)
+        {
+            remove(sprite->_animationIndex);
+        }
+    }
+    
+    bool SpriteAnimator::isPlaying(Sprite* sprite) const
+    {
+        return sprite && sprite->_animationIndex != INVALID_INDEX;
+    }
+    
+    void SpriteAnimator::update(float delta)
+    {
+        for (uint32_t i = 0; i < _animations.size();)
+        {
+            Animation& animation = _animations[i];
+            animation.time += delta;
+            
+            uint32_t previousFrame = animation.currentFrame;
+            bool playing = true;
+            
+            float duration = animation.spriteSheet->getFrame(animation.currentFrame).duration;
+            
+            while (animation.time >= duration)
+            {
+                animation.time -= duration;
+                
+                if (!advance(animation))
+                {
+                    playing = false;
+                    break;
+                }
+                
+                duration = animation.spriteSheet->getFrame(animation.currentFrame).duration;
+            }
+            
+            // only the shared quad and the sizes change, nothing is allocated
+            if (animation.currentFrame != previousFrame)
+            {
+                animation.sprite->setSpriteFrame(animation.spriteSheet->getFrame(animation.currentFrame));
+            }
+            
+            if (playing)
+            {
+                ++i;
+            }
+            else
+            {
+                // the last animation is moved to this slot, so it is updated next
+                remove(i);
+            }
+        }
+    }
+    
+    bool SpriteAnimator::advance(Animation& animation)
+    {
+        if (animation.firstFrame == animation.lastFrame)
+        {
+            return animation.loop;
+        }
+        
+        uint32_t endFrame = (animation.step > 0) ? animation.lastFrame : animation.firstFrame;
+        
+        if (animation.currentFrame != endFrame)
+        {
+            animation.currentFrame += animation.step;
+            return true;
+        }
+        
+        if (animation.direction == SpriteAnimationDefinition::Direction::PINGPONG)
+        {
+            // one cycle ends when the animation returns to the first frame
+            if (animation.step < 0 && !animation.loop)
+            {
+                return false;
+            }
+            
+            animation.step = -animation.step;
+            animation.currentFrame += animation.step;
+            return true;
+        }
+        
+        if (!animation.loop)
+        {
+            return false;
+        }
+        
+        animation.currentFrame = (animation.step > 0) ? animation.firstFrame : animation.lastFrame;
+        
+        return true;
+    }
+    
+    void SpriteAnimator::remove(uint32_t index)
+    {
+        _animations[index].sprite->_animationIndex = INVALID_INDEX;
+        
+        if (index != _animations.size() - 1)
+        {
+            _animations[index] = _animations.back();
+            _animations[index].sprite->_animationIndex = index;
+        }
+        
+        _animations.pop_back();
+    }
+}
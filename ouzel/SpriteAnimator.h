@@ -0,0 +1,55 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "AutoPtr.h"
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "SpriteSheet.h"
+
+namespace ouzel
+{
+    class Sprite;
+    
+    // advances all sprite sheet animations of a scene in one pass over a flat array
+    class SpriteAnimator: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+        
+        SpriteAnimator();
+        virtual ~SpriteAnimator();
+        
+        // empty animation name plays all the frames of the sprite sheet
+        bool play(Sprite* sprite, SpriteSheet* spriteSheet, const std::string& animation = "", bool loop = true);
+        void stop(Sprite* sprite);
+        bool isPlaying(Sprite* sprite) const;
+        
+        void update(float delta);
+        
+        uint32_t getAnimationCount() const { return static_cast<uint32_t>(_animations.size()); }
+        
+    protected:
+        struct Animation
+        {
+            Sprite* sprite;
+            AutoPtr<SpriteSheet> spriteSheet;
+            uint32_t firstFrame;
+            uint32_t lastFrame;
+            uint32_t currentFrame;
+            int32_t step;
+            SpriteAnimationDefinition::Direction direction;
+            bool loop;
+            float time;
+        };
+        
+        // returns false when a non-looping animation has finished
+        bool advance(Animation& animation);
+        void remove(uint32_t index);
+        
+        std::vector<Animation> _animations;
+    };
+}
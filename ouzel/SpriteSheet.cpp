@@ -0,0 +1,262 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <cstdio>
+#include <cstring>
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/document.h>
+#include "SpriteSheet.h"
+#include "Engine.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "FileSystem.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    static bool readNumber(const rapidjson::Value& object, const char* name, float& value)
+    {
+        if (!object.IsObject() || !object.HasMember(name) || !object[name].IsNumber())
+        {
+            return false;
+        }
+        
+        value = static_cast<float>(object[name].GetDouble());
+        
+        return true;
+    }
+    
+    static bool readFrame(const rapidjson::Value& frameObject, const std::string& name, const Size2& textureSize,
+                          Renderer* renderer, SpriteFrame& frame)
+    {
+        if (!frameObject.IsObject() || !frameObject.HasMember("frame"))
+        {
+            return false;
+        }
+        
+        if (frameObject.HasMember("rotated") && (!frameObject["rotated"].IsBool() || frameObject["rotated"].GetBool()))
+        {
+            log("Rotated sprite frames are not supported (%s)", name.c_str());
+            return false;
+        }
+        
+        const rapidjson::Value& rectangleObject = frameObject["frame"];
+        
+        Rectangle rectangle;
+        
+        if (!readNumber(rectangleObject, "x", rectangle.x) || !readNumber(rectangleObject, "y", rectangle.y) ||
+            !readNumber(rectangleObject, "w", rectangle.width) || !readNumber(rectangleObject, "h", rectangle.height))
+        {
+            return false;
+        }
+        
+        frame.name = name;
+        frame.size = Size2(rectangle.width, rectangle.height);
+        frame.sourceSize = frame.size;
+        
+        if (frameObject.HasMember("sourceSize") && frameObject.HasMember("spriteSourceSize"))
+        {
+            const rapidjson::Value& sourceSizeObject = frameObject["sourceSize"];
+            const rapidjson::Value& spriteSourceSizeObject = frameObject["spriteSourceSize"];
+            
+            // trimmed rectangle is given from the top left corner of the source image
+            float trimX;
+            float trimY;
+            
+            if (!readNumber(sourceSizeObject, "w", frame.sourceSize.width) || !readNumber(sourceSizeObject, "h", frame.sourceSize.height) ||
+                !readNumber(spriteSourceSizeObject, "x", trimX) || !readNumber(spriteSourceSizeObject, "y", trimY))
+            {
+                return false;
+            }
+            
+            frame.offset.x = trimX + frame.size.width / 2.0f - frame.sourceSize.width / 2.0f;
+            frame.offset.y = frame.sourceSize.height / 2.0f - (trimY + frame.size.height / 2.0f);
+        }
+        
+        // durations are in milliseconds
+        float duration;
+        
+        if (readNumber(frameObject, "duration", duration) && duration > 0.0f)
+        {
+            frame.duration = duration / 1000.0f;
+        }
+        
+        Rectangle texCoords(rectangle.x / textureSize.width, rectangle.y / textureSize.height,
+                            rectangle.width / textureSize.width, rectangle.height / textureSize.height);
+        
+        frame.meshBuffer = renderer->getQuadMeshBuffer(texCoords);
+        
+        return frame.meshBuffer != nullptr;
+    }
+    
+    SpriteSheet::SpriteSheet(Engine* engine):
+        _engine(engine)
+    {
+        
+    }
+    
+    SpriteSheet::~SpriteSheet()
+    {
+        
+    }
+    
+    bool SpriteSheet::initFromFile(const std::string& filename)
+    {
+        std::vector<uint8_t> data;
+        
+        if (!_engine->getFileSystem()->readFile(filename, data))
+        {
+            log("Failed to open sprite sheet file %s", filename.c_str());
+            return false;
+        }
+        
+        rapidjson::MemoryStream is(reinterpret_cast<const char*>(data.data()), data.size());
+        
+        rapidjson::Document document;
+        document.ParseStream<0>(is);
+        
+        if (document.HasParseError() || !document.HasMember("frames") ||
+            !document.HasMember("meta") || !document["meta"].HasMember("image"))
+        {
+            log("Invalid sprite sheet file %s", filename.c_str());
+            return false;
+        }
+        
+        const rapidjson::Value& meta = document["meta"];
+        
+        // image is relative to the sprite sheet file
+        _texture = _engine->getRenderer()->getTexture(FileSystem::getDirectoryPart(filename) + meta["image"].GetString());
+        
+        if (!_texture)
+        {
+            return false;
+        }
+        
+        const Size2& textureSize = _texture->getSize();
+        const rapidjson::Value& frames = document["frames"];
+        
+        _frames.clear();
+        _frameIndices.clear();
+        _animations.clear();
+        
+        // frames are exported either as an array or as an object keyed by frame name
+        if (frames.IsArray())
+        {
+            _frames.reserve(frames.Size());
+            
+            for (rapidjson::Value::ConstValueIterator i = frames.Begin(); i != frames.End(); ++i)
+            {
+                SpriteFrame frame;
+                
+                if (!readFrame(*i, (i->IsObject() && i->HasMember("filename") && (*i)["filename"].IsString()) ? (*i)["filename"].GetString() : "",
+                               textureSize, _engine->getRenderer(), frame))
+                {
+                    log("Invalid frame in sprite sheet %s", filename.c_str());
+                    return false;
+                }
+                
+                _frames.push_back(frame);
+            }
+        }
+        else if (frames.IsObject())
+        {
+            for (rapidjson::Value::ConstMemberIterator i = frames.MemberBegin(); i != frames.MemberEnd(); ++i)
+            {
+                SpriteFrame frame;
+                
+                if (!readFrame(i->value, i->name.GetString(), textureSize, _engine->getRenderer(), frame))
+                {
+                    log("Invalid frame in sprite sheet %s", filename.c_str());
+                    return false;
+                }
+                
+                _frames.push_back(frame);
+            }
+        }
+        
+        if (_frames.empty())
+        {
+            log("Sprite sheet %s has no frames", filename.c_str());
+            return false;
+        }
+        
+        for (uint32_t i = 0; i < _frames.size(); ++i)
+        {
+            if (!_frames[i].name.empty())
+            {
+                _frameIndices[_frames[i].name] = i;
+            }
+        }
+        
+        // animations exported by Aseprite
+        if (meta.HasMember("frameTags") && meta["frameTags"].IsArray())
+        {
+            const rapidjson::Value& frameTags = meta["frameTags"];
+            
+            for (rapidjson::Value::ConstValueIterator i = frameTags.Begin(); i != frameTags.End(); ++i)
+            {
+                if (!i->IsObject() || !i->HasMember("name") || !(*i)["name"].IsString() ||
+                    !i->HasMember("from") || !(*i)["from"].IsUint() || !i->HasMember("to") || !(*i)["to"].IsUint())
+                {
+                    log("Invalid animation in sprite sheet %s", filename.c_str());
+                    continue;
+                }
+                
+                SpriteAnimationDefinition animation;
+                animation.firstFrame = (*i)["from"].GetUint();
+                animation.lastFrame = (*i)["to"].GetUint();
+                
+                if (animation.firstFrame > animation.lastFrame || animation.lastFrame >= _frames.size())
+                {
+                    log("Invalid animation %s in sprite sheet %s", (*i)["name"].GetString(), filename.c_str());
+                    continue;
+                }
+                
+                if (i->HasMember("direction") && (*i)["direction"].IsString())
+                {
+                    const char* direction = (*i)["direction"].GetString();
+                    
+                    if (strcmp(direction, "reverse") == 0) animation.direction = SpriteAnimationDefinition::Direction::REVERSE;
+                    else if (strcmp(direction, "pingpong") == 0) animation.direction = SpriteAnimationDefinition::Direction::PINGPONG;
+                }
+                
+                _animations[(*i)["name"].GetString()] = animation;
+            }
+        }
+        
+        return true;
+    }
+    
+    uint32_t SpriteSheet::getFrameIndex(const std::string& name) const
+    {
+        std::unordered_map<std::string, uint32_t>::const_iterator i = _frameIndices.find(name);
+        
+        if (i != _frameIndices.end())
+        {
+            return i->second;
+        }
+        
+        return INVALID_FRAME;
+    }
+    
+    bool SpriteSheet::getAnimation(const std::string& name, SpriteAnimationDefinition& animation) const
+    {
+        if (name.empty())
+        {
+            animation = SpriteAnimationDefinition();
+            animation.lastFrame = static_cast<uint32_t>(_frames.size()) - 1;
+            return true;
+        }
+        
+        std::unordered_map<std::string, SpriteAnimationDefinition>::const_iterator i = _animations.find(name);
+        
+        if (i != _animations.end())
+        {
+            animation = i->second;
+            return true;
+        }
+        
+        return false;
+    }
+}
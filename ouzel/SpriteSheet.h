@@ -0,0 +1,80 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "AutoPtr.h"
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+#include "Rectangle.h"
+#include "Size2.h"
+#include "Vector2.h"
+#include "MeshBuffer.h"
+
+namespace ouzel
+{
+    class Engine;
+    class Texture;
+    
+    struct SpriteFrame
+    {
+        std::string name;
+        
+        // size of the trimmed image and its offset from the center of the untrimmed one
+        Size2 size;
+        Vector2 offset;
+        Size2 sourceSize;
+        
+        float duration = 0.1f;
+        
+        // quad shared with all other users of the same texture coordinates
+        AutoPtr<MeshBuffer> meshBuffer;
+    };
+    
+    struct SpriteAnimationDefinition
+    {
+        enum class Direction
+        {
+            FORWARD,
+            REVERSE,
+            PINGPONG
+        };
+        
+        uint32_t firstFrame = 0;
+        uint32_t lastFrame = 0;
+        Direction direction = Direction::FORWARD;
+    };
+    
+    // texture atlas described by a JSON file in the TexturePacker/Aseprite format
+    class SpriteSheet: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        static const uint32_t INVALID_FRAME = 0xFFFFFFFF;
+        
+        SpriteSheet(Engine* engine);
+        virtual ~SpriteSheet();
+        
+        virtual bool initFromFile(const std::string& filename);
+        
+        Texture* getTexture() const { return _texture; }
+        
+        uint32_t getFrameCount() const { return static_cast<uint32_t>(_frames.size()); }
+        const SpriteFrame& getFrame(uint32_t index) const { return _frames[index]; }
+        uint32_t getFrameIndex(const std::string& name) const;
+        
+        // empty name returns an animation over all the frames
+        bool getAnimation(const std::string& name, SpriteAnimationDefinition& animation) const;
+        
+    protected:
+        Engine* _engine;
+        
+        AutoPtr<Texture> _texture;
+        
+        std::vector<SpriteFrame> _frames;
+        std::unordered_map<std::string, uint32_t> _frameIndices;
+        std::unordered_map<std::string, SpriteAnimationDefinition> _animations;
+    };
+}
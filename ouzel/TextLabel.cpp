@@ -0,0 +1,156 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <vector>
+#include "TextLabel.h"
+#include "CompileConfig.h"
+#include "Engine.h"
+#include "Renderer.h"
+#include "BMFont.h"
+#include "Texture.h"
+#include "Shader.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    TextLabel::TextLabel(Scene* scene):
+        Node(scene)
+    {
+        _engine = _scene->getEngine();
+        
+        setShader(_engine->getRenderer()->getShader(SHADER_TEXTURE));
+    }
+    
+    TextLabel::~TextLabel()
+    {
+        
+    }
+    
+    bool TextLabel::init(const std::string& font, const std::string& text)
+    {
+        _font = _engine->getRenderer()->getFont(font);
+        
+        if (!_font)
+        {
+            return false;
+        }
+        
+        _text = text;
+        
+        return updateMesh();
+    }
+    
+    void TextLabel::setText(const std::string& text)
+    {
+        if (_text != text)
+        {
+            _text = text;
+            
+            // the bounding box has to be known before drawing to find the area to redraw,
+            // the mesh is rebuilt once on the next draw even if the text changes several times in a frame
+            if (_font)
+            {
+                _size = _font->getTextSize(_text);
+                _boundingBox.set(-_size.width / 2.0f, -_size.height / 2.0f, _size.width, _size.height);
+            }
+            
+            _needsMeshUpdate = true;
+            
+            markDirty();
+        }
+    }
+    
+    void TextLabel::setColor(const Color& color)
+    {
+        if (_color.r != color.r || _color.g != color.g || _color.b != color.b || _color.a != color.a)
+        {
+            _color = color;
+            _needsMeshUpdate = true;
+            
+            markDirty();
+        }
+    }
+    
+    void TextLabel::setShader(Shader* shader)
+    {
+        _shader = shader;
+        
+        if (_shader)
+        {
+#ifdef OUZEL_PLATFORM_WINDOWS
+            _uniModelViewProj = 0;
+#else
+            _uniModelViewProj = _shader->getVertexShaderConstantId("modelViewProj");
+#endif
+        }
+    }
+    
+    bool TextLabel::updateMesh()
+    {
+        _needsMeshUpdate = false;
+        
+        if (!_font->getVertices(_text, _color, _indices, _vertices, _size))
+        {
+            _indices.clear();
+            _vertices.clear();
+            return false;
+        }
+        
+        _boundingBox.set(-_size.width / 2.0f, -_size.height / 2.0f, _size.width, _size.height);
+        
+        return true;
+    }
+    
+    bool TextLabel::canBatchWith(const TextLabel* label) const
+    {
+        return _font && label->_font && _font->getTexture() == label->_font->getTexture() && _shader == label->_shader;
+    }
+    
+    bool TextLabel::addToBatch(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices)
+    {
+        if (!_font || !_shader)
+        {
+            return false;
+        }
+        
+        if (_needsMeshUpdate)
+        {
+            updateMesh();
+        }
+        
+        if (_indices.empty())
+        {
+            return false;
+        }
+        
+        uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+        
+        for (uint16_t index : _indices)
+        {
+            indices.push_back(firstVertex + index);
+        }
+        
+        for (const Vertex& vertex : _vertices)
+        {
+            vertices.push_back(vertex);
+            _transform.transformPoint(&vertices.back().position);
+        }
+        
+        return true;
+    }
+    
+    void TextLabel::drawBatch(Camera* camera, MeshBuffer* meshBuffer)
+    {
+        _engine->getRenderer()->activateTexture(_font->getTexture(), 0);
+        _engine->getRenderer()->activateShader(_shader);
+        
+        // the vertices are already in world coordinates
+        const Matrix4& modelViewProj = camera->getViewProjection();
+        
+        _shader->setVertexShaderConstant(_uniModelViewProj, &modelViewProj, 1);
+        
+        _engine->getRenderer()->drawMeshBuffer(meshBuffer);
+    }
+}
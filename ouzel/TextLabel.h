@@ -0,0 +1,72 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "AutoPtr.h"
+#include "Node.h"
+#include "Size2.h"
+#include "Color.h"
+#include "Vertex.h"
+
+namespace ouzel
+{
+    class Engine;
+    class Scene;
+    class Camera;
+    class BMFont;
+    class Shader;
+    class MeshBuffer;
+    
+    // drawn by the scene together with the adjacent labels that share the font page and shader
+    class TextLabel: public Node
+    {
+    public:
+        TextLabel(Scene* scene);
+        virtual ~TextLabel();
+        
+        virtual bool init(const std::string& font, const std::string& text);
+        
+        virtual bool isTextLabel() const override { return true; }
+        
+        bool canBatchWith(const TextLabel* label) const;
+        // appends the quads transformed to world coordinates, returns false if the label has nothing to draw
+        bool addToBatch(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices);
+        // draws a mesh buffer with world coordinates using the font page and shader of this label
+        void drawBatch(Camera* camera, MeshBuffer* meshBuffer);
+        
+        const std::string& getText() const { return _text; }
+        void setText(const std::string& text);
+        
+        const Color& getColor() const { return _color; }
+        void setColor(const Color& color);
+        
+        BMFont* getFont() const { return _font; }
+        
+        Shader* getShader() const { return _shader; }
+        void setShader(Shader* shader);
+        
+        const Size2& getSize() const { return _size; }
+        
+    protected:
+        bool updateMesh();
+        
+        Engine* _engine;
+        
+        AutoPtr<BMFont> _font;
+        AutoPtr<Shader> _shader;
+        
+        // in local coordinates, rebuilt on the next draw after the text or color changes
+        std::vector<uint16_t> _indices;
+        std::vector<Vertex> _vertices;
+        bool _needsMeshUpdate = false;
+        
+        std::string _text;
+        Color _color = Color(0xFF, 0xFF, 0xFF, 0xFF);
+        Size2 _size;
+        
+        uint32_t _uniModelViewProj = 0;
+    };
+}
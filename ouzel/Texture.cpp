@@ -1,8 +1,14 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <algorithm>
+#include <cmath>
 #include "Texture.h"
 #include "Renderer.h"
+#include "Engine.h"
+#include "Image.h"
+#include "FileSystem.h"
+#include "Utils.h"
 
 namespace ouzel
 {
@@ -14,6 +20,8 @@ namespace ouzel
 
     Texture::~Texture()
     {
+        _renderer->getEngine()->getFileSystem()->unwatchFile(_fileWatchId);
+        
         for (int i = 0; i < TEXTURE_LAYERS; ++i)
         {
             if (_renderer->getActiveTexture(i) == this)
@@ -27,6 +35,227 @@ namespace ouzel
     {
         _filename = filename;
         
+        AutoPtr<Image> image = new Image(_renderer->getEngine());
+        
+        if (!_renderer->loadTextureImage(image, filename))
+        {
+            return false;
+        }
+        
+        return initFromFile(image);
+    }
+    
+    bool Texture::initFromFile(Image* image)
+    {
+        _filename = image->getFilename();
+        
+        // streamed textures start with the smallest level and get the larger ones once they are drawn
+        if (_renderer->isTextureStreamingEnabled() && image->getMipmapCount() > 1)
+        {
+            _image = image;
+            _residentLevel = image->getMipmapCount() - 1;
+        }
+        else
+        {
+            _image = nullptr;
+            _residentLevel = 0;
+        }
+        
+        _requestedLevel = 0xFFFFFFFF;
+        _draws = 0;
+        _scaledDraws = 0;
+        _demoteFrames = 0;
+        
+        if (!initFromImage(image))
+        {
+            return false;
+        }
+        
+        if (!_fileWatchId)
+        {
+            _fileWatchId = _renderer->getEngine()->getFileSystem()->watchFile(_filename, [this]() { reload(); });
+        }
+        
         return true;
     }
+    
+    bool Texture::reload()
+    {
+        // updating the memory usage can evict the texture if only the cache holds it
+        AutoPtr<Texture> self(this);
+        
+        AutoPtr<Image> image = new Image(_renderer->getEngine());
+        
+        if (!_renderer->loadTextureImage(image, _filename))
+        {
+            return false;
+        }
+        
+        uint64_t previousMemorySize = _memorySize;
+        
+        if (!initFromFile(image))
+        {
+            return false;
+        }
+        
+        ++_version;
+        
+        _renderer->updateTextureMemoryUsage(this, previousMemorySize);
+        
+        log("Reloaded texture %s", _filename.c_str());
+        
+        return true;
+    }
+    
+    bool Texture::initFromImage(const Image* image)
+    {
+        _size = image->getSize();
+        _opaque = image->isOpaque();
+        
+        if (_renderer->isAlphaTrimmingEnabled() && !createTrimmedMeshBuffer(image))
+        {
+            return false;
+        }
+        
+        return uploadImage(image, std::min(_residentLevel, image->getMipmapCount() - 1));
+    }
+    
+    bool Texture::uploadImage(const Image* image, uint32_t firstLevel)
+    {
+        _memorySize = getMipmapMemorySize(image, firstLevel, getPixelSize(image->getPixelFormat()));
+        
+        return true;
+    }
+    
+    uint64_t Texture::getMipmapMemorySize(const Image* image, uint32_t firstLevel, uint32_t pixelSize)
+    {
+        uint64_t memorySize = 0;
+        
+        for (uint32_t level = firstLevel; level < image->getMipmapCount(); ++level)
+        {
+            const Size2& size = image->getMipmapSize(level);
+            memorySize += static_cast<uint64_t>(size.width) * static_cast<uint64_t>(size.height) * pixelSize;
+        }
+        
+        return memorySize;
+    }
+    
+    void Texture::requestScale(float scale)
+    {
+        if (!_image.item)
+        {
+            return;
+        }
+        
+        // each level halves the resolution
+        uint32_t level = 0;
+        
+        while (scale < 0.5f && level + 1 < _image->getMipmapCount())
+        {
+            scale *= 2.0f;
+            ++level;
+        }
+        
+        _requestedLevel = std::min(_requestedLevel, level);
+        ++_scaledDraws;
+    }
+    
+    bool Texture::updateStreaming()
+    {
+        if (!_image.item)
+        {
+            return false;
+        }
+        
+        // textures that were not drawn can drop to the smallest level, the ones drawn by nodes that don't request a scale need all of them
+        uint32_t level = (_draws > _scaledDraws) ? 0 : std::min(_requestedLevel, _image->getMipmapCount() - 1);
+        _requestedLevel = 0xFFFFFFFF;
+        _draws = 0;
+        _scaledDraws = 0;
+        
+        if (level == _residentLevel)
+        {
+            _demoteFrames = 0;
+            return false;
+        }
+        
+        if (level > _residentLevel && ++_demoteFrames < STREAMING_DEMOTE_DELAY)
+        {
+            return false;
+        }
+        
+        _demoteFrames = 0;
+        
+        if (!uploadImage(_image, level))
+        {
+            return false;
+        }
+        
+        _residentLevel = level;
+        
+        return true;
+    }
+    
+    bool Texture::initFromData(const void* data, const Size2& size, bool renderTarget)
+    {
+        _size = size;
+        _opaque = false;
+        
+        return true;
+    }
+    
+    bool Texture::createTrimmedMeshBuffer(const Image* image)
+    {
+        _trimmedMeshBuffer = nullptr;
+        
+        std::vector<Vector2> hull;
+        
+        if (!image->getAlphaHull(hull))
+        {
+            return true;
+        }
+        
+        float area = 0.0f;
+        
+        for (size_t i = 0; i < hull.size(); ++i)
+        {
+            const Vector2& a = hull[i];
+            const Vector2& b = hull[(i + 1) % hull.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        
+        area /= 2.0f;
+        
+        // a few saved pixels are not worth the extra triangles
+        if (fabsf(area) > _size.width * _size.height * 0.85f)
+        {
+            return true;
+        }
+        
+        // y goes up in the mesh, so the winding flips
+        if (area > 0.0f)
+        {
+            std::reverse(hull.begin(), hull.end());
+        }
+        
+        std::vector<uint16_t> indices;
+        std::vector<Vertex> vertices;
+        
+        for (const Vector2& point : hull)
+        {
+            vertices.push_back(Vertex(Vector3(point.x / _size.width - 0.5f, 0.5f - point.y / _size.height, -20.0f), Color(0xFF, 0xFF, 0xFF, 0xFF),
+                                      Vector2(point.x / _size.width, point.y / _size.height)));
+        }
+        
+        for (uint16_t i = 1; i + 1 < static_cast<uint16_t>(hull.size()); ++i)
+        {
+            indices.push_back(0);
+            indices.push_back(i);
+            indices.push_back(i + 1);
+        }
+        
+        _trimmedMeshBuffer = _renderer->createMeshBuffer(indices, vertices);
+        
+        return _trimmedMeshBuffer != nullptr;
+    }
 }
@@ -7,6 +7,9 @@
 #include "Noncopyable.h"
 #include "ReferenceCounted.h"
 #include "Size2.h"
+#include "AutoPtr.h"
+#include "MeshBuffer.h"
+#include "Image.h"
 
 namespace ouzel
 {
@@ -19,15 +22,72 @@ namespace ouzel
         virtual ~Texture();
         
         virtual bool initFromFile(const std::string& filename);
+        // image that was already loaded with Image::loadFromFile, for example on a worker thread,
+        // the texture keeps it if it is streamed
+        bool initFromFile(Image* image);
+        virtual bool initFromImage(const Image* image);
+        // RGBA8 pixels without mipmaps, data can be null for textures that are rendered to
+        virtual bool initFromData(const void* data, const Size2& size, bool renderTarget = false);
         
         const std::string& getFilename() const { return _filename; }
         
+        // loads the file again into the same texture, the current contents stay if the file can't be loaded
+        virtual bool reload();
+        
         const Size2& getSize() const { return _size; }
         
+        // none of the pixels is translucent, so it can be drawn without blending
+        bool isOpaque() const { return _opaque; }
+        
+        // mesh covering only the visible pixels, in the same unit space as the renderer's quad, null if trimming is disabled or does not pay off
+        MeshBuffer* getTrimmedMeshBuffer() const { return _trimmedMeshBuffer; }
+        
+        uint64_t getMemorySize() const { return _memorySize; }
+        
+        // incremented when the texture is reloaded, its size and trimmed mesh can change
+        uint32_t getVersion() const { return _version; }
+        
+        uint32_t getLastUsedFrame() const { return _lastUsedFrame; }
+        void setLastUsedFrame(uint32_t frame) { _lastUsedFrame = frame; }
+        
+        // frames a streamed texture keeps mip levels that are finer than needed
+        static const uint32_t STREAMING_DEMOTE_DELAY = 120;
+        
+        // streamed textures upload only the mip levels that are needed for the size they are drawn at
+        bool isStreamed() const { return _image.item != nullptr; }
+        // level of the image's mip chain that is the largest one on the GPU
+        uint32_t getResidentLevel() const { return _residentLevel; }
+        // called by the renderer when the texture is activated, draws without a requested scale need the largest level
+        void markDrawn() { if (_image.item) ++_draws; }
+        // called when the texture is drawn, scale is the number of screen pixels per texel
+        void requestScale(float scale);
+        // uploads the finer levels requested in the last frame right away and drops the unneeded ones after the delay,
+        // returns true if the resident levels changed
+        bool updateStreaming();
+        
     protected:
+        bool createTrimmedMeshBuffer(const Image* image);
+        // creates the texture from the mip levels of the image starting at firstLevel
+        virtual bool uploadImage(const Image* image, uint32_t firstLevel);
+        static uint64_t getMipmapMemorySize(const Image* image, uint32_t firstLevel, uint32_t pixelSize);
+        
         Renderer* _renderer;
         std::string _filename;
         
         Size2 _size;
+        bool _opaque = false;
+        uint64_t _memorySize = 0;
+        uint32_t _lastUsedFrame = 0;
+        uint32_t _fileWatchId = 0;
+        uint32_t _version = 0;
+        
+        AutoPtr<MeshBuffer> _trimmedMeshBuffer;
+        
+        AutoPtr<Image> _image;
+        uint32_t _residentLevel = 0;
+        uint32_t _requestedLevel = 0xFFFFFFFF;
+        uint32_t _draws = 0;
+        uint32_t _scaledDraws = 0;
+        uint32_t _demoteFrames = 0;
     };
 }
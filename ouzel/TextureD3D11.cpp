@@ -1,6 +1,8 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <cstring>
+#include <vector>
 #include "TextureD3D11.h"
 #include "RendererD3D11.h"
 #include "Image.h"
@@ -8,6 +10,117 @@
 
 namespace ouzel
 {
+    static uint8_t expandBits(uint32_t value, uint32_t bits)
+    {
+        return static_cast<uint8_t>(value * 255 / ((1 << bits) - 1));
+    }
+
+    // Direct3D 11 can not swizzle, so A8 and L8 are always expanded, like the 16-bit formats on devices that don't support them
+    static void expandToRGBA8(const Image* image, uint32_t level, std::vector<uint8_t>& pixels)
+    {
+        size_t pixelCount = static_cast<size_t>(image->getMipmapSize(level).width) * static_cast<size_t>(image->getMipmapSize(level).height);
+        const uint8_t* bytes = image->getMipmapData(level);
+        const uint16_t* shorts = reinterpret_cast<const uint16_t*>(image->getMipmapData(level));
+
+        pixels.resize(pixelCount * 4);
+
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            uint8_t* pixel = &pixels[i * 4];
+
+            switch (image->getPixelFormat())
+            {
+                case PixelFormat::RGB565:
+                    pixel[0] = expandBits(shorts[i] >> 11, 5);
+                    pixel[1] = expandBits((shorts[i] >> 5) & 0x3F, 6);
+                    pixel[2] = expandBits(shorts[i] & 0x1F, 5);
+                    pixel[3] = 0xFF;
+                    break;
+                case PixelFormat::RGBA4444:
+                    pixel[0] = expandBits(shorts[i] >> 12, 4);
+                    pixel[1] = expandBits((shorts[i] >> 8) & 0x0F, 4);
+                    pixel[2] = expandBits((shorts[i] >> 4) & 0x0F, 4);
+                    pixel[3] = expandBits(shorts[i] & 0x0F, 4);
+                    break;
+                case PixelFormat::RGBA5551:
+                    pixel[0] = expandBits(shorts[i] >> 11, 5);
+                    pixel[1] = expandBits((shorts[i] >> 6) & 0x1F, 5);
+                    pixel[2] = expandBits((shorts[i] >> 1) & 0x1F, 5);
+                    pixel[3] = (shorts[i] & 0x01) ? 0xFF : 0x00;
+                    break;
+                case PixelFormat::A8:
+                    pixel[0] = pixel[1] = pixel[2] = 0xFF;
+                    pixel[3] = bytes[i];
+                    break;
+                case PixelFormat::L8:
+                    pixel[0] = pixel[1] = pixel[2] = bytes[i];
+                    pixel[3] = 0xFF;
+                    break;
+                default:
+                    memcpy(pixel, &bytes[i * 4], 4);
+                    break;
+            }
+        }
+    }
+
+    // DXGI formats list the channels from the lowest bits, so alpha moves from the lowest bits to the highest
+    static void getTextureData(ID3D11Device* device, const Image* image, uint32_t level, DXGI_FORMAT& format, uint32_t& pixelSize, std::vector<uint8_t>& pixels)
+    {
+        size_t pixelCount = static_cast<size_t>(image->getMipmapSize(level).width) * static_cast<size_t>(image->getMipmapSize(level).height);
+        const uint8_t* bytes = image->getMipmapData(level);
+        const uint16_t* shorts = reinterpret_cast<const uint16_t*>(bytes);
+
+        switch (image->getPixelFormat())
+        {
+            case PixelFormat::RGBA8: format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+            case PixelFormat::RGB565: format = DXGI_FORMAT_B5G6R5_UNORM; break;
+            case PixelFormat::RGBA4444: format = DXGI_FORMAT_B4G4R4A4_UNORM; break;
+            case PixelFormat::RGBA5551: format = DXGI_FORMAT_B5G5R5A1_UNORM; break;
+            default: format = DXGI_FORMAT_UNKNOWN; break;
+        }
+
+        UINT support = 0;
+
+        if (format == DXGI_FORMAT_UNKNOWN ||
+            FAILED(device->CheckFormatSupport(format, &support)) ||
+            !(support & D3D11_FORMAT_SUPPORT_TEXTURE2D))
+        {
+            format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            pixelSize = 4;
+            expandToRGBA8(image, level, pixels);
+            return;
+        }
+
+        pixelSize = getPixelSize(image->getPixelFormat());
+
+        if (image->getPixelFormat() == PixelFormat::RGBA4444)
+        {
+            std::vector<uint16_t> repacked(pixelCount);
+
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                repacked[i] = static_cast<uint16_t>((shorts[i] >> 4) | ((shorts[i] & 0x0F) << 12));
+            }
+
+            pixels.assign(reinterpret_cast<const uint8_t*>(repacked.data()), reinterpret_cast<const uint8_t*>(repacked.data() + pixelCount));
+        }
+        else if (image->getPixelFormat() == PixelFormat::RGBA5551)
+        {
+            std::vector<uint16_t> repacked(pixelCount);
+
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                repacked[i] = static_cast<uint16_t>((shorts[i] >> 1) | ((shorts[i] & 0x01) << 15));
+            }
+
+            pixels.assign(reinterpret_cast<const uint8_t*>(repacked.data()), reinterpret_cast<const uint8_t*>(repacked.data() + pixelCount));
+        }
+        else
+        {
+            pixels.assign(bytes, bytes + pixelCount * pixelSize);
+        }
+    }
+
     TextureD3D11::TextureD3D11(Renderer* renderer):
         Texture(renderer)
     {
@@ -16,25 +129,88 @@ namespace ouzel
     
     TextureD3D11::~TextureD3D11()
     {
-        
+        destroy();
     }
 
-    bool TextureD3D11::initFromFile(const std::string& filename)
+    void TextureD3D11::destroy()
     {
-        if (!Texture::initFromFile(filename))
+        if (_resourceView)
+        {
+            _resourceView->Release();
+            _resourceView = nullptr;
+        }
+
+        if (_texture)
         {
+            _texture->Release();
+            _texture = nullptr;
+        }
+    }
+
+    bool TextureD3D11::uploadImage(const Image* image, uint32_t firstLevel)
+    {
+        RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
+        int width = (int)image->getMipmapSize(firstLevel).width;
+        int height = (int)image->getMipmapSize(firstLevel).height;
+        uint32_t levelCount = image->getMipmapCount() - firstLevel;
+
+        D3D11_TEXTURE2D_DESC textureDesc;
+        memset(&textureDesc, 0, sizeof(textureDesc));
+        textureDesc.Width = width;
+        textureDesc.Height = height;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t pixelSize = 0;
+        std::vector<std::vector<uint8_t>> levelPixels(levelCount);
+        std::vector<D3D11_SUBRESOURCE_DATA> initialData(levelCount);
+
+        for (uint32_t i = 0; i < levelCount; ++i)
+        {
+            getTextureData(rendererD3D11->getDevice(), image, firstLevel + i, format, pixelSize, levelPixels[i]);
+            initialData[i].pSysMem = levelPixels[i].data();
+            initialData[i].SysMemPitch = (UINT)image->getMipmapSize(firstLevel + i).width * pixelSize;
+            initialData[i].SysMemSlicePitch = 0;
+        }
+
+        textureDesc.MipLevels = levelCount;
+        textureDesc.ArraySize = 1;
+        textureDesc.Format = format;
+        textureDesc.Usage = D3D11_USAGE_DEFAULT;
+        textureDesc.CPUAccessFlags = 0;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+        // reloading and streaming replace the previous texture
+        destroy();
+
+        HRESULT hr = rendererD3D11->getDevice()->CreateTexture2D(&textureDesc, initialData.data(), &_texture);
+        if (FAILED(hr) || !_texture)
+        {
+            log("Could not create D3D11 texture (type=2D, width=%d, height=%d, name=%s)", width, height, _filename.c_str());
+            return false;
+        }
+
+        hr = rendererD3D11->getDevice()->CreateShaderResourceView(_texture, NULL, &_resourceView);
+        if (FAILED(hr) || !_resourceView)
+        {
+            log("Could not create D3D11 shader resource view (type=2D, width=%d, height=%d, name=%s)", width, height, _filename.c_str());
             return false;
         }
 
-        AutoPtr<Image> image = new Image(_renderer->getEngine());
-        if (!image->loadFromFile(filename))
+        _memorySize = getMipmapMemorySize(image, firstLevel, pixelSize);
+
+        return true;
+    }
+
+    bool TextureD3D11::initFromData(const void* data, const Size2& size, bool renderTarget)
+    {
+        if (!Texture::initFromData(data, size, renderTarget))
         {
             return false;
         }
 
         RendererD3D11* rendererD3D11 = static_cast<RendererD3D11*>(_renderer);
-        int width = (int)image->getSize().width;
-        int height = (int)image->getSize().height;
+        int width = (int)size.width;
+        int height = (int)size.height;
 
         D3D11_TEXTURE2D_DESC textureDesc;
         memset(&textureDesc, 0, sizeof(textureDesc));
@@ -46,24 +222,26 @@ namespace ouzel
         textureDesc.Usage = D3D11_USAGE_DEFAULT;
         textureDesc.CPUAccessFlags = 0;
         textureDesc.SampleDesc.Count = 1;
-        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (renderTarget ? D3D11_BIND_RENDER_TARGET : 0);
+
+        destroy();
 
-        D3D11_SUBRESOURCE_DATA initialData = { image->getData(), (UINT)width * 4 };
-        HRESULT hr = rendererD3D11->getDevice()->CreateTexture2D(&textureDesc, &initialData, &_texture);
+        D3D11_SUBRESOURCE_DATA initialData = { data, (UINT)width * 4 };
+        HRESULT hr = rendererD3D11->getDevice()->CreateTexture2D(&textureDesc, data ? &initialData : nullptr, &_texture);
         if (FAILED(hr) || !_texture)
         {
-            log("Could not create D3D11 texture (type=2D, width=%d, height=%d, name=%s)", width, height, filename.c_str());
+            log("Could not create D3D11 texture (type=2D, width=%d, height=%d)", width, height);
             return false;
         }
 
         hr = rendererD3D11->getDevice()->CreateShaderResourceView(_texture, NULL, &_resourceView);
         if (FAILED(hr) || !_resourceView)
         {
-            log("Could not create D3D11 shader resource view (type=2D, width=%d, height=%d, name=%s)", width, height, filename.c_str());
+            log("Could not create D3D11 shader resource view (type=2D, width=%d, height=%d)", width, height);
             return false;
         }
 
-        _size = image->getSize();
+        _memorySize = static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
 
         return true;
     }
@@ -14,13 +14,16 @@ namespace ouzel
         TextureD3D11(Renderer* renderer);
         virtual ~TextureD3D11();
 
-        virtual bool initFromFile(const std::string& filename) override;
+        virtual bool initFromData(const void* data, const Size2& size, bool renderTarget = false) override;
 
         ID3D11Texture2D* getTexture() const { return _texture; }
         ID3D11ShaderResourceView* getResourceView() const { return _resourceView; }
 
     protected:
-        ID3D11Texture2D* _texture;
-        ID3D11ShaderResourceView* _resourceView;
+        virtual bool uploadImage(const Image* image, uint32_t firstLevel) override;
+        void destroy();
+
+        ID3D11Texture2D* _texture = nullptr;
+        ID3D11ShaderResourceView* _resourceView = nullptr;
     };
 }
@@ -9,6 +9,78 @@
 
 namespace ouzel
 {
+    static bool getPixelFormat(PixelFormat pixelFormat, GLint& internalFormat, GLenum& format, GLenum& type)
+    {
+        switch (pixelFormat)
+        {
+            case PixelFormat::RGBA8:
+                internalFormat = GL_RGBA;
+                format = GL_RGBA;
+                type = GL_UNSIGNED_BYTE;
+                return true;
+            case PixelFormat::RGB565:
+                // core profile 3.2 has no sized 16-bit RGB format, so the driver stores it with 8 bits per channel
+                internalFormat = GL_RGB;
+                format = GL_RGB;
+                type = GL_UNSIGNED_SHORT_5_6_5;
+                return true;
+            case PixelFormat::RGBA4444:
+#if defined(OUZEL_PLATFORM_OSX)
+                // sized, so that the driver does not store it with 8 bits per channel
+                internalFormat = GL_RGBA4;
+#else
+                internalFormat = GL_RGBA;
+#endif
+                format = GL_RGBA;
+                type = GL_UNSIGNED_SHORT_4_4_4_4;
+                return true;
+            case PixelFormat::RGBA5551:
+#if defined(OUZEL_PLATFORM_OSX)
+                internalFormat = GL_RGB5_A1;
+#else
+                internalFormat = GL_RGBA;
+#endif
+                format = GL_RGBA;
+                type = GL_UNSIGNED_SHORT_5_5_5_1;
+                return true;
+#if defined(OUZEL_PLATFORM_IOS)
+            case PixelFormat::A8:
+                internalFormat = GL_ALPHA;
+                format = GL_ALPHA;
+                type = GL_UNSIGNED_BYTE;
+                return true;
+            case PixelFormat::L8:
+                internalFormat = GL_LUMINANCE;
+                format = GL_LUMINANCE;
+                type = GL_UNSIGNED_BYTE;
+                return true;
+#else
+            case PixelFormat::A8:
+            case PixelFormat::L8:
+                internalFormat = GL_R8;
+                format = GL_RED;
+                type = GL_UNSIGNED_BYTE;
+                return true;
+#endif
+        }
+        
+        return false;
+    }
+    
+    // bytes per pixel in the video memory, which can differ from the size of the uploaded pixels
+    static uint32_t getStoredPixelSize(PixelFormat pixelFormat)
+    {
+#if defined(OUZEL_PLATFORM_OSX)
+        // RGB8 is padded to 32 bits
+        if (pixelFormat == PixelFormat::RGB565)
+        {
+            return 4;
+        }
+#endif
+        
+        return getPixelSize(pixelFormat);
+    }
+    
     TextureOGL::TextureOGL(Renderer* renderer):
         Texture(renderer)
     {
@@ -16,49 +88,124 @@ namespace ouzel
     }
     
     TextureOGL::~TextureOGL()
+    {
+        destroy();
+    }
+    
+    void TextureOGL::destroy()
     {
         if (_textureId)
         {
             glDeleteTextures(1, &_textureId);
+            _textureId = 0;
         }
     }
     
-    bool TextureOGL::initFromFile(const std::string& filename)
+    bool TextureOGL::uploadImage(const Image* image, uint32_t firstLevel)
     {
-        if (!Texture::initFromFile(filename))
+        // reloading and streaming replace the previous texture
+        destroy();
+        
+        glGenTextures(1, &_textureId);
+        
+        glBindTexture(GL_TEXTURE_2D, _textureId);
+        
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+        
+        if (!getPixelFormat(image->getPixelFormat(), internalFormat, format, type))
         {
+            log("Unsupported pixel format of texture %s", _filename.c_str());
             return false;
         }
         
-        AutoPtr<Image> image = new Image(_renderer->getEngine());
-        if (!image->loadFromFile(filename))
+        // rows of the smaller formats are not padded to 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        
+        for (uint32_t level = firstLevel; level < image->getMipmapCount(); ++level)
+        {
+            const Size2& size = image->getMipmapSize(level);
+            
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level - firstLevel), internalFormat, size.width, size.height,
+                         0, format, type, image->getMipmapData(level));
+        }
+        
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        
+        if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
         {
             return false;
         }
         
-        glGenTextures(1, &_textureId);
+#if defined(OUZEL_PLATFORM_OSX)
+        // core profile has no alpha and luminance formats, the red channel is swizzled instead
+        if (image->getPixelFormat() == PixelFormat::A8)
+        {
+            GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+        else if (image->getPixelFormat() == PixelFormat::L8)
+        {
+            GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+#endif
         
-        glBindTexture(GL_TEXTURE_2D, _textureId);
+        bool mipmaps = firstLevel + 1 < image->getMipmapCount();
         
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->getSize().width, image->getSize().height,
-                     0, GL_RGBA, GL_UNSIGNED_BYTE, image->getData());
+#if defined(OUZEL_PLATFORM_IOS)
+        // OpenGL ES 2 can sample mipmaps only of power of two textures
+        const Size2& size = image->getMipmapSize(firstLevel);
+        uint32_t width = static_cast<uint32_t>(size.width);
+        uint32_t height = static_cast<uint32_t>(size.height);
         
-        if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
+        if ((width & (width - 1)) != 0 || (height & (height - 1)) != 0)
         {
-            return false;
+            mipmaps = false;
         }
+#endif
         
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         
-        //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-        //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        
+        if (static_cast<RendererOGL*>(_renderer)->checkOpenGLErrors())
+        {
+            return false;
+        }
+        
+        _memorySize = getMipmapMemorySize(image, firstLevel, getStoredPixelSize(image->getPixelFormat()));
+        
+        return true;
+    }
+    
+    bool TextureOGL::initFromData(const void* data, const Size2& size, bool renderTarget)
+    {
+        if (!Texture::initFromData(data, size, renderTarget))
+        {
+            return false;
+        }
+        
+        destroy();
+        
+        glGenTextures(1, &_textureId);
+        
+        glBindTexture(GL_TEXTURE_2D, _textureId);
+        
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.width, size.height,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
         glBindTexture(GL_TEXTURE_2D, 0);
         
@@ -67,7 +214,7 @@ namespace ouzel
             return false;
         }
         
-        _size = image->getSize();
+        _memorySize = static_cast<uint64_t>(_size.width) * static_cast<uint64_t>(_size.height) * 4;
         
         return true;
     }
@@ -22,11 +22,14 @@ namespace ouzel
         TextureOGL(Renderer* renderer);
         virtual ~TextureOGL();
         
-        virtual bool initFromFile(const std::string& filename) override;
+        virtual bool initFromData(const void* data, const Size2& size, bool renderTarget = false) override;
         
         GLuint getTextureId() const { return _textureId; }
         
     protected:
+        virtual bool uploadImage(const Image* image, uint32_t firstLevel) override;
+        void destroy();
+        
         GLuint _textureId = 0;
     };
 }
@@ -0,0 +1,72 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace ouzel
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            // hardware_concurrency returns 0 if it is not known
+            threadCount = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+        }
+        
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            _threads.push_back(std::thread(&ThreadPool::work, this));
+        }
+    }
+    
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        
+        _condition.notify_all();
+        
+        // the queued tasks are finished before the threads exit
+        for (std::thread& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+    
+    void ThreadPool::enqueue(const std::function<void()>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push(task);
+        }
+        
+        _condition.notify_one();
+    }
+    
+    void ThreadPool::work()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                
+                _condition.wait(lock, [this] { return !_running || !_tasks.empty(); });
+                
+                if (_tasks.empty())
+                {
+                    return;
+                }
+                
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+            
+            task();
+        }
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Noncopyable.h"
+#include "ReferenceCounted.h"
+
+namespace ouzel
+{
+    // worker threads for blocking and long running work, tasks must not touch the scene or the renderer
+    class ThreadPool: public Noncopyable, public ReferenceCounted
+    {
+    public:
+        // 0 uses one thread per hardware thread, except the one running the engine
+        ThreadPool(uint32_t threadCount = 0);
+        virtual ~ThreadPool();
+        
+        void enqueue(const std::function<void()>& task);
+        
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(_threads.size()); }
+        
+    protected:
+        void work();
+        
+        std::vector<std::thread> _threads;
+        
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::queue<std::function<void()>> _tasks;
+        bool _running = true;
+    };
+}
@@ -0,0 +1,406 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/document.h>
+#include "TileMap.h"
+#include "CompileConfig.h"
+#include "Engine.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "Shader.h"
+#include "FileSystem.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Utils.h"
+
+namespace ouzel
+{
+    // Tiled stores the flip flags in the upper bits of the tile id
+    const uint32_t TILE_ID_MASK = 0x1FFFFFFF;
+    
+    // tiles are always white and flat, so they need half of the size of Vertex,
+    // the missing z of the position is 0 and the draw depth comes from the depth range anyway
+    struct TileVertex
+    {
+        float x;
+        float y;
+        uint16_t u;
+        uint16_t v;
+    };
+    
+    static const VertexFormat& getTileVertexFormat()
+    {
+        static const VertexFormat tileVertexFormat({
+            { VertexUsage::POSITION, VertexAttributeType::FLOAT, 2, 0 },
+            { VertexUsage::TEXCOORD, VertexAttributeType::UNSIGNED_SHORT_NORM, 2, 8 }
+        }, sizeof(TileVertex));
+        
+        return tileVertexFormat;
+    }
+    
+    static uint16_t normalizeTexCoord(float texCoord)
+    {
+        return static_cast<uint16_t>(std::max(0.0f, std::min(1.0f, texCoord)) * 65535.0f + 0.5f);
+    }
+    
+    TileMap::TileMap(Scene* scene):
+        Node(scene)
+    {
+        _engine = _scene->getEngine();
+        
+        setShader(_engine->getRenderer()->getShader(SHADER_TEXTURE));
+    }
+    
+    TileMap::~TileMap()
+    {
+        
+    }
+    
+    bool TileMap::initFromFile(const std::string& filename)
+    {
+        std::vector<uint8_t> fileData;
+        
+        if (!_engine->getFileSystem()->readFile(filename, fileData))
+        {
+            log("Failed to open tile map file %s", filename.c_str());
+            return false;
+        }
+        
+        rapidjson::MemoryStream is(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+        
+        rapidjson::Document document;
+        document.ParseStream<0>(is);
+        
+        if (document.HasParseError() || !document.IsObject() ||
+            !document.HasMember("width") || !document["width"].IsUint() ||
+            !document.HasMember("height") || !document["height"].IsUint() ||
+            !document.HasMember("tilewidth") || !document["tilewidth"].IsNumber() ||
+            !document.HasMember("tileheight") || !document["tileheight"].IsNumber() ||
+            !document.HasMember("layers") || !document["layers"].IsArray() ||
+            !document.HasMember("tilesets"))
+        {
+            log("Invalid tile map file %s", filename.c_str());
+            return false;
+        }
+        
+        const rapidjson::Value& tilesets = document["tilesets"];
+        
+        if (!tilesets.IsArray() || tilesets.Size() == 0)
+        {
+            log("Tile map %s has no tilesets", filename.c_str());
+            return false;
+        }
+        
+        const rapidjson::Value& tileset = *tilesets.Begin();
+        
+        if (!tileset.IsObject() || !tileset.HasMember("image") || !tileset["image"].IsString())
+        {
+            log("Tile map %s uses an image collection tileset, which is not supported", filename.c_str());
+            return false;
+        }
+        
+        if ((tileset.HasMember("firstgid") && !tileset["firstgid"].IsUint()) ||
+            (tileset.HasMember("margin") && !tileset["margin"].IsUint()) ||
+            (tileset.HasMember("spacing") && !tileset["spacing"].IsUint()))
+        {
+            log("Invalid tileset in tile map %s", filename.c_str());
+            return false;
+        }
+        
+        uint32_t firstId = tileset.HasMember("firstgid") ? tileset["firstgid"].GetUint() : 1;
+        uint32_t margin = tileset.HasMember("margin") ? tileset["margin"].GetUint() : 0;
+        uint32_t spacing = tileset.HasMember("spacing") ? tileset["spacing"].GetUint() : 0;
+        
+        Size2 tileSize(static_cast<float>(document["tilewidth"].GetDouble()), static_cast<float>(document["tileheight"].GetDouble()));
+        
+        uint32_t width = document["width"].GetUint();
+        uint32_t height = document["height"].GetUint();
+        
+        const rapidjson::Value& layers = document["layers"];
+        const rapidjson::Value* tileLayer = nullptr;
+        
+        for (rapidjson::Value::ConstValueIterator i = layers.Begin(); i != layers.End(); ++i)
+        {
+            if (i->IsObject() && i->HasMember("data") &&
+                (!i->HasMember("type") || ((*i)["type"].IsString() && strcmp((*i)["type"].GetString(), "tilelayer") == 0)))
+            {
+                tileLayer = &(*i);
+                break;
+            }
+        }
+        
+        if (!tileLayer)
+        {
+            log("Tile map %s has no tile layers", filename.c_str());
+            return false;
+        }
+        
+        const rapidjson::Value& data = (*tileLayer)["data"];
+        
+        if (!data.IsArray() || static_cast<uint64_t>(data.Size()) != static_cast<uint64_t>(width) * height)
+        {
+            log("Tile layer data of %s must be an uncompressed array of %u tiles", filename.c_str(), width * height);
+            return false;
+        }
+        
+        std::vector<uint32_t> tiles(width * height);
+        
+        for (rapidjson::SizeType i = 0; i < data.Size(); ++i)
+        {
+            if (!data[i].IsUint())
+            {
+                log("Invalid tile in tile map %s", filename.c_str());
+                return false;
+            }
+            
+            uint32_t tileId = data[i].GetUint() & TILE_ID_MASK;
+            tiles[i] = (tileId >= firstId) ? tileId - firstId + 1 : 0;
+        }
+        
+        Texture* texture = _engine->getRenderer()->getTexture(tileset["image"].GetString());
+        
+        if (!texture)
+        {
+            return false;
+        }
+        
+        return init(texture, tileSize, width, height, tiles, margin, spacing);
+    }
+    
+    bool TileMap::init(Texture* texture, const Size2& tileSize, uint32_t width, uint32_t height, const std::vector<uint32_t>& tiles,
+                       uint32_t margin, uint32_t spacing)
+    {
+        if (!texture || static_cast<uint64_t>(tiles.size()) != static_cast<uint64_t>(width) * height ||
+            tileSize.width <= 0.0f || tileSize.height <= 0.0f)
+        {
+            log("Invalid tile map size or tileset");
+            return false;
+        }
+        
+        float columns = floorf((texture->getSize().width - margin * 2.0f + spacing) / (tileSize.width + spacing));
+        
+        if (columns < 1.0f)
+        {
+            log("Tileset texture %s is too narrow for one tile", texture->getFilename().c_str());
+            return false;
+        }
+        
+        _texture = texture;
+        _tileSize = tileSize;
+        _margin = margin;
+        _spacing = spacing;
+        _columns = static_cast<uint32_t>(columns);
+        
+        _width = width;
+        _height = height;
+        _tiles = tiles;
+        
+        _chunkColumns = (_width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        _chunkRows = (_height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        
+        _chunks.clear();
+        _chunks.resize(_chunkColumns * _chunkRows);
+        
+        _boundingBox.set(0.0f, 0.0f, _width * _tileSize.width, _height * _tileSize.height);
+        
+        markDirty();
+        
+        return true;
+    }
+    
+    bool TileMap::isOpaque() const
+    {
+        return _texture && _texture->isOpaque();
+    }
+    
+    uint32_t TileMap::getTile(uint32_t x, uint32_t y) const
+    {
+        if (x >= _width || y >= _height)
+        {
+            return 0;
+        }
+        
+        return _tiles[y * _width + x];
+    }
+    
+    void TileMap::setTile(uint32_t x, uint32_t y, uint32_t tile)
+    {
+        if (x >= _width || y >= _height)
+        {
+            return;
+        }
+        
+        uint32_t& current = _tiles[y * _width + x];
+        
+        if (current != tile)
+        {
+            current = tile;
+            _chunks[(y / CHUNK_SIZE) * _chunkColumns + x / CHUNK_SIZE].dirty = true;
+            
+            markDirty(Rectangle(x * _tileSize.width, (_height - y - 1) * _tileSize.height, _tileSize.width, _tileSize.height));
+        }
+    }
+    
+    void TileMap::setShader(Shader* shader)
+    {
+        _shader = shader;
+        
+        if (_shader)
+        {
+#ifdef OUZEL_PLATFORM_WINDOWS
+            _uniModelViewProj = 0;
+#else
+            _uniModelViewProj = _shader->getVertexShaderConstantId("modelViewProj");
+#endif
+        }
+    }
+    
+    bool TileMap::buildChunk(uint32_t chunkX, uint32_t chunkY)
+    {
+        Chunk& chunk = _chunks[chunkY * _chunkColumns + chunkX];
+        chunk.dirty = false;
+        chunk.meshBuffer = nullptr;
+        
+        std::vector<uint16_t> indices;
+        std::vector<TileVertex> vertices;
+        
+        const Size2& textureSize = _texture->getSize();
+        
+        uint32_t endX = std::min(_width, (chunkX + 1) * CHUNK_SIZE);
+        uint32_t endY = std::min(_height, (chunkY + 1) * CHUNK_SIZE);
+        
+        for (uint32_t y = chunkY * CHUNK_SIZE; y < endY; ++y)
+        {
+            for (uint32_t x = chunkX * CHUNK_SIZE; x < endX; ++x)
+            {
+                uint32_t tile = _tiles[y * _width + x];
+                
+                if (tile == 0)
+                {
+                    continue;
+                }
+                
+                uint32_t tileIndex = tile - 1;
+                float pixelX = static_cast<float>(_margin) + (tileIndex % _columns) * (_tileSize.width + _spacing);
+                float pixelY = static_cast<float>(_margin) + (tileIndex / _columns) * (_tileSize.height + _spacing);
+                
+                uint16_t left = normalizeTexCoord(pixelX / textureSize.width);
+                uint16_t right = normalizeTexCoord((pixelX + _tileSize.width) / textureSize.width);
+                uint16_t top = normalizeTexCoord(pixelY / textureSize.height);
+                uint16_t bottom = normalizeTexCoord((pixelY + _tileSize.height) / textureSize.height);
+                
+                // map rows go from the top down
+                float positionX = x * _tileSize.width;
+                float positionY = (_height - y - 1) * _tileSize.height;
+                
+                uint16_t startIndex = static_cast<uint16_t>(vertices.size());
+                
+                indices.push_back(startIndex + 0);
+                indices.push_back(startIndex + 1);
+                indices.push_back(startIndex + 2);
+                indices.push_back(startIndex + 1);
+                indices.push_back(startIndex + 3);
+                indices.push_back(startIndex + 2);
+                
+                vertices.push_back({ positionX, positionY, left, bottom });
+                vertices.push_back({ positionX + _tileSize.width, positionY, right, bottom });
+                vertices.push_back({ positionX, positionY + _tileSize.height, left, top });
+                vertices.push_back({ positionX + _tileSize.width, positionY + _tileSize.height, right, top });
+            }
+        }
+        
+        if (!indices.empty())
+        {
+            chunk.meshBuffer = _engine->getRenderer()->createMeshBuffer(indices.data(), sizeof(uint16_t), static_cast<uint32_t>(indices.size()),
+                                                                        vertices.data(), getTileVertexFormat(), static_cast<uint32_t>(vertices.size()));
+            
+            if (!chunk.meshBuffer)
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    void TileMap::draw(Camera* camera)
+    {
+        Node::draw(camera);
+        
+        if (!_shader || !_texture || _chunks.empty())
+        {
+            return;
+        }
+        
+        Matrix4 modelViewProj = camera->getViewProjection() * _transform;
+        
+        // find the part of the map that covers the screen, so that only the chunks inside it are visited
+        Matrix4 inverseModelViewProj = modelViewProj;
+        inverseModelViewProj.invert();
+        
+        Vector3 corners[4] = {
+            Vector3(-1.0f, -1.0f, 0.0f),
+            Vector3(1.0f, -1.0f, 0.0f),
+            Vector3(-1.0f, 1.0f, 0.0f),
+            Vector3(1.0f, 1.0f, 0.0f)
+        };
+        
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+        
+        for (Vector3& corner : corners)
+        {
+            inverseModelViewProj.transformPoint(&corner);
+            
+            minX = std::min(minX, corner.x);
+            minY = std::min(minY, corner.y);
+            maxX = std::max(maxX, corner.x);
+            maxY = std::max(maxY, corner.y);
+        }
+        
+        float chunkWidth = CHUNK_SIZE * _tileSize.width;
+        float chunkHeight = CHUNK_SIZE * _tileSize.height;
+        float mapHeight = _height * _tileSize.height;
+        
+        // chunk rows are counted from the top of the map
+        int32_t firstColumn = std::max(0, static_cast<int32_t>(floorf(minX / chunkWidth)));
+        int32_t lastColumn = std::min(static_cast<int32_t>(_chunkColumns) - 1, static_cast<int32_t>(floorf(maxX / chunkWidth)));
+        int32_t firstRow = std::max(0, static_cast<int32_t>(floorf((mapHeight - maxY) / chunkHeight)));
+        int32_t lastRow = std::min(static_cast<int32_t>(_chunkRows) - 1, static_cast<int32_t>(floorf((mapHeight - minY) / chunkHeight)));
+        
+        if (firstColumn > lastColumn || firstRow > lastRow)
+        {
+            return;
+        }
+        
+        _engine->getRenderer()->activateTexture(_texture, 0);
+        _engine->getRenderer()->activateShader(_shader);
+        
+        _shader->setVertexShaderConstant(_uniModelViewProj, &modelViewProj, 1);
+        
+        for (int32_t chunkY = firstRow; chunkY <= lastRow; ++chunkY)
+        {
+            for (int32_t chunkX = firstColumn; chunkX <= lastColumn; ++chunkX)
+            {
+                Chunk& chunk = _chunks[chunkY * _chunkColumns + chunkX];
+                
+                if (chunk.dirty && !buildChunk(chunkX, chunkY))
+                {
+                    continue;
+                }
+                
+                if (chunk.meshBuffer)
+                {
+                    _engine->getRenderer()->drawMeshBuffer(chunk.meshBuffer);
+                }
+            }
+        }
+    }
+}
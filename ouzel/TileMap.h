@@ -0,0 +1,80 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "AutoPtr.h"
+#include "Node.h"
+#include "Size2.h"
+#include "MeshBuffer.h"
+
+namespace ouzel
+{
+    class Engine;
+    class Scene;
+    class Texture;
+    class Shader;
+    
+    class TileMap: public Node
+    {
+    public:
+        static const uint32_t CHUNK_SIZE = 16;
+        
+        TileMap(Scene* scene);
+        virtual ~TileMap();
+        
+        // loads the first tile layer and tileset of a map exported from Tiled in JSON format
+        virtual bool initFromFile(const std::string& filename);
+        
+        // tiles are stored row by row starting from the top, 0 is an empty tile and n is the n-th tile of the tileset
+        virtual bool init(Texture* texture, const Size2& tileSize, uint32_t width, uint32_t height, const std::vector<uint32_t>& tiles,
+                          uint32_t margin = 0, uint32_t spacing = 0);
+        
+        virtual void draw(Camera* camera) override;
+        
+        virtual bool isOpaque() const override;
+        
+        uint32_t getWidth() const { return _width; }
+        uint32_t getHeight() const { return _height; }
+        const Size2& getTileSize() const { return _tileSize; }
+        
+        uint32_t getTile(uint32_t x, uint32_t y) const;
+        void setTile(uint32_t x, uint32_t y, uint32_t tile);
+        
+        Texture* getTexture() const { return _texture; }
+        
+        Shader* getShader() const { return _shader; }
+        void setShader(Shader* shader);
+        
+    protected:
+        struct Chunk
+        {
+            AutoPtr<MeshBuffer> meshBuffer;
+            bool dirty = true;
+        };
+        
+        bool buildChunk(uint32_t chunkX, uint32_t chunkY);
+        
+        Engine* _engine;
+        
+        AutoPtr<Texture> _texture;
+        AutoPtr<Shader> _shader;
+        
+        uint32_t _uniModelViewProj = 0;
+        
+        Size2 _tileSize;
+        uint32_t _margin = 0;
+        uint32_t _spacing = 0;
+        uint32_t _columns = 0;
+        
+        uint32_t _width = 0;
+        uint32_t _height = 0;
+        std::vector<uint32_t> _tiles;
+        
+        uint32_t _chunkColumns = 0;
+        uint32_t _chunkRows = 0;
+        std::vector<Chunk> _chunks;
+    };
+}
@@ -1,12 +1,9 @@
 // Copyright (C) 2015 Elviss Strazdins
 // This file is part of the Ouzel engine.
 
+#include <chrono>
 #include "CompileConfig.h"
 
-#ifdef OUZEL_PLATFORM_OSX
-#include <sys/time.h>
-#endif
-
 #if defined(OUZEL_PLATFORM_IOS) || defined(OUZEL_PLATFORM_TVOS)
 #include <sys/syslog.h>
 #endif
@@ -47,25 +44,9 @@ namespace ouzel
     
     uint64_t getCurrentMicroSeconds()
     {
-#if defined(OUZEL_PLATFORM_OSX)
-        struct timeval currentTime;
+        // steady clock is monotonic, so the time doesn't jump when the system clock is adjusted
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::now().time_since_epoch();
         
-        gettimeofday(&currentTime, NULL);
-        return currentTime.tv_sec * 1000000L + currentTime.tv_usec;
-#elif defined(OUZEL_PLATFORM_WINDOWS)
-        LARGE_INTEGER li;
-        if (!QueryPerformanceFrequency(&li))
-        {
-            log("Failed to query frequency");
-            return 0;
-        }
-        uint64_t frequency = li.QuadPart / 1000000L;
-        
-        QueryPerformanceCounter(&li);
-        
-        return li.QuadPart / frequency;
-#else
-        return 0;
-#endif
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time).count());
     }
 }
@@ -0,0 +1,56 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#include "VertexFormat.h"
+#include "Vertex.h"
+
+namespace ouzel
+{
+    VertexFormat::VertexFormat()
+    {
+        
+    }
+    
+    VertexFormat::VertexFormat(const std::vector<VertexAttribute>& attributes, uint32_t stride):
+        _attributes(attributes), _stride(stride)
+    {
+        
+    }
+    
+    const VertexFormat& VertexFormat::getDefault()
+    {
+        static const VertexFormat defaultFormat({
+            { VertexUsage::POSITION, VertexAttributeType::FLOAT, 3, 0 },
+            { VertexUsage::COLOR, VertexAttributeType::UNSIGNED_BYTE_NORM, 4, 12 },
+            { VertexUsage::TEXCOORD, VertexAttributeType::FLOAT, 2, 16 }
+        }, sizeof(Vertex));
+        
+        return defaultFormat;
+    }
+    
+    const VertexAttribute* VertexFormat::getAttribute(VertexUsage usage) const
+    {
+        for (const VertexAttribute& attribute : _attributes)
+        {
+            if (attribute.usage == usage)
+            {
+                return &attribute;
+            }
+        }
+        
+        return nullptr;
+    }
+    
+    uint32_t VertexFormat::getTypeSize(VertexAttributeType type)
+    {
+        switch (type)
+        {
+            case VertexAttributeType::FLOAT: return 4;
+            case VertexAttributeType::UNSIGNED_BYTE_NORM: return 1;
+            case VertexAttributeType::SHORT: return 2;
+            case VertexAttributeType::UNSIGNED_SHORT_NORM: return 2;
+        }
+        
+        return 0;
+    }
+}
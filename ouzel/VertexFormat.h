@@ -0,0 +1,71 @@
+// Copyright (C) 2015 Elviss Strazdins
+// This file is part of the Ouzel engine.
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace ouzel
+{
+    // shader input the attribute is bound to, the OpenGL attribute location is the numeric value
+    enum class VertexUsage
+    {
+        POSITION = 0,
+        COLOR,
+        TEXCOORD
+    };
+    
+    enum class VertexAttributeType
+    {
+        FLOAT,
+        UNSIGNED_BYTE_NORM, // 0..255 mapped to 0..1
+        SHORT, // integer values converted to floats, not supported by Direct3D 11
+        UNSIGNED_SHORT_NORM // 0..65535 mapped to 0..1
+    };
+    
+    struct VertexAttribute
+    {
+        VertexUsage usage;
+        VertexAttributeType type;
+        uint32_t components;
+        uint32_t offset;
+        
+        bool operator == (const VertexAttribute& other) const
+        {
+            return usage == other.usage && type == other.type && components == other.components && offset == other.offset;
+        }
+    };
+    
+    // describes the layout of interleaved vertices, attributes the format does not contain get a white color and zero texture coordinates
+    class VertexFormat
+    {
+    public:
+        VertexFormat();
+        VertexFormat(const std::vector<VertexAttribute>& attributes, uint32_t stride);
+        
+        // the layout of Vertex
+        static const VertexFormat& getDefault();
+        
+        const std::vector<VertexAttribute>& getAttributes() const { return _attributes; }
+        uint32_t getStride() const { return _stride; }
+        
+        const VertexAttribute* getAttribute(VertexUsage usage) const;
+        
+        static uint32_t getTypeSize(VertexAttributeType type);
+        
+        bool operator == (const VertexFormat& other) const
+        {
+            return _stride == other._stride && _attributes == other._attributes;
+        }
+        
+        bool operator != (const VertexFormat& other) const
+        {
+            return !(*this == other);
+        }
+        
+    protected:
+        std::vector<VertexAttribute> _attributes;
+        uint32_t _stride = 0;
+    };
+}
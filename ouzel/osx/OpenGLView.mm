@@ -17,9 +17,15 @@ using namespace ouzel;
         _engine = engine;
         _renderer = _engine->getRenderer();
         
-        NSTimer *updateTimer = [NSTimer timerWithTimeInterval:1.0f/60.0f target:self selector:@selector(idle:) userInfo:nil repeats:YES];
+        // the frame pacer waits for the exact time of the frame, the timer only has to fire often enough
+        float targetFPS = _engine->getFramePacer()->getTargetFPS();
+        NSTimeInterval interval = (targetFPS > 0.0f) ? 1.0 / targetFPS : 0.001;
+        
+        NSTimer *updateTimer = [NSTimer timerWithTimeInterval:interval target:self selector:@selector(idle:) userInfo:nil repeats:YES];
         [[NSRunLoop currentRunLoop] addTimer:updateTimer forMode:NSDefaultRunLoopMode];
         
+        RendererOGL* renderer = static_cast<RendererOGL*>(_renderer);
+        
         // Create pixel format
         NSOpenGLPixelFormatAttribute attributes[] =
         {
@@ -28,11 +34,17 @@ using namespace ouzel;
             NSOpenGLPFAColorSize, 24,
             NSOpenGLPFAAlphaSize, 8,
             NSOpenGLPFADepthSize, 32, // set depth buffer size
+            // keep the back buffer contents only for partial redraws, because it is copied on every swap
+            static_cast<NSOpenGLPixelFormatAttribute>(renderer->hasBackingStore() ? NSOpenGLPFABackingStore : 0),
             0
         };
         
         _pixelFormat = [[NSOpenGLPixelFormat alloc] initWithAttributes:attributes];
         
+        GLint backingStore = 0;
+        [_pixelFormat getValues:&backingStore forAttribute:NSOpenGLPFABackingStore forVirtualScreen:0];
+        renderer->setBackingStore(backingStore != 0);
+        
         // Create OpenGL context
         _openGLContext = [[NSOpenGLContext alloc] initWithFormat:_pixelFormat shareContext:NULL];
         [_openGLContext setView:self];
@@ -82,9 +94,10 @@ using namespace ouzel;
 {
     [_openGLContext makeCurrentContext];
     
-    _engine->run();
-    
-    [_openGLContext flushBuffer];
+    if (_engine->run())
+    {
+        [_openGLContext flushBuffer];
+    }
 }
 
 -(void)setOpenGLContext:(NSOpenGLContext*)context
@@ -121,10 +134,12 @@ using namespace ouzel;
 
 void updateModifiers(NSEvent* theEvent, Event& event)
 {
-    event.keyboardEvent.shiftDown = theEvent.modifierFlags & NSShiftKeyMask;
-    event.keyboardEvent.controlDown = theEvent.modifierFlags & NSControlKeyMask;
-    event.keyboardEvent.commandDown = theEvent.modifierFlags & NSCommandKeyMask;
-    event.keyboardEvent.functionDown = theEvent.modifierFlags & NSFunctionKeyMask;
+    event.modifiers = 0;
+    
+    if (theEvent.modifierFlags & NSShiftKeyMask) event.modifiers |= Event::SHIFT_DOWN;
+    if (theEvent.modifierFlags & NSControlKeyMask) event.modifiers |= Event::CONTROL_DOWN;
+    if (theEvent.modifierFlags & NSCommandKeyMask) event.modifiers |= Event::COMMAND_DOWN;
+    if (theEvent.modifierFlags & NSFunctionKeyMask) event.modifiers |= Event::FUNCTION_DOWN;
 }
 
 
@@ -380,165 +395,152 @@ KeyboardKey convertKeyCode(unsigned short keyCode)
 
 -(void)keyDown:(NSEvent*)theEvent
 {
-    Event event;
-    event.type = Event::Type::KEY_DOWN;
+    Event event(Event::Type::KEY_DOWN);
     event.keyboardEvent.key = convertKeyCode(theEvent.keyCode);
     
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)keyUp:(NSEvent*)theEvent
 {
-    Event event;
-    event.type = Event::Type::KEY_UP;
+    Event event(Event::Type::KEY_UP);
     event.keyboardEvent.key = convertKeyCode(theEvent.keyCode);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)mouseDown:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DOWN;
+    Event event(Event::Type::MOUSE_DOWN);
     event.mouseEvent.button = MouseButton::LEFT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)mouseUp:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_UP;
+    Event event(Event::Type::MOUSE_UP);
     event.mouseEvent.button = MouseButton::LEFT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)rightMouseDown:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DOWN;
+    Event event(Event::Type::MOUSE_DOWN);
     event.mouseEvent.button = MouseButton::RIGHT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)rightMouseUp:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_UP;
+    Event event(Event::Type::MOUSE_UP);
     event.mouseEvent.button = MouseButton::RIGHT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)otherMouseDown:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DOWN;
+    Event event(Event::Type::MOUSE_DOWN);
     event.mouseEvent.button = MouseButton::MIDDLE;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)otherMouseUp:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_UP;
+    Event event(Event::Type::MOUSE_UP);
     event.mouseEvent.button = MouseButton::MIDDLE;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)mouseMoved:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_MOVE;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    Event event(Event::Type::MOUSE_MOVE);
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)mouseDragged:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DRAG;
+    Event event(Event::Type::MOUSE_DRAG);
     event.mouseEvent.button = MouseButton::LEFT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)rightMouseDragged:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DRAG;
+    Event event(Event::Type::MOUSE_DRAG);
     event.mouseEvent.button = MouseButton::RIGHT;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)otherMouseDragged:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_DRAG;
+    Event event(Event::Type::MOUSE_DRAG);
     event.mouseEvent.button = MouseButton::MIDDLE;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    event.mouseEvent.position = Vector2(location.x, location.y);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)scrollWheel:(NSEvent*)theEvent
 {
     NSPoint location = theEvent.locationInWindow;
     
-    Event event;
-    event.type = Event::Type::MOUSE_SCROLL;
-    event.mouseEvent.position = _renderer->absoluteToWorldLocation(Vector2(location.x, location.y));
+    Event event(Event::Type::MOUSE_SCROLL);
+    event.mouseEvent.position = Vector2(location.x, location.y);
     event.mouseEvent.scroll = Vector2(theEvent.scrollingDeltaX, theEvent.scrollingDeltaY);
     updateModifiers(theEvent, event);
     
-    _engine->handleEvent(event);
+    _engine->postEvent(event);
 }
 
 -(void)swipeWithEvent:(NSEvent*)theEvent
@@ -7,6 +7,8 @@
 #include "Engine.h"
 #include "AutoPtr.h"
 #include "ReferenceCounted.h"
+#include "Hash.h"
+#include "Handle.h"
 #include "Renderer.h"
 #include "Matrix3.h"
 #include "Matrix4.h"
@@ -19,7 +21,13 @@
 #include "Node.h"
 #include "Camera.h"
 #include "Sprite.h"
+#include "SpriteSheet.h"
+#include "SpriteAnimator.h"
+#include "TileMap.h"
+#include "TextLabel.h"
+#include "BMFont.h"
 #include "Shader.h"
 #include "Texture.h"
 #include "EventHander.h"
+#include "EventDispatcher.h"
 #include "Utils.h"
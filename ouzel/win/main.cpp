@@ -2,8 +2,11 @@
 // This file is part of the Ouzel engine.
 
 #include <windows.h>
+#include <mmsystem.h>
 #include "../Engine.h"
 
+#pragma comment(lib, "winmm.lib")
+
 int WINAPI WinMain(HINSTANCE hInstance,
     HINSTANCE hPrevInstance,
     LPSTR lpCmdLine,
@@ -12,6 +15,9 @@ int WINAPI WinMain(HINSTANCE hInstance,
     ouzel::Engine engine;
     engine.begin();
 
+    // the default timer resolution of 15.6 ms is too coarse for the frame pacer to sleep
+    timeBeginPeriod(1);
+
     MSG msg;
 
     while (true)
@@ -27,8 +33,23 @@ int WINAPI WinMain(HINSTANCE hInstance,
             break;
         }
 
-        engine.run();
+        // wait for input until the frame is due, the engine spins the last part of the wait
+        uint64_t waitTime = engine.getFramePacer()->getWaitTime();
+
+        if (waitTime >= 1000)
+        {
+            MsgWaitForMultipleObjects(0, NULL, FALSE, static_cast<DWORD>(waitTime / 1000), QS_ALLINPUT);
+            continue;
+        }
+
+        // without a frame rate limit, wait for input instead of spinning when nothing had to be drawn
+        if (!engine.run() && engine.getFramePacer()->getTargetFPS() <= 0.0f)
+        {
+            MsgWaitForMultipleObjects(0, NULL, FALSE, 16, QS_ALLINPUT);
+        }
     }
+
+    timeEndPeriod(1);
     
     return 0;
 }